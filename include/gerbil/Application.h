@@ -29,12 +29,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "global.h"
 #include "FastReader.h"
 #include "FastParser.h"
+#include "MemoryReader.h"
 #include "SequenceSplitter.h"
 #include "SuperWriter.h"
 #include "SuperReader.h"
 #include "KmerHasher.h"
 #include "KmcWriter.h"
 #include "TempFileStatistic.h"
+#include "Telemetry.h"
+#include "QueueMonitor.h"
+#include "PerfCounters.h"
+#include "ProgressReporter.h"
+#include "AutoTuner.h"
+#include "NumaTopology.h"
+#include "HugePages.h"
 
 namespace gerbil {
 
@@ -50,6 +58,7 @@ class Application {
 	int _lowerBound;
 	double erate;                                                //error rate
 	std::vector<std::pair<std::string,uint32>> *listKmer;	     //list of the counted kmer
+	KmcConsumer* _kmcConsumer;					// streams the counted kmer instead of listKmer (optional)
 	bool _skipEstimate;                                           //execute or skip the error estimation
 	uint32_t _k;							// size of k-mers
 	uint8 _m;								// size of minimizers
@@ -58,6 +67,7 @@ class Application {
 	uint8 _superSplitterThreadsNumber;		// number of threads for SuperSplitter
 	uint8 _hasherThreadsNumber;				// number of hash/extract threads
 	std::string _fastFileName;				// filename of fast[a/q] (with path)
+	ReadSource* _readSource;				// in-memory reads instead of _fastFileName (optional)
 	std::string _tempFolderName;			// foldername of temp (with path)
 	std::string _kmcFileName;				// filename of kmc (with path)
 	uint32 _thresholdMin;					// min k-mer counter to store
@@ -70,6 +80,8 @@ class Application {
 	uint _singleStep;						// processes only one step (default: 0 => all steps)
 	bool _leaveBinStat;						// leaves binStatFile
 	bool _histogram;						// prints histogram
+	bool _inMemoryBins;						// keeps bins in memory if they fit (step1 --> step2)
+	bool _overlapSteps;						// starts step2 while the SuperWriter is still writing
 
 	TempFile* _tempFiles;					// bin files (step1 --> step2)
 
@@ -78,6 +90,23 @@ class Application {
 
 	uint64 _memoryUsage1;					// memory usage for step1
 	uint64 _memoryUsage2;					// memory usage for step2
+	uint64 _memoryUsageOverlap;				// memory of step1 which is still in use when step2 starts
+
+	Telemetry _telemetry;					// statistic of all stages
+	std::string _reportFileName;			// filename of JSON report (optional)
+	std::string _timelineFileName;			// filename of queue timeline (optional)
+	uint32 _timelineInterval_ms;			// sampling interval of queue timeline
+	bool _perfCounters;						// measures hardware events of the hot loops
+	std::string _progressFileName;			// progress reports, "-": stderr (optional)
+	uint32 _progressInterval_ms;			// interval of progress reports
+	ProgressReporter _progressReporter;
+	bool _autoTune;							// calibrates the stages and tunes threads and memory
+	AutoTuner _autoTuner;
+	bool _numa;								// pins splitters and hashers to numa nodes
+	THugePages _hugePages;					// page size of hash tables and KMerBundle pools
+	bool _quotientKeys;						// hash tables store quotient keys (KMerQuotient.h)
+	uint32 _counterSize_B;					// size of the counters of the hash tables (1, 2 or 4)
+	bool _prefilter;						// bloom filter in front of the hash tables
 
 	void checkSystem();
 
@@ -86,15 +115,20 @@ class Application {
 	void printParamsInfo();
 
 	void printSummary();
+	void initTelemetry();
 
 	void distributeMemory1(uint32 &frBlocksNumber, uint32 &readBundlesNumber,
 			uint32 &superBundlesNumber, uint64 &superWriterBufferSize);
 	void distributeMemory2(TempFileStatistic* tempFileStatistic,
 			uint32 &superBundlesNumber, uint32 &kmcBundlesNumber,
-			uint64 &maxKmcHashtableSize, uint32 &kMerBundlesNumber);
+			uint64 &maxKmcHashtableSize, uint32 &kMerBundlesNumber,
+			uint32 &prefilterBundlesNumber);
 
 	void saveBinStat();
 	void loadBinStat();
+
+	// superWriter: SuperWriter of step1 which is still writing (overlapping steps)
+	void run2(SuperWriter* superWriter);
 public:
 	Application(	
 			double minProbability,
@@ -116,8 +150,123 @@ public:
 	std::vector<std::pair<std::string,unsigned int>> *getListKmer(){
 		return this->listKmer;
 	}
-	
 
+	// total number of threads (default: 0 => number of cores)
+	void setThreadsNumber(uint8 threadsNumber){
+		this->_threadsNumber = threadsNumber;
+	}
+
+	// size of memory in MB (default: 0 => size of ram - 1 GB)
+	void setMemorySize(uint64 memSize){
+		this->_memSize = memSize;
+	}
+
+	// processes only one step (1 or 2), step2 reads the bins and the binStatFile of step1 from the temp folder
+	void setSingleStep(uint singleStep){
+		this->_singleStep = singleStep;
+	}
+
+	// leaves the binStatFile in the temp folder (to repeat step2)
+	void setLeaveBinStat(bool leaveBinStat){
+		this->_leaveBinStat = leaveBinStat;
+	}
+
+	// registers a consumer which receives the counted k-mers during run2
+	// (listKmer stays empty, the consumer is not owned by the application)
+	void setKmcConsumer(KmcConsumer* consumer){
+		this->_kmcConsumer = consumer;
+	}
+
+	// format of the output (default: of_fasta => listKmer, of_gerbil: binary file kmcFileName
+	// with the chunk index kmcFileName.idx for toFasta, of_none: no output)
+	void setOutputFormat(TOutputFormat outputFormat){
+		this->_outputFormat = outputFormat;
+	}
+
+	// reads the input from memory instead of the fast[a/q] file
+	// (the source is not owned by the application)
+	void setReadSource(ReadSource* readSource){
+		this->_readSource = readSource;
+	}
+
+	// enables/disables in-memory bins (default: enabled, only used if they fit in memory)
+	void setInMemoryBins(bool inMemoryBins){
+		this->_inMemoryBins = inMemoryBins;
+	}
+
+	// enables/disables the overlap of both steps (default: enabled)
+	// bins are passed to step2 as soon as their last SuperBundle is written
+	void setOverlapSteps(bool overlapSteps){
+		this->_overlapSteps = overlapSteps;
+	}
+
+
+	// writes the statistic of all stages as JSON report after process()
+	void setReportFileName(const std::string &reportFileName){
+		this->_reportFileName = reportFileName;
+	}
+
+	// samples occupancy and blocking times of all queues during process() (csv, see QueueMonitor)
+	void setQueueTimeline(const std::string &timelineFileName,
+			const uint32 &interval_ms = QUEUE_MONITOR_INTERVAL_MS){
+		this->_timelineFileName = timelineFileName;
+		this->_timelineInterval_ms = interval_ms;
+	}
+
+	// measures cycles, instructions, LLC misses and branch misses of the hot loops
+	// per thread (perf_event_open), printed with the verbose output of each stage
+	void setPerfCounters(bool perfCounters){
+		this->_perfCounters = perfCounters;
+	}
+
+	// reports done/total work, throughput and ETA of the current step periodically
+	// ("-": a line on stderr, otherwise a JSON status file which is replaced at each report)
+	void setProgressReport(const std::string &progressFileName,
+			const uint32 &interval_ms = PROGRESS_INTERVAL_MS){
+		this->_progressFileName = progressFileName;
+		this->_progressInterval_ms = interval_ms;
+	}
+
+	// measures the throughput of the stages on a small sample before the run and derives
+	// the thread split (if not set), queue depths and the hash table memory from it
+	void setAutoTune(bool autoTune){
+		this->_autoTune = autoTune;
+	}
+
+	// pins splitter i and hasher i of step2 to the same numa node, hash tables and
+	// KMerBundle pools are allocated on the node of their hasher (default: true, no effect on a single node)
+	void setNuma(bool numa){
+		this->_numa = numa;
+	}
+
+	// backs the hash tables and KMerBundle pools of step2 with huge pages (default: hp_none)
+	// hp_1g/hp_2m need reserved pages (vm.nr_hugepages) and fall back to transparent huge pages
+	void setHugePages(THugePages hugePages){
+		this->_hugePages = hugePages;
+	}
+
+	// the hash tables of step2 store each k-mer without the bits given by its position (default: false)
+	// smaller entries, more entries per memory and therefore fewer runs of large bins (KMER_PACKED only)
+	void setQuotientKeys(bool quotientKeys){
+		this->_quotientKeys = quotientKeys;
+	}
+
+	// size of the counters of the hash tables of step2: 1, 2 or 4 bytes (default: 4)
+	// larger counts continue in a small side table, smaller entries hold more k-mers per memory
+	void setCounterSize(uint32 counterSize_B){
+		this->_counterSize_B = counterSize_B;
+	}
+
+	// k-mers enter the hash tables of step2 on their second occurrence (default: false, threshold >= 2 only)
+	// a bloom filter holds the first occurrences, singletons never take a hash table entry
+	void setPrefilter(bool prefilter){
+		this->_prefilter = prefilter;
+	}
+
+	// statistic of all stages (available after process())
+	const Telemetry &getTelemetry() const {
+		return _telemetry;
+	}
 
 	void process();
 	void run1();
@@ -0,0 +1,101 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef AUTOTUNER_H_
+#define AUTOTUNER_H_
+
+#include <string>
+#include <vector>
+
+#include "Telemetry.h"
+#include "Bundle.h"
+
+namespace gerbil {
+
+/*
+ * measures the throughput of the stages on the current machine (single thread, synthetic sample)
+ * and derives the thread split and the queue depths from it
+ * phase one: FastParser and SequenceSplitter (the real components)
+ * phase two: k-mer split (splitSuperMer, as KmerHasher) and cpu::HasherTask with the options of the run
+ */
+class AutoTuner {
+	double _parseRate;          // FastParser: bases / s
+	double _parseBytesRate;     // FastParser: input bytes / s
+	double _scanRate;           // SequenceSplitter: bases / s
+	double _splitRate;          // split of s-mers: k-mers / s
+	double _hashRate;           // hash table fill + extract: k-mers / s
+	double _calibration_s;      // time of the calibration
+
+	std::vector<std::pair<std::string, uint64>> _decisions;
+
+	// splits the s-mers of the sample and counts the k-mers (fills _splitRate, _hashRate)
+	template<uint32_t K, bool NORM>
+	void calibrateHasher(std::vector<SuperBundle*> &superBundles, const uint_cv &thresholdMin,
+			const bool &quotientKeys, const uint32 &counterSize_B, const bool &prefilter, const std::string &tempPath);
+
+public:
+	AutoTuner();
+
+	// runs the calibration (below a second), the hasher options are those of the run (see cpu::HasherTask)
+	void calibrate(const uint32 &k, const uint8 &m, const uint_tfn &tempFilesNumber, const bool &norm,
+			const bool &skipEstimate, const uint_cv &thresholdMin, const bool &quotientKeys,
+			const uint32 &counterSize_B, const bool &prefilter, const std::string &tempPath);
+
+	inline bool isCalibrated() const {
+		return _scanRate > 0 && _hashRate > 0;
+	}
+
+	/*
+	 * splits the threads of both phases (only the auto* numbers are changed)
+	 * phase one: no more SequenceSplitters than the parser can feed (file input only)
+	 * phase two: splitters and hashers in proportion of their costs per k-mer
+	 */
+	void tuneThreads(const uint8 &gpusNumber, const bool &fileInput,
+			const bool &autoSequenceSplitters, const bool &autoSuperSplitters, const bool &autoHashers,
+			uint8 &sequenceSplitters, uint8 &superSplitters, uint8 &hashers);
+
+	// returns the size of a queue which buffers AUTOTUNE_QUEUE_BUFFER_MS of the consumer (rate in B/s)
+	uint64 getQueueSize_B(const double &rate) const;
+
+	inline double getParseRate() const { return _parseRate; }
+	inline double getParseBytesRate() const { return _parseBytesRate; }
+	inline double getScanRate() const { return _scanRate; }
+	inline double getSplitRate() const { return _splitRate; }
+	inline double getHashRate() const { return _hashRate; }
+
+	// logs a decision (printed in verbose mode, added to the report)
+	void decide(const std::string &name, const uint64 &value, const char* reason);
+
+	/*
+	 * prints the calibrated throughputs
+	 */
+	void print();
+
+	/*
+	 * adds the calibrated throughputs and all decisions to the telemetry report
+	 */
+	void report(TelemetryStage &stage);
+};
+
+}
+
+#endif /* AUTOTUNER_H_ */
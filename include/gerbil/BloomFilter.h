@@ -0,0 +1,84 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef BLOOMFILTER_H_
+#define BLOOMFILTER_H_
+
+#include "HugePages.h"
+#include <algorithm>
+#include <cstring>
+
+namespace gerbil {
+
+/*
+ * blocked bloom filter (prefilter of the hash tables of the CPU hashers)
+ * all BLOOM_FILTER_HASHES bits of a key are in one block of 512 bits (a cache line)
+ * single thread only, the memory is allocated once, each bin uses (and clears) a part of it
+ */
+class BlockedBloomFilter {
+	uint64 *_blocks;
+	uint64 _maxBlocksNumber;
+	uint64 _blocksNumber;           // used blocks
+
+public:
+	static constexpr uint64 BLOCK_SIZE_B = 64;
+
+	// memory of a filter for n keys
+	static inline uint64 getSize_B(const uint64 &n) {
+		return (n * BLOOM_FILTER_BITS / 8 / BLOCK_SIZE_B + 1) * BLOCK_SIZE_B;
+	}
+
+	BlockedBloomFilter(const uint64 &size_B) :
+			_maxBlocksNumber(size_B / BLOCK_SIZE_B ? size_B / BLOCK_SIZE_B : 1), _blocksNumber(1) {
+		_blocks = (uint64 *) HugePages::allocate(_maxBlocksNumber * BLOCK_SIZE_B);
+		memset(_blocks, 0, BLOCK_SIZE_B);
+	}
+
+	~BlockedBloomFilter() {
+		HugePages::release(_blocks, _maxBlocksNumber * BLOCK_SIZE_B);
+	}
+
+	// empties the filter and sizes it for n keys (at most the allocated memory)
+	inline void resize(const uint64 &n) {
+		_blocksNumber = std::max<uint64>(1, std::min(getSize_B(n) / BLOCK_SIZE_B, _maxBlocksNumber));
+		memset(_blocks, 0, _blocksNumber * BLOCK_SIZE_B);
+	}
+
+	// sets the bits of a key (hash), returns true if all of them were set
+	inline bool testAndSet(const uint64 &hash) {
+		// block and bits of independent products (the table takes the hash modulo its size)
+		uint64 *const block = _blocks + (uint64) (((unsigned __int128) (hash * 0x9e3779b97f4a7c15ULL)
+				* _blocksNumber) >> 64) * (BLOCK_SIZE_B / 8);
+		uint64 h = (hash * 0xc2b2ae3d27d4eb4fULL) >> 28;
+		bool set = true;
+		for (uint32 i = 0; i < BLOOM_FILTER_HASHES; ++i, h >>= 9) {
+			uint64 &word = block[(h >> 6) & 0x7];
+			const uint64 bit = 1ULL << (h & 0x3f);
+			set &= (word & bit) != 0;
+			word |= bit;
+		}
+		return set;
+	}
+};
+
+}
+
+#endif /* BLOOMFILTER_H_ */
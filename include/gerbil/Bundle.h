@@ -23,6 +23,10 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define BUNDLE_H_
 
 #include "KMer.h"
+#include "KMerHash.h"
+#include "MemoryTracker.h"
+#include "HugePages.h"
+#include <cstring>
 
 namespace gerbil {
 
@@ -37,6 +41,11 @@ namespace gerbil {
 
 		FastBundle() :
 				size(0) {
+			MemoryTracker::acquire(mc_fastBundles, sizeof(FastBundle));
+		}
+
+		~FastBundle() {
+			MemoryTracker::release(mc_fastBundles, sizeof(FastBundle));
 		}
 
 		bool isFull() {
@@ -89,6 +98,8 @@ namespace gerbil {
 		void print();
 
 		static void setK(uint k) { K = k; }
+
+		static uint getK() { return K; }
 	};
 
 /*
@@ -131,36 +142,68 @@ namespace gerbil {
 
 /*
  * bundle for k-mers
+ * with HASHES, the hash of each k-mer (KMER_HASH_POLICY) is stored in front of the k-mers
+ * with PACKED, each k-mer takes getKMerCompactByteNumbers<K>() bytes (as toByte), else sizeof(KMer<K>)
  */
-	template<uint32_t K, uint32_t bufferSize>
+	template<uint32_t K, uint32_t bufferSize, bool HASHES = false, bool PACKED = false>
 	class KMerBundle {
 	private:
-		KMer<K> *_data;            // data (k-mers)
-		KMer<K> *_next;            // next place for reading k-mers
-		KMer<K> *_last;            // next place for writing k-mers
-		KMer<K> *_end;            // end of data (exclusive)
+		byte *_block;              // hashes (HASHES only) and k-mers
+		uint64 *_hashes;           // hashes of the k-mers (HASHES only)
+		byte *_data;               // data (k-mers)
+		uint32 _kMerSize_B;        // size of a k-mer
+		uint32 _size;              // max number of k-mers
+		uint32 _next;              // next k-mer for reading
+		uint32 _last;              // next k-mer for writing
 		uint_tfn _tempFileId;    // id of TempFile
 		uint_tfn _tempFileRun;  // run of TempFile
 
-		static constexpr size_t dataSize() { return bufferSize / sizeof(KMer<K>); }
+		// loads of a k-mer read up to sizeof(KMer<K>) bytes
+		static constexpr size_t padding_B() { return sizeof(KMer<K>); }
 
-		static constexpr size_t dataSize_B() { return dataSize() * sizeof(KMer<K>); }
+		static constexpr size_t dataSize_B() { return bufferSize; }
 
 	public:
 		KMerBundle() :
 				_tempFileId(TEMPFILEID_NONE), _tempFileRun(0) {
-			size_t l = bufferSize / sizeof(KMer<K>);
-			_data = new KMer<K>[dataSize()];
-			_last = _next = _data;
-			_end = _data + dataSize();
+			_kMerSize_B = kMerSize_B();
+			_size = (dataSize_B() - padding_B()) / (_kMerSize_B + (HASHES ? sizeof(uint64) : 0));
+			_block = (byte*) HugePages::allocateBlock(dataSize_B());
+			memset(_block, 0, dataSize_B());        // first touch: pages on the node of the creating thread
+			_hashes = HASHES ? (uint64*) _block : NULL;
+			_data = _block + (HASHES ? _size * sizeof(uint64) : 0);
+			_last = _next = 0;
+			MemoryTracker::acquire(mc_kMerBundles, dataSize_B());
 		}
 
 		~KMerBundle() {
-			delete[] _data;
+			HugePages::releaseBlock(_block, dataSize_B());
+			MemoryTracker::release(mc_kMerBundles, dataSize_B());
+		}
+
+		// size of a stored k-mer
+		static inline uint32 kMerSize_B() {
+			return PACKED ? getKMerCompactByteNumbers<K>() : sizeof(KMer<K>);
+		}
+
+		// stores a k-mer at p (kMerSize_B() bytes)
+		static inline void storeKMer(byte *const p, const KMer<K> &kMer) {
+			if (PACKED)
+				kMer.toByte(p);
+			else
+				memcpy(p, &kMer, sizeof(KMer<K>));
+		}
+
+		// loads the k-mer at p (reads up to sizeof(KMer<K>) bytes)
+		static inline void loadKMer(const byte *const p, KMer<K> &kMer) {
+			if (PACKED)
+				kMer.set(p);
+			else
+				memcpy(&kMer, p, sizeof(KMer<K>));
 		}
 
 		inline bool isEmpty() const {
-			return _last == _data;
+			return !_last;
 		}
 
 		inline void setTempFileId(const uint_tfn &binId) {
@@ -179,67 +222,145 @@ namespace gerbil {
 			return _tempFileRun;
 		}
 
+		// k-mers (!PACKED only)
 		inline KMer<K> *getData() {
-			return _data;
+			return (KMer<K>*) _data;
 		}
 
 		inline void clear() {
-			_next = _data;
-			_last = _data;
+			_next = 0;
+			_last = 0;
 			_tempFileId = TEMPFILEID_NONE;
 			_tempFileRun = 0;
 		}
 
+		// copies the k-mers (with their hashes) and the bin of bundle
+		inline void copy(const KMerBundle &bundle) {
+			memcpy(_block, bundle._block, dataSize_B());
+			_next = bundle._next;
+			_last = bundle._last;
+			_tempFileId = bundle._tempFileId;
+			_tempFileRun = bundle._tempFileRun;
+		}
+
 		inline void store(FILE *&file) {
-			assert(_last == _end);
-			fwrite((char *) _data, 1, dataSize_B(), file);
+			assert(_last == _size);
+			fwrite((char *) _block, 1, dataSize_B(), file);
 		}
 
 		inline void load(FILE *&file) {
 			clear();
-			if (fread((char *) _data, 1, dataSize_B(), file) != dataSize_B()) {
+			if (fread((char *) _block, 1, dataSize_B(), file) != dataSize_B()) {
 				std::cerr << "ERROR: reload of k-mers failed\n";
 				exit(7);
 			}
-			_last = _end;
+			_last = _size;
 		}
 
 		inline bool add(const KMer<K> &kMer) {
-			if (_last < _end) {
-				(_last++)->set(kMer);
+			if (_last < _size) {
+				if (HASHES)
+					_hashes[_last] = KMER_HASH_POLICY::hash(kMer);
+				storeKMer(_data + (size_t) _last++ * _kMerSize_B, kMer);
+				return true;
+			}
+			return false;
+		}
+
+		// adds a k-mer with its hash (the hash is dropped without HASHES)
+		inline bool add(const KMer<K> &kMer, const uint64 &hash) {
+			if (_last < _size) {
+				if (HASHES)
+					_hashes[_last] = hash;
+				storeKMer(_data + (size_t) _last++ * _kMerSize_B, kMer);
+				return true;
+			}
+			return false;
+		}
+
+		// adds a stored k-mer (kMerSize_B() bytes) with its hash
+		inline bool addBytes(const byte *const kMer, const uint64 &hash) {
+			if (_last < _size) {
+				if (HASHES)
+					_hashes[_last] = hash;
+				memcpy(_data + (size_t) _last++ * _kMerSize_B, kMer, _kMerSize_B);
 				return true;
 			}
 			return false;
 		}
 
 		inline uint32_t count() const {
-			return (uint32_t) (((uint64_t) _last - (uint64_t) _data) / sizeof(KMer<K>));
+			return _last;
 		}
 
+		// next k-mer (!PACKED only)
 		inline bool next(KMer<K> *&kMer) {
 			if (_next < _last) {
-				kMer = (_next++);
+				kMer = (KMer<K>*) (_data + (size_t) _next++ * _kMerSize_B);
+				return true;
+			}
+			return false;
+		}
+
+		// next stored k-mer (kMerSize_B() bytes)
+		inline bool nextBytes(const byte *&kMer) {
+			if (_next < _last) {
+				kMer = _data + (size_t) _next++ * _kMerSize_B;
+				return true;
+			}
+			return false;
+		}
+
+		// next stored k-mer (kMerSize_B() bytes) with its hash (stored or computed by H)
+		template<typename H>
+		inline bool nextBytes(const byte *&kMer, uint64 &hash) {
+			if (_next < _last) {
+				kMer = _data + (size_t) _next * _kMerSize_B;
+				if (HASHES)
+					hash = _hashes[_next];
+				else {
+					KMer<K> k;
+					loadKMer(kMer, k);
+					hash = H::hash(k);
+				}
+				++_next;
 				return true;
 			}
 			return false;
 		}
 
+		// next k-mer (loaded into kMer) with its hash (stored or computed by H)
+		template<typename H>
+		inline bool nextHashed(KMer<K> &kMer, uint64 &hash) {
+			if (_next < _last) {
+				loadKMer(_data + (size_t) _next * _kMerSize_B, kMer);
+				hash = HASHES ? _hashes[_next] : H::hash(kMer);
+				++_next;
+				return true;
+			}
+			return false;
+		}
+
+		// copies all remaining k-mers (!PACKED only)
 		inline void copyAndInc(KMer<K> *&kMer) {
 			while (_next < _last)
-				(kMer++)->set(*(_next++));
+				loadKMer(_data + (size_t) _next++ * _kMerSize_B, *(kMer++));
 		}
 
 		void print() const {
-			const KMer<K> *i = _data;
-			while (i < _last)
-				printKMer(*(i++));
+			KMer<K> kMer;
+			for (uint32 i = 0; i < _last; ++i) {
+				loadKMer(_data + (size_t) i * _kMerSize_B, kMer);
+				printKMer(kMer);
+			}
 		}
 	};
 
-// declare KmerBundles for CPU
+// declare KmerBundles for CPU (with the hashes of rolling hash policies, packed k-mers with KMER_PACKED)
 	namespace cpu {
 		template<uint32_t K>
-		class KMerBundle : public ::gerbil::KMerBundle<K, KMER_BUNDLE_DATA_SIZE_B> {
+		class KMerBundle : public ::gerbil::KMerBundle<K, KMER_BUNDLE_DATA_SIZE_B, KMER_HASH_POLICY::isRolling<K>(),
+				KMER_PACKED> {
 		};
 	}
 
@@ -256,6 +377,9 @@ namespace gerbil {
 	class KmcBundle {
 		byte *_data;            // data
 		byte *_next;            // next free place
+
+		// adds the count of the next k-mer
+		inline void addCount(const uint32 &val);
 	public:
 		KmcBundle();
 
@@ -268,18 +392,24 @@ namespace gerbil {
 		template<unsigned K>
 		bool add(const KMer<K> &kMer, const uint32 &val);
 
+		// add k-mer as stored by a KMerBundle (PACKED: compact bytes) with count
+		template<unsigned K, bool PACKED>
+		bool add(const byte *kMer, const uint32 &val);
+
 		bool isEmpty() const;
 
 		uint32 getSize() const;
 
 		const byte *getData() const;
+
+		// decodes the record at p (counter + k-mer bytes), returns the next record
+		static const byte *nextRecord(const byte *p, const uint32 &k, uint32 &counter, const byte *&kMer);
+
+		// converts k-mer bytes (four bases per byte) to a sequence of k bases
+		static void toSequence(const byte *kMer, const uint32 &k, char *seq);
 	};
 
-	template<unsigned K>
-	bool KmcBundle::add(const KMer<K> &kMer, const uint32 &val) {
-		if (_next + sizeof(KMer<K>) + 1
-		    + (val < 255 ? 1 : 5) >= _data + KMC_BUNDLE_DATA_SIZE_B)
-			return false;
+	inline void KmcBundle::addCount(const uint32 &val) {
 		if (val < 255)    // 1 byte for counts < 255
 			*(_next++) = val;
 		else {            // 1 byte (Count greater than 254) + 4 bytes for count
@@ -287,12 +417,34 @@ namespace gerbil {
 			*((uint32 *) _next) = val;
 			_next += 4;
 		}
+	}
+
+	template<unsigned K>
+	bool KmcBundle::add(const KMer<K> &kMer, const uint32 &val) {
+		if (_next + sizeof(KMer<K>) + 1
+		    + (val < 255 ? 1 : 5) >= _data + KMC_BUNDLE_DATA_SIZE_B)
+			return false;
+		addCount(val);
 		// add kMer after count
 		kMer.toByte(_next);
 		_next += getKMerCompactByteNumbers<K>();
 		return true;
 	}
 
+	template<unsigned K, bool PACKED>
+	bool KmcBundle::add(const byte *kMer, const uint32 &val) {
+		if (!PACKED)
+			return add<K>(*(const KMer<K> *) kMer, val);
+		const uint32 kMerSize_B = getKMerCompactByteNumbers<K>();
+		if (_next + kMerSize_B + (val < 255 ? 1 : 5) >= _data + KMC_BUNDLE_DATA_SIZE_B)
+			return false;
+		addCount(val);
+		// the compact bytes are the output format
+		memcpy(_next, kMer, kMerSize_B);
+		_next += kMerSize_B;
+		return true;
+	}
+
 	inline bool KmcBundle::isEmpty() const {
 		return _next == _data;
 	}
@@ -305,6 +457,23 @@ namespace gerbil {
 		return _data;
 	}
 
+	inline const byte *KmcBundle::nextRecord(const byte *p, const uint32 &k, uint32 &counter, const byte *&kMer) {
+		counter = (uint32) *(p++);
+		if (counter >= 255) {
+			// large value
+			counter = *((uint32 *) p);
+			p += 4;
+		}
+		kMer = p;
+		return p + (k + 3) / 4;
+	}
+
+	inline void KmcBundle::toSequence(const byte *kMer, const uint32 &k, char *seq) {
+		static const char c[4] = {'A', 'C', 'G', 'T'};
+		for (uint i = 0; i < k; ++i)
+			seq[i] = c[(kMer[i >> 2] >> (2 * (3 - (i & 0x3)))) & 0x3];
+	}
+
 }
 
 #endif /* BUNDLE_H_ */
@@ -26,8 +26,15 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "SyncQueue.h"
 #include "TempFile.h"
 #include "KmerDistributer.h"
+#include "PerfCounters.h"
+#include "NumaTopology.h"
+#include "HugePages.h"
+#include "KMerHash.h"
+#include "KMerQuotient.h"
+#include "BloomFilter.h"
 #include <algorithm>
 #include <chrono>
+#include <unordered_map>
 
 namespace gerbil {
 	namespace cpu {
@@ -41,24 +48,77 @@ namespace gerbil {
 
 //#define HT_FAILS
 
+#if HYBRID_COUNTER && KMER_PACKED
+#error "HYBRID_COUNTER sorts unpacked k-mers (KMER_PACKED false)"
+#endif
+
 #ifdef HT_FAILS
 #define IF_HT_FAILS(x) x
 #else
 #define IF_HT_FAILS(x)
 #endif
 
+		// maximal number of probe steps of a k-mer in a table of partSize entries
+		inline uint32 getMaxProbeSteps(uint64 partSize) {
+			uint32 ms = 5;
+			while (partSize >>= 1)
+				++ms;
+			return ms;
+		}
+
+		/*
+		 * probes the table for key (quadratic probing, empty entries have the counter 0)
+		 * hPos: first entry, afterwards the entry of the key, the empty entry or the last probed entry
+		 * steps: number of steps, a quotient key (qKey == key) is updated to the step
+		 * returns 1 (found), 0 (empty entry) or -1 (maxSteps exceeded)
+		 */
+		template<unsigned K, typename TC>
+		inline int probeKey(const byte *const keys, const TC *const counters, const uint64 &partSize,
+		                    const uint64 &keySize_B, const uint64 &maxSteps, const byte *const key,
+		                    uint64 &hPos, uint64 &steps, const KMerQuotient<K> *const quotient = NULL,
+		                    byte *const qKey = NULL) {
+			steps = 0;
+			while (true) {
+				if (!counters[hPos])
+					return 0;
+				if (isEqualKMerBytes(keys + hPos * keySize_B, key, keySize_B))
+					return 1;
+				if (++steps > maxSteps)
+					return -1;
+				if (quotient)
+					quotient->setStep(qKey, steps);
+				hPos += steps * steps;
+				hPos %= partSize;
+			}
+		}
 
 /**
  * A HashTable for Counting of Kmers.
+ * H: hash policy of the table (KMerHash.h)
+ * the keys are stored as in the KMerBundles (KMerBundle<K>::kMerSize_B() bytes), empty entries have the value 0
+ * with quotient keys (KMerQuotient.h, KMER_PACKED only), the table position is part of the key and H is unused
+ * counters have 1, 2 or 4 bytes, a saturated counter of 1 or 2 bytes continues in a side table of its thread
+ * (not in the memory budget, a bin of n k-mers has less than n / 255 such counters)
+ * k-mers which exceed maxSteps are counted in a FailureTable of the thread, only if it cannot grow
+ * they go to a FailureBuffer and are counted in further passes
  */
-		template<unsigned K>
+		template<unsigned K, typename H = KMER_HASH_POLICY>
 		class HasherTask {
 
 			//stat
-			IF_HT_FAILS(std::atomic <uint64> _fKMersNumber;)
+			std::atomic <uint64> _fKMersNumber;
+			std::atomic <uint64> _probesNumber;
+			std::atomic <uint64> _spilledNumber;
+			std::atomic <uint64> _prefilterSpilledNumber;
+			std::atomic <uint64> _overflowNumber;
+			std::atomic <uint64> _singletonsNumber;
+			std::atomic <uint64> _failureTableKMersNumber;
+			PerfRegion _perfFill;        // hardware events of KMCHT_fill (optional)
+			PerfRegion _perfExtract;     // hardware events of KMCHT_extract (optional)
 			IF_HT_JUMPS(std::atomic <uint64> _jumps;)
 
 			uint64 _maxPartSize;        // number of entries in hash table
+			uint64 *_maxPartSizes;      // number of entries in hash table per thread (downsized to the memory budget)
 			uint64 _maxSizeUsage;        // ?
 
 			SyncSwapQueueMPSC<KmcBundle> *_kmcSyncSwapQueue;    // output queue
@@ -71,6 +131,12 @@ namespace gerbil {
 
 			uint_cv _thresholdMin;        // minimal number of occurrences to be output
 
+			bool _quotient;               // quotient keys
+			uint64 _keySize_B;            // size of a key in the largest hash table
+			uint32 _counterSize_B;        // size of a counter (1, 2 or sizeof(uint_cv))
+			bool _prefilter;              // k-mers enter the hash tables on their second occurrence
+			uint32 _prefilterBundlesNumber; // KMerBundles of the first occurrences in memory (per thread)
+
 			byte _threadsNumber;        // number of threads
 			std::thread **_threads;        // array of threads
 
@@ -83,11 +149,18 @@ namespace gerbil {
 
 			uint32 getMaxSteps() const;
 
+			// size of a hash table entry (key, value and prefilter)
+			inline uint64 getEntrySize_B() const {
+				return _keySize_B + _counterSize_B + (_prefilter ? BLOOM_FILTER_BITS / 8 : 0);
+			}
+
 		public:
 			HasherTask(const byte &threadsNumber, KmerDistributer *distributor,
 			           SyncSwapQueueMPSC<KmcBundle> *kmcSyncSwapQueues,
 			           TempFile *tempFiles, const uint_cv &thresholdMin,
-			           const uint64 &maxSize, std::string tempPath);
+			           const uint64 &maxSize, std::string tempPath, const bool &quotientKeys = false,
+			           const uint32 &counterSize_B = sizeof(uint_cv), const bool &prefilter = false,
+			           const uint32 &prefilterBundlesNumber = PREFILTER_KMER_BUNDLES_NUMBER_PER_THREAD);
 
 			~HasherTask();
 
@@ -103,6 +176,54 @@ namespace gerbil {
 				return _btUKMersNumber.load();
 			}
 
+			// number of probed hash table entries
+			inline uint64 getProbesNumber() const {
+				return _probesNumber.load();
+			}
+
+			// number of k-mers which did not fit into the hash table and the failure table (failure buffers)
+			inline uint64 getFKMersNumber() const {
+				return _fKMersNumber.load();
+			}
+
+			// number of k-mers which were counted in the failure tables
+			inline uint64 getFailureTableKMersNumber() const {
+				return _failureTableKMersNumber.load();
+			}
+
+			// number of KMerBundles of the failure buffers which were stored on disk
+			inline uint64 getSpilledNumber() const {
+				return _spilledNumber.load();
+			}
+
+			// number of KMerBundles of the first occurrences which were stored on disk (prefilter)
+			inline uint64 getPrefilterSpilledNumber() const {
+				return _prefilterSpilledNumber.load();
+			}
+
+			// size of a key in the largest hash table
+			inline uint64 getKeySize_B() const {
+				return _keySize_B;
+			}
+
+			// number of counters which exceeded their size (side table)
+			inline uint64 getOverflowNumber() const {
+				return _overflowNumber.load();
+			}
+
+			// number of k-mers which occurred once (prefilter)
+			inline uint64 getSingletonsNumber() const {
+				return _singletonsNumber.load();
+			}
+
+			inline PerfRegion &getPerfFill() {
+				return _perfFill;
+			}
+
+			inline PerfRegion &getPerfExtract() {
+				return _perfExtract;
+			}
+
 			uint64 getHistogramEntry(const uint i) {
 				return _histogram[i].load();
 			}
@@ -116,90 +237,205 @@ namespace gerbil {
 			void join();
 		};
 
-		template<unsigned K>
-		HasherTask<K>::HasherTask(const byte &threadsNumber,
+		template<unsigned K, typename H>
+		HasherTask<K, H>::HasherTask(const byte &threadsNumber,
 		                          KmerDistributer *distributor,
 		                          SyncSwapQueueMPSC<KmcBundle> *kmcSyncSwapQueue, TempFile *tempFiles,
 		                          const uint_cv &thresholdMin, const uint64 &maxSize,
-		                          std::string tempPath
+		                          std::string tempPath, const bool &quotientKeys,
+		                          const uint32 &counterSize_B, const bool &prefilter,
+		                          const uint32 &prefilterBundlesNumber
 		) :
 				_kmcSyncSwapQueue(kmcSyncSwapQueue), _tempFiles(tempFiles),
 				_thresholdMin(thresholdMin), _threads(NULL), _tempPath(tempPath), _maxSizeUsage(0),
 				_kMersNumber(0), _uKMersNumber(0), _btUKMersNumber(0), _threadsNumber(threadsNumber),
-				distributor(distributor) {
+				distributor(distributor), _quotient(quotientKeys && KMER_PACKED),
+				_counterSize_B(counterSize_B == 1 || counterSize_B == 2 ? counterSize_B : sizeof(uint_cv)),
+				_prefilter(prefilter && thresholdMin > 1 && !HYBRID_COUNTER),
+				_prefilterBundlesNumber(std::max<uint32>(prefilterBundlesNumber, 1)) {
 			_maxPartSize = maxSize / _threadsNumber;
-
-			for (uint32_t tId = 0; tId < _threadsNumber; tId++)
-				distributor->updateCapacity(false, tId, _maxPartSize);
+			_keySize_B = _quotient ? getKMerQuotientByteNumbers(KMer<K>::getK(), _maxPartSize) : KMerBundle<K>::kMerSize_B();
+
+			// hash tables which exceed the memory budget are downsized (more k-mers go to the failure buffers),
+			// the budget is acquired for all tables at once and split evenly (the distributor assumes equal
+			// capacities of the cpu hashers)
+			const uint64 bytesPerEntry = getEntrySize_B();
+			const uint64 granted_B = MemoryTracker::acquireUpTo(mc_hashTables,
+					_threadsNumber * _maxPartSize * bytesPerEntry,
+					_threadsNumber * std::min<uint64>(_maxPartSize, 128) * bytesPerEntry);
+			const uint64 partSize = granted_B / _threadsNumber / bytesPerEntry;
+			MemoryTracker::release(mc_hashTables, granted_B - _threadsNumber * partSize * bytesPerEntry);
+			_maxPartSizes = new uint64[_threadsNumber];
+			for (uint32_t tId = 0; tId < _threadsNumber; tId++) {
+				_maxPartSizes[tId] = partSize;
+				distributor->updateCapacity(false, tId, _maxPartSizes[tId]);
+			}
 
 			distributor->setRdy();
 
 			//stat
-			IF_HT_FAILS(_fKMersNumber.store(0);)
+			_fKMersNumber.store(0);
+			_probesNumber.store(0);
+			_spilledNumber.store(0);
+			_prefilterSpilledNumber.store(0);
+			_overflowNumber.store(0);
+			_singletonsNumber.store(0);
+			_failureTableKMersNumber.store(0);
 			IF_HT_JUMPS(_jumps.store(0);)
 			for (uint i(0); i < HISTOGRAM_SIZE; ++i)
 				_histogram[i].store(0);
 		}
 
-		template<unsigned K>
-		HasherTask<K>::~HasherTask() {
+		template<unsigned K, typename H>
+		HasherTask<K, H>::~HasherTask() {
+			for (uint32_t tId = 0; tId < _threadsNumber; tId++)
+				MemoryTracker::release(mc_hashTables, _maxPartSizes[tId] * getEntrySize_B());
+			delete[] _maxPartSizes;
 		}
 
-		template<unsigned K>
-		inline void HasherTask<K>::printStat() {
+		template<unsigned K, typename H>
+		inline void HasherTask<K, H>::printStat() {
 			puts("");
 			IF_HT_FAILS(printf("fkmers          : %12lu\n", _fKMersNumber.load());)
 			IF_HT_FAILS(printf("fkmers/kmer     : %15.2f\n", (double) _fKMersNumber.load() / _kMersNumber);)
 			IF_HT_JUMPS(printf("jumps           : %12lu\n", _jumps.load());)
 			IF_HT_JUMPS(printf("jumps/kmer      : %15.2f\n", (double) _jumps.load() / _kMersNumber);)
 
-			double r = (double) (sizeof(KMer<K>) + sizeof(uint_cv)) / 1024 / 1024;
+			double r = (double) getEntrySize_B() / 1024 / 1024;
 			uint64 maxSize = _maxPartSize * _threadsNumber;
 //printf("size unused    : %12lu of %lu\n", maxSize - _maxSizeUsage, maxSize);
 //printf("memory unused  : %.0f MB of %.0f MB\n", (maxSize - _maxSizeUsage) * r, maxSize * r);
 		}
 
-#define KMCHT_fill() {                                                                \
+// counter of an existing entry
+#define KMCHT_incCounter(TC, pos) {                                                 \
+    if(sizeof(TC) == sizeof(uint_cv) || counters[pos] != (TC) ~0)                  \
+        ++counters[pos];                                                            \
+    else                                                                            \
+        ++overflowCounters[pos];                                                    \
+}
+
+// probes the entries of the k-mer nkMer (key: stored k-mer or quotient key, first entry: hPos),
+// found: 1 (hPos is its entry), 0 (hPos is a free entry) or -1 (maxSteps exceeded)
+#define KMCHT_probe(TC) {                                                           \
+    found = probeKey<K, TC>(keys, counters, partSize, keySize_B, maxSteps, key, hPos, i, \
+            _quotient ? &quotient : NULL, qKey);                                    \
+    curKey = keys + hPos * keySize_B;                                               \
+    probes += i + 1;                                                                \
+    IF_HT_JUMPS(jumps += i;)                                                        \
+}
+
+// next k-mer (nkMer, nkHash) of a bundle, its key and its first entry (hPos)
+#define KMCHT_next(bundle)                                                          \
+    (_quotient ? bundle->nextBytes(nkMer) : bundle->template nextBytes<H>(nkMer, nkHash)) \
+            && ((_quotient ? (nkHash = quotient.encode(nkMer, qKey, hPos), key = qKey)  \
+                           : (hPos = nkHash % partSize, key = nkMer)), true)
+
+#define KMCHT_fillCounters(TC) {                                                    \
+    TC *const counters = (TC *) values;                                             \
     if(HYBRID_COUNTER && useSort) {                                                    \
         kmb->copyAndInc(nextKey);                                                    \
         kmb->clear();                                                                \
     } else {                                                                        \
-    while(kmb->next(nkMer)) {                                                        \
-        hPos = nkMer->getHash() % partSize;                                            \
-        i = 0;                                                                        \
-        KMer<K>* curKey;                                                            \
-        while(true) {                                                                \
-            if((curKey = keys + hPos)->isEmpty()) {                                    \
-                values[hPos] = 1;                                                    \
-                curKey->set(*nkMer);                                                \
-                ++binUKMers;                                                        \
-                break;                                                                \
-            }                                                                        \
-            if(curKey->isEqual(*nkMer)) {                                            \
-                ++values[hPos];                                                        \
-                break;                                                                \
-            }                                                                        \
-            if(++i > maxSteps) {                                                    \
-                outBuffer->addKMer(*nkMer);                                            \
-                ++binFKMers;                                                        \
-                break;                                                                \
-            }                                                                        \
-            hPos += i * i;                                                            \
-            hPos %= partSize;                                                        \
-        }                                                                            \
-        IF_HT_JUMPS(jumps += i;)                                                    \
+    while(KMCHT_next(kmb)) {                                                        \
+        KMCHT_probe(TC);                                                            \
+        if(found > 0)                                                               \
+            KMCHT_incCounter(TC, hPos)                                              \
+        else if(prefiltering && !bloom.testAndSet(nkHash))                          \
+            /* first occurrence (counted by KMCHT_replay) */                        \
+            candidates->addKMerBytes(nkMer, nkHash);                                \
+        else if(!found) {                                                           \
+            counters[hPos] = 1;                                                     \
+            memcpy(curKey, key, keySize_B);                                         \
+            ++binUKMers;                                                            \
+        } else if(!failureTable->add(nkMer)) {                                      \
+            outBuffer->addKMerBytes(nkMer, nkHash);                                 \
+            ++binFKMers;                                                            \
+        }                                                                           \
     }                                                                                \
     kmb->clear();                                                                    \
 }}
 
-#define KMCHT_extract() {                                                                    \
+#define KMCHT_fill() {                                                              \
+    switch(counterSize_B) {                                                         \
+        case 1: KMCHT_fillCounters(uint8); break;                                   \
+        case 2: KMCHT_fillCounters(uint16); break;                                  \
+        default: KMCHT_fillCounters(uint_cv);                                       \
+    }                                                                               \
+}
+
+// counts the first occurrences of the prefilter: k-mers of the tables get their first occurrence,
+// the others are singletons, unless they may be in the failure buffer (maxSteps exceeded)
+#define KMCHT_replayCounters(TC) {                                                  \
+    TC *const counters = (TC *) values;                                             \
+    KMerBundle<K> *ckmb;                                                            \
+    while(candidates->getNextKMerBundle(ckmb)) {                                    \
+        while(KMCHT_next(ckmb)) {                                                   \
+            KMCHT_probe(TC);                                                        \
+            if(found > 0)                                                           \
+                KMCHT_incCounter(TC, hPos)                                          \
+            else if(found < 0 && failureTable->add(nkMer, false)) {                 \
+                /* counted in the failure table */                                  \
+            } else if(found < 0 && binFKMers) {                                     \
+                outBuffer->addKMerBytes(nkMer, nkHash);                             \
+                ++binFKMers;                                                        \
+            } else {                                                                \
+                ++binUKMers;                                                        \
+                ++binKMers;                                                         \
+                ++histogram[1];                                                     \
+                ++btUKMersNumber;                                                   \
+                ++singletonsNumber;                                                 \
+            }                                                                       \
+        }                                                                           \
+        ckmb->clear();                                                              \
+    }                                                                               \
+    candidates->clear();                                                            \
+}
+
+#define KMCHT_replay() {                                                            \
+    switch(counterSize_B) {                                                         \
+        case 1: KMCHT_replayCounters(uint8); break;                                 \
+        case 2: KMCHT_replayCounters(uint16); break;                                \
+        default: KMCHT_replayCounters(uint_cv);                                     \
+    }                                                                               \
+}
+
+// passes a counted k-mer (stored as in the KMerBundles) to the output queue
+#define KMCHT_output(kMer_p, val) {                                                 \
+    if(!curKmcBundle->add<K, KMER_PACKED>(kMer_p, val)) {                           \
+        IF_MESS_SUPERREADER(sw.hold();)                                             \
+        _kmcSyncSwapQueue->swapPush(curKmcBundle);                                  \
+        IF_MESS_SUPERREADER(sw.proceed();)                                          \
+        curKmcBundle->add<K, KMER_PACKED>(kMer_p, val);                             \
+    }                                                                               \
+}
+
+#define KMCHT_extractFailureTable() {                                               \
+    if(failureTable->getSize()) {                                                   \
+        binUKMers += failureTable->getSize();                                       \
+        for(uint64 pos = 0; pos < failureTable->getCapacity(); ++pos) {             \
+            const uint_cv val = failureTable->getCount(pos);                        \
+            if(val) {                                                               \
+                binKMers += val;                                                    \
+                ++histogram[val < HISTOGRAM_SIZE ? val : 0];                        \
+                if(_thresholdMin > val)                                             \
+                    ++btUKMersNumber;                                               \
+                else                                                                \
+                    KMCHT_output(failureTable->getKMer(pos), val);                  \
+            }                                                                       \
+        }                                                                           \
+    }                                                                               \
+    failureTable->clear();                                                          \
+}
+
+#define KMCHT_extractCounters(TC) {                                                         \
     if(HYBRID_COUNTER && useSort) {                                                            \
-        std::sort(keys, nextKey);                                                            \
+        std::sort((KMer<K>*) keys, nextKey);                                                 \
         KMer<K>* endKey_p = nextKey;                                                        \
         KMer<K> key;                                                                        \
         key.clear();                                                                        \
         uint64 val = 0;                                                                        \
-        for(KMer<K>* curKey = keys; curKey < endKey_p; ++curKey) {                            \
+        for(KMer<K>* curKey = (KMer<K>*) keys; curKey < endKey_p; ++curKey) {                 \
             if(curKey->isEqual(key)) {                                                        \
                 ++val;                                                                        \
             } else {                                                                        \
@@ -235,49 +471,85 @@ namespace gerbil {
             }                                                                        \
         }                                                                            \
     } else {                                                                            \
+        TC *const counters = (TC *) values;                                             \
         uint_cv val;                                                                    \
-        KMer<K>* endKey = keys + partSize;                                                \
-        KMer<K>* curKey = keys;                                                            \
-        for(; curKey < endKey; ++curKey) {                                                \
-            if(!curKey->isEmpty()) {                                                    \
-                binKMers += (val = *(values + (curKey - keys)));                        \
+        const byte *kMer_p;                                                             \
+        for(uint64 pos = 0; pos < partSize; ++pos) {                                    \
+            if((val = counters[pos])) {                                                 \
+                if(sizeof(TC) < sizeof(uint_cv) && val == (TC) ~0) {                    \
+                    auto overflow_it = overflowCounters.find(pos);                      \
+                    if(overflow_it != overflowCounters.end())                           \
+                        val += overflow_it->second;                                     \
+                }                                                                       \
+                binKMers += val;                                                        \
                 ++histogram[val < HISTOGRAM_SIZE ? val : 0];                            \
                 if(_thresholdMin > val)                                                    \
                     ++btUKMersNumber;                                                    \
-                else if(!curKmcBundle->add<K>(*curKey, val)) {                            \
-                        IF_MESS_SUPERREADER(sw.hold();)                                    \
-                        _kmcSyncSwapQueue->swapPush(curKmcBundle);                        \
-                        IF_MESS_SUPERREADER(sw.proceed();)                                \
-                        curKmcBundle->add<K>(*curKey, val);                                \
+                else {                                                                  \
+                    if(_quotient) {                                                     \
+                        quotient.decode(keys + pos * keySize_B, pos, qKMer);            \
+                        kMer_p = qKMer;                                                 \
+                    } else                                                              \
+                        kMer_p = keys + pos * keySize_B;                                \
+                    KMCHT_output(kMer_p, val);                                          \
                 }                                                                        \
-                curKey->clear();                                                        \
+                counters[pos] = 0;                                                      \
             }                                                                            \
         }                                                                                \
+        overflowNumber += overflowCounters.size();                                       \
+        overflowCounters.clear();                                                        \
     }                                                                                    \
 }
 
+#define KMCHT_extract() {                                                           \
+    switch(counterSize_B) {                                                         \
+        case 1: KMCHT_extractCounters(uint8); break;                                \
+        case 2: KMCHT_extractCounters(uint16); break;                               \
+        default: KMCHT_extractCounters(uint_cv);                                    \
+    }                                                                               \
+    KMCHT_extractFailureTable();                                                    \
+}
+
 // compute next size for hashtable (one thread)
 #define KMCHT_setPartSize() {                                                                    \
-    useSort = _tempFiles[curTempFileId].getKMersNumber() / _tempFiles[curTempFileId].getNumberOfRuns() <= _maxPartSize;                        \
+    useSort = _tempFiles[curTempFileId].getKMersNumber() / _tempFiles[curTempFileId].getNumberOfRuns() <= maxPartSize;                         \
     if(HYBRID_COUNTER && useSort)                                                                \
-        nextKey = keys;                                                                            \
+        nextKey = (KMer<K>*) keys;                                                                 \
     else {                                                                                        \
         partSize = apprUKMersNumber / FILL;                                                        \
         if(partSize < 128)                                                                        \
             partSize = 128;                                                                        \
-        if(partSize > _maxPartSize)                                                                \
-            partSize = _maxPartSize;                                                            \
+        if(partSize > maxPartSize)                                                                 \
+            partSize = maxPartSize;                                                             \
+        if(_quotient) {                                                                            \
+            /* keys of smaller tables are longer */                                                \
+            while(partSize * getKMerQuotientByteNumbers(KMer<K>::getK(), partSize) > keysCapacity_B) \
+                partSize = keysCapacity_B / getKMerQuotientByteNumbers(KMer<K>::getK(), partSize); \
+            quotient.setPartSize(partSize);                                                        \
+            keySize_B = quotient.getKeySize_B();                                                   \
+        }                                                                                          \
         if(maxPartSizeUsage < partSize)    {                                                        \
-            keysEnd = keys + partSize;                                                            \
-            for(KMer<K>* p = keys + maxPartSizeUsage; p < keysEnd; ++p)                            \
-                p->clear();                                                                        \
+            memset(values + maxPartSizeUsage * counterSize_B, 0,                                   \
+                    (partSize - maxPartSizeUsage) * counterSize_B);                                \
             maxPartSizeUsage = partSize;                                                        \
         }                                                                                          \
 	}                                                                                            \
 }
 
-		template<unsigned K>
-		void HasherTask<K>::hash(SyncSwapQueueMPSC<cpu::KMerBundle<K>> **kMerQueues) {
+// size of the hash table of a new bin (one thread), with the prefilter only for the k-mers seen twice
+#define KMCHT_prefilter() {                                                                      \
+    prefiltering = _prefilter;                                                                   \
+    if(prefiltering) {                                                                           \
+        bloom.resize(apprUKMersNumber);                                                          \
+        /* singletons of the previous bins (twice the space, small tables vary) */               \
+        if(uKMersNumber)                                                                         \
+            apprUKMersNumber *= std::min(1.0, 2.0 * (uKMersNumber - singletonsNumber) / uKMersNumber); \
+    }                                                                                            \
+    KMCHT_setPartSize();                                                                         \
+}
+
+		template<unsigned K, typename H>
+		void HasherTask<K, H>::hash(SyncSwapQueueMPSC<cpu::KMerBundle<K>> **kMerQueues) {
 			_threads = new std::thread *[_threadsNumber];
 			for (uint8_t i(0); i < _threadsNumber; ++i) {
 				_threads[i] =
@@ -288,6 +560,9 @@ namespace gerbil {
 											sw.start();
 									)
 
+									// hash table and failure buffers are first touched on the node of the thread
+									NumaTopology::pin(NumaTopology::getNode(tId, _threadsNumber));
+
 									// initialize histogram
 									uint64 histogram[HISTOGRAM_SIZE];
 									for (size_t i(0); i < HISTOGRAM_SIZE; ++i)
@@ -296,19 +571,39 @@ namespace gerbil {
 									KMerBundle<K> *kmb = new KMerBundle<K>();
 									KMerBundle<K> *skmb = new KMerBundle<K>();
 									KmcBundle *curKmcBundle = new KmcBundle();
-									const uint64 maxSteps(getMaxSteps());
+									// (the step of a quotient key has KMER_QUOTIENT_STEP_BITS)
+									const uint64 maxSteps(_quotient ? std::min<uint64>(getMaxSteps(), KMER_QUOTIENT_MAX_STEPS) : getMaxSteps());
 
 									FailureBuffer<K> *inBuffer = new FailureBuffer<K>(
 											FAILUREBUFFER_KMER_BUNDLES_NUMBER_PER_THREAD, _tempPath, tId, 0);
 									FailureBuffer<K> *outBuffer = new FailureBuffer<K>(
 											FAILUREBUFFER_KMER_BUNDLES_NUMBER_PER_THREAD, _tempPath, tId, 1);
+									FailureTable<K> *failureTable = new FailureTable<K>();
 
-									SyncSwapQueueMPSC<KMerBundle<K>> *kMerQueue = kMerQueues[tId];
-									KMer<K> *nkMer;
-									KMer<K> *keys = new KMer<K>[_maxPartSize];
-									uint_cv *values = new uint_cv[_maxPartSize];
+									// first occurrences of k-mers (prefilter)
+									BlockedBloomFilter bloom(_prefilter ? BlockedBloomFilter::getSize_B(_maxPartSizes[tId]) : 0);
+									FailureBuffer<K> *candidates = _prefilter ? new FailureBuffer<K>(
+											_prefilterBundlesNumber, _tempPath, tId, 2) : NULL;
+									bool prefiltering = false;
 
-									KMer<K> *keysEnd;
+									SyncSwapQueueMPSC<KMerBundle<K>> *kMerQueue = kMerQueues[tId];
+									const byte *nkMer;
+									uint64 nkHash;
+									const byte *key;
+									byte *curKey;
+									int found;
+									const uint64 maxPartSize = _maxPartSizes[tId];
+									uint64 keySize_B = _keySize_B;
+									const uint64 keysCapacity_B = maxPartSize * _keySize_B;
+									// (comparisons read up to 7 bytes behind a key)
+									const uint64 keys_B = keysCapacity_B + sizeof(uint64);
+									KMerQuotient<K> quotient;
+									byte qKey[sizeof(KMer<K>) + sizeof(uint64)];
+									byte qKMer[sizeof(KMer<K>) + sizeof(uint64)];
+									byte *keys = (byte *) HugePages::allocate(keys_B);
+									const uint32 counterSize_B = _counterSize_B;
+									byte *values = (byte *) HugePages::allocate(maxPartSize * counterSize_B);
+									std::unordered_map<uint64, uint_cv> overflowCounters;
 
 									uint64 i;
 									uint64 hPos;
@@ -321,11 +616,17 @@ namespace gerbil {
 									uint64 uKMersNumber = 0;
 									uint64 fKMersNumber = 0;
 									uint64 btUKMersNumber = 0;
+									uint64 probes = 0;
+									uint64 overflowNumber = 0;
+									uint64 singletonsNumber = 0;
 
 									uint64 maxPartSizeUsage = 0;
 
 									IF_HT_JUMPS(uint64 jumps = 0; uint64 oldJumps = 0;)
 
+									PerfCounters perfCounters;
+									PerfStat perfFill, perfExtract;
+
 									bool notEmpty = kMerQueue->swapPop(kmb);
 									uint_tfn curTempFileId = notEmpty ? kmb->getTempFileId() : 0;
 									uint_tfn curTempRun = notEmpty ? kmb->getTempFileRun() : 0;
@@ -337,7 +638,7 @@ namespace gerbil {
 									bool useSort;
 									KMer<K> *nextKey;
 
-									KMCHT_setPartSize();
+									KMCHT_prefilter();
 
 									// for time measurement
 									typedef std::chrono::microseconds ms;
@@ -352,7 +653,9 @@ namespace gerbil {
 
 											// insert kmers into hash table
 											start = std::chrono::steady_clock::now();
+											perfCounters.start();
 											KMCHT_fill();
+											perfCounters.stop(perfFill);
 											stop = std::chrono::steady_clock::now();
 											duration += std::chrono::duration_cast<ms>(stop - start);
 
@@ -369,7 +672,13 @@ namespace gerbil {
 
 										// measure time for extracting all kmers
 										start = std::chrono::steady_clock::now();
+										perfCounters.start();
+										if (prefiltering) {
+											KMCHT_replay();
+											prefiltering = false;
+										}
 										KMCHT_extract();
+										perfCounters.stop(perfExtract);
 
 										// handle failures
 										std::swap(skmb, kmb);
@@ -414,9 +723,13 @@ namespace gerbil {
 
 											binFKMers = 0;
 
+											perfCounters.start();
 											while (inBuffer->getNextKMerBundle(kmb)) KMCHT_fill();
+											perfCounters.stop(perfFill);
 
+											perfCounters.start();
 											KMCHT_extract();
+											perfCounters.stop(perfExtract);
 
 #if false
 
@@ -439,7 +752,7 @@ namespace gerbil {
 										duration += std::chrono::duration_cast<ms>(stop - start);
 
 										// report throughput to the kmer distributor
-										float throughput = duration.count() == 0 ? 0 : binKMers / duration.count();
+										float throughput = duration.count() == 0 ? 0 : (float) binKMers / duration.count();
 										this->distributor->updateThroughput(false, tId, throughput);
 
 										kMersNumber += binKMers;
@@ -462,7 +775,7 @@ namespace gerbil {
 											apprUKMersNumber = _tempFiles[curTempFileId].approximateUniqueKmers(
 													kMersNumber ? (double) uKMersNumber / kMersNumber : START_RATIO) * ratio / _tempFiles[curTempFileId].getNumberOfRuns();
 											//std::cout << "curTempFileId : " << curTempFileId << " curTempRun: " << curTempRun << std::endl;
-											KMCHT_setPartSize();
+											KMCHT_prefilter();
 											// reset timer
 											duration = ms(0);
 										}
@@ -473,13 +786,25 @@ namespace gerbil {
 									for (size_t i(0); i < HISTOGRAM_SIZE; ++i)
 										_histogram[i] += histogram[i];
 
+									_spilledNumber += inBuffer->getSpilledNumber() + outBuffer->getSpilledNumber();
+									if (candidates)
+										_prefilterSpilledNumber += candidates->getSpilledNumber();
+
+									if (perfCounters.isOpen()) {
+										_perfFill.add(tId, perfFill);
+										_perfExtract.add(tId, perfExtract);
+									}
+
 									delete kmb;
 									delete skmb;
 									delete curKmcBundle;
-									delete[] keys;
-									delete[] values;
+									HugePages::release(keys, keys_B);
+									HugePages::release(values, maxPartSize * counterSize_B);
 									delete inBuffer;
 									delete outBuffer;
+									delete candidates;
+									_failureTableKMersNumber += failureTable->getKMersNumber();
+									delete failureTable;
 
 									_kMersNumber += kMersNumber;
 									_uKMersNumber += uKMersNumber;
@@ -489,7 +814,10 @@ namespace gerbil {
 
 									__sync_add_and_fetch(&_maxSizeUsage, maxPartSizeUsage);
 
-									IF_HT_FAILS(_fKMersNumber += fKMersNumber;)
+									_fKMersNumber += fKMersNumber;
+									_probesNumber += probes;
+									_overflowNumber += overflowNumber;
+									_singletonsNumber += singletonsNumber;
 									IF_HT_JUMPS(_jumps += jumps;)
 									IF_MESS_SUPERREADER(
 											sw.stop();
@@ -500,8 +828,8 @@ namespace gerbil {
 			}
 		}
 
-		template<unsigned K>
-		inline void HasherTask<K>::join() {
+		template<unsigned K, typename H>
+		inline void HasherTask<K, H>::join() {
 			for (uint i = 0; i < _threadsNumber; ++i) {
 				_threads[i]->join();
 				delete _threads[i];
@@ -520,13 +848,9 @@ IF_HT_HISTO(
 		}
 
 // private
-		template<unsigned K>
-		uint32 HasherTask<K>::getMaxSteps() const {
-			uint32 ms = 5;
-			uint64 mp = _maxPartSize;
-			while (mp >>= 1)
-				++ms;
-			return ms;
+		template<unsigned K, typename H>
+		uint32 HasherTask<K, H>::getMaxSteps() const {
+			return getMaxProbeSteps(_maxPartSize);
 		}
 
 	}
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define FAILUREBUFFER_H_
 
 #include "Bundle.h"
+#include <algorithm>
 
 namespace gerbil {
 namespace cpu {
@@ -45,6 +46,7 @@ class FailureBuffer {
 	typedef enum {fs_close, fs_rom, fs_wom} TFileState;
 	TFileState _fileState;
 	uint64 _storedNumber;
+	uint64 _spilledNumber;			// total number of bundles stored on disk (not reset by clear)
 
 	void storeCurrentBundleToDisk();
 	bool loadCurrentBundleFromDisk();
@@ -56,9 +58,13 @@ public:
 
 	void clear();
 	inline uint64 getAmount() const;
+	inline uint64 getSpilledNumber() const { return _spilledNumber; }
 
-	// store
-	void addKMer(const KMer<K> &kMer);
+	// store (with the hash of the k-mer, kept by bundles with hashes)
+	void addKMer(const KMer<K> &kMer, const uint64 &hash);
+
+	// store a k-mer as stored by a KMerBundle (KMerBundle<K>::kMerSize_B() bytes)
+	void addKMerBytes(const byte *kMer, const uint64 &hash);
 
 	// read
 	bool getNextKMerBundle(KMerBundle<K>* &kMerBundle);
@@ -75,6 +81,7 @@ void FailureBuffer<K>::storeCurrentBundleToDisk() {
 	_currentBundle->store(_file);
 	_currentBundle->clear();
 	++_storedNumber;
+	++_spilledNumber;
 }
 
 template<unsigned K>
@@ -106,6 +113,7 @@ FailureBuffer<K>::FailureBuffer(const size_t &maxBufferSize, std::string pPath,
 	_file = 0;
 	_filePath = pPath + "fails" + std::to_string(pId) + "_" + std::to_string(pNr);
 	_fileState = fs_close;
+	_spilledNumber = 0;
 	clear();
 }
 
@@ -144,15 +152,29 @@ inline uint64 FailureBuffer<K>::getAmount() const {
 
 // save kMer
 template<unsigned K>
-void FailureBuffer<K>::addKMer(const KMer<K> &kMer) {
-	if(!_currentBundle->add(kMer)) {
+void FailureBuffer<K>::addKMer(const KMer<K> &kMer, const uint64 &hash) {
+	if(!_currentBundle->add(kMer, hash)) {
 		if(_top != _end) {	// save in buffer
 			std::swap(*_top, _currentBundle);
 			++_top;
 		}
 		else	// save on disk
 			storeCurrentBundleToDisk();
-		_currentBundle->add(kMer);
+		_currentBundle->add(kMer, hash);
+	}
+	++_amount;
+}
+
+template<unsigned K>
+void FailureBuffer<K>::addKMerBytes(const byte *kMer, const uint64 &hash) {
+	if(!_currentBundle->addBytes(kMer, hash)) {
+		if(_top != _end) {	// save in buffer
+			std::swap(*_top, _currentBundle);
+			++_top;
+		}
+		else	// save on disk
+			storeCurrentBundleToDisk();
+		_currentBundle->addBytes(kMer, hash);
 	}
 	++_amount;
 }
@@ -172,6 +194,145 @@ bool FailureBuffer<K>::getNextKMerBundle(KMerBundle<K>* &kMerBundle) {
 
 }
 
+/**
+ * second-level hash table of the k-mers which did not fit into the hash table of a cpu hasher
+ * (maxSteps exceeded), they are counted in memory instead of in further passes over a FailureBuffer
+ * linear probing, keys as stored by a KMerBundle (KMerBundle<K>::kMerSize_B() bytes), empty entries have the count 0
+ * grows as long as the memory budget allows (mc_hashTables), afterwards new k-mers are refused until clear()
+ * (they go to the FailureBuffer, a k-mer is either in the table or in the buffer)
+ * unsafe (single thread only)
+ */
+template<unsigned K>
+class FailureTable {
+	const uint32 _kMerSize_B;
+	uint64 _capacity;				// number of entries (power of 2)
+	uint32 _shift;					// 64 - log2(_capacity)
+	uint64 _size;					// number of k-mers
+	byte* _keys;
+	uint_cv* _counts;
+	bool _full;						// growth was refused
+	uint64 _kMersNumber;			// total number of k-mers (not reset by clear)
+
+	inline uint64 getMemory_B(const uint64 &capacity) const {
+		// (comparisons read up to 7 bytes behind a key)
+		return capacity * _kMerSize_B + sizeof(uint64) + capacity * sizeof(uint_cv);
+	}
+
+	inline uint64 getPos(const byte* const kMer) const {
+		uint64 h = 0, w;
+		for(uint32 i = 0; i < _kMerSize_B; i += 8) {
+			w = 0;
+			memcpy(&w, kMer + i, std::min<uint32>(sizeof(uint64), _kMerSize_B - i));
+			h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+			h ^= h >> 32;
+		}
+		return (h * 0xbf58476d1ce4e5b9ULL) >> _shift;
+	}
+
+	void allocate(const uint64 &capacity);
+	void release();
+	bool grow();
+public:
+	FailureTable();
+	~FailureTable();
+
+	// counts a k-mer, a new k-mer only if insert, returns false if the k-mer was not counted
+	inline bool add(const byte* const kMer, const bool &insert = true);
+
+	// empties the table and shrinks it to FAILURETABLE_MIN_SIZE
+	void clear();
+
+	inline uint64 getCapacity() const { return _capacity; }
+	inline uint64 getSize() const { return _size; }
+	inline uint64 getKMersNumber() const { return _kMersNumber; }
+	inline const uint_cv &getCount(const uint64 &pos) const { return _counts[pos]; }
+	inline const byte* getKMer(const uint64 &pos) const { return _keys + pos * _kMerSize_B; }
+};
+
+template<unsigned K>
+void FailureTable<K>::allocate(const uint64 &capacity) {
+	_capacity = capacity;
+	_shift = 64 - __builtin_ctzll(capacity);
+	_keys = (byte*) HugePages::allocate(capacity * _kMerSize_B + sizeof(uint64));
+	_counts = (uint_cv*) HugePages::allocate(capacity * sizeof(uint_cv));
+	memset(_counts, 0, capacity * sizeof(uint_cv));
+}
+
+template<unsigned K>
+void FailureTable<K>::release() {
+	HugePages::release(_keys, _capacity * _kMerSize_B + sizeof(uint64));
+	HugePages::release(_counts, _capacity * sizeof(uint_cv));
+	MemoryTracker::release(mc_hashTables, getMemory_B(_capacity));
+}
+
+template<unsigned K>
+bool FailureTable<K>::grow() {
+	if(!MemoryTracker::tryAcquire(mc_hashTables, getMemory_B(2 * _capacity))) {
+		_full = true;
+		return false;
+	}
+	const uint64 oldCapacity = _capacity;
+	byte* const oldKeys = _keys;
+	uint_cv* const oldCounts = _counts;
+	allocate(2 * oldCapacity);
+	for(uint64 i = 0; i < oldCapacity; ++i)
+		if(oldCounts[i]) {
+			uint64 pos = getPos(oldKeys + i * _kMerSize_B);
+			while(_counts[pos])
+				pos = (pos + 1) & (_capacity - 1);
+			memcpy(_keys + pos * _kMerSize_B, oldKeys + i * _kMerSize_B, _kMerSize_B);
+			_counts[pos] = oldCounts[i];
+		}
+	HugePages::release(oldKeys, oldCapacity * _kMerSize_B + sizeof(uint64));
+	HugePages::release(oldCounts, oldCapacity * sizeof(uint_cv));
+	MemoryTracker::release(mc_hashTables, getMemory_B(oldCapacity));
+	return true;
+}
+
+template<unsigned K>
+FailureTable<K>::FailureTable() : _kMerSize_B(KMerBundle<K>::kMerSize_B()), _size(0), _full(false), _kMersNumber(0) {
+	MemoryTracker::acquire(mc_hashTables, getMemory_B(FAILURETABLE_MIN_SIZE));
+	allocate(FAILURETABLE_MIN_SIZE);
+}
+
+template<unsigned K>
+FailureTable<K>::~FailureTable() {
+	release();
+}
+
+template<unsigned K>
+inline bool FailureTable<K>::add(const byte* const kMer, const bool &insert) {
+	uint64 pos = getPos(kMer);
+	while(_counts[pos]) {
+		if(isEqualKMerBytes(_keys + pos * _kMerSize_B, kMer, _kMerSize_B)) {
+			++_counts[pos];
+			return true;
+		}
+		pos = (pos + 1) & (_capacity - 1);
+	}
+	if(!insert || _full)
+		return false;
+	if(_size + 1 > _capacity * FAILURETABLE_FILL)
+		return grow() && add(kMer, insert);
+	memcpy(_keys + pos * _kMerSize_B, kMer, _kMerSize_B);
+	_counts[pos] = 1;
+	++_size;
+	++_kMersNumber;
+	return true;
+}
+
+template<unsigned K>
+void FailureTable<K>::clear() {
+	if(_capacity > FAILURETABLE_MIN_SIZE) {
+		release();
+		MemoryTracker::acquire(mc_hashTables, getMemory_B(FAILURETABLE_MIN_SIZE));
+		allocate(FAILURETABLE_MIN_SIZE);
+	} else if(_size)
+		memset(_counts, 0, _capacity * sizeof(uint_cv));
+	_size = 0;
+	_full = false;
+}
+
 }
 
 
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define FASTPARSER_H_
 
 #include "SyncQueue.h"
+#include "Telemetry.h"
 #include "Bundle.h"
 #include "global.h"
 
@@ -194,6 +195,11 @@ namespace gerbil {
 		 */
 		void print();
 
+		/*
+		 * adds the statistic to the telemetry report
+		 */
+		void report(TelemetryStage &stage);
+
 		/*
 		 * destructor
 		 */
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "global.h"
 #include "SyncQueue.h"
+#include "Telemetry.h"
 #include "Bundle.h"
 #include "FastFile.h"
 
@@ -52,6 +53,7 @@ namespace gerbil {
 		std::thread **_processThreads;                     // worker threads
 
 		std::atomic<uint64> _totalBlocksRead;              // total number of blocks which have been read
+		std::atomic<uint64> _progressBytes;                // bytes of the files which have been read (compressed size)
 
 		uint8 _threadsNumber;                              // number of threads
 
@@ -84,6 +86,9 @@ namespace gerbil {
 
 		SyncSwapQueueSPSC<FastBundle> **getSyncSwapQueues(); // returns the list of SyncSwapQueues
 		TFileType getFileType() const;                       // returns the file type
+		uint64 getApprBasesNumber() const;                   // returns the approximate number of bases
+		uint64 getProgressBytes() const;                     // returns the number of bytes read so far (progress)
+		uint64 getTotalBytes() const;                        // returns the total size of all files
 
 		/*
 		 * starts the entire working process
@@ -95,6 +100,11 @@ namespace gerbil {
 		 */
 		void print();
 
+		/*
+		 * adds the statistic to the telemetry report
+		 */
+		void report(TelemetryStage &stage);
+
 		/*
 		 * joins all threads
 		 */
@@ -0,0 +1,74 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef HUGEPAGES_H_
+#define HUGEPAGES_H_
+
+#include "types.h"
+
+namespace gerbil {
+
+class TelemetryStage;
+
+typedef enum {
+	hp_none,            // new/delete
+	hp_transparent,     // anonymous mappings with madvise(MADV_HUGEPAGE)
+	hp_2m,              // MAP_HUGETLB 2 MB pages, fallback: transparent
+	hp_1g               // MAP_HUGETLB 1 GB pages (large tables only), fallback: 2 MB
+} THugePages;
+
+/*
+ * huge page backed memory of the hash tables and the KMerBundle pools
+ * mapped memory is zero and untouched (first touch decides the numa node)
+ * a failing mapping falls back to the next smaller page size, finally to normal pages
+ */
+class HugePages {
+public:
+	static void setMode(const THugePages &mode);
+
+	static THugePages getMode();
+
+	// large allocation (e.g. a hash table), never NULL
+	static void* allocate(const uint64 &size_B);
+
+	static void release(void* p, const uint64 &size_B);
+
+	// small allocation of a bundle pool (e.g. KMerBundle data), taken from 2 MB slabs
+	static void* allocateBlock(const uint64 &size_B);
+
+	static void releaseBlock(void* p, const uint64 &size_B);
+
+	// bytes mapped so far with pages of a mode (hp_none: 0)
+	static uint64 getMapped_B(const THugePages &mode);
+
+	// mappings which fell back to a smaller page size
+	static uint64 getFallbacksNumber();
+
+	static const char* getName(const THugePages &mode);
+
+	static void print();
+
+	static void report(TelemetryStage &stage);
+};
+
+}
+
+#endif /* HUGEPAGES_H_ */
@@ -24,13 +24,20 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "types.h"
 #include <atomic>
+#include <cstring>
 #include <xmmintrin.h>
 #include <algorithm>
 
 namespace gerbil {
 
+// k-mer types with a runtime k (k > MAX_STATIC_KMER_SIZE): KMER_DYN(c) holds 32 * (c - 1) <= k < 32 * c
+#define KMER_DYN_BASE 0x10000
+#define KMER_DYN(c) (KMER_DYN_BASE + (c))
+#define IS_KMER_DYN(k) ((k) >= KMER_DYN_BASE)
+#define GET_KMER_DYN_C(k) ((k) / 32 + 1)
+
 // number of bytes for k-mer
-#define GET_KMER_B(k) (k / 4 + 1)
+#define GET_KMER_B(k) (IS_KMER_DYN(k) ? 8 * ((k) - KMER_DYN_BASE) : (k) / 4 + 1)
 
 // k-mer type, use of 32 Bit structures if b <= 4, else 64 Bit structures
 #define GET_KMER_T(b) (b <= 4 ? 4 : 8)
@@ -46,10 +53,10 @@ namespace gerbil {
 
 	/*
 	 * empty template
-	 * general structure of KMers
+	 * general structure of KMers (T == 0: runtime k, 64 bit structures)
 	 */
-	template<unsigned K, unsigned B = GET_KMER_B(K), unsigned T = GET_KMER_T(B),
-			unsigned C = GET_KMER_C(B, T)>
+	template<unsigned K, unsigned B = GET_KMER_B(K), unsigned T = IS_KMER_DYN(K) ? 0 : GET_KMER_T(B),
+			unsigned C = GET_KMER_C(B, (T ? T : 8))>
 	struct KMer {
 	};
 
@@ -64,6 +71,13 @@ namespace gerbil {
 		static constexpr uint64_t _c_offset = 64 - (2 * (K % 32));
 		static constexpr uint64_t _c_mask =(uint64_t) 0xffffffffffffffff << _c_offset; // 0xffffffffffffffff << _c_offset;
 	public:
+		/*
+		 * size k of the k-mers
+		 */
+		static constexpr uint32 getK() {
+			return K;
+		}
+
 		/*
 		 * clears this KMer
 		 */
@@ -330,6 +344,223 @@ namespace gerbil {
 	};
 
 
+	/*
+	 * KMer with a runtime k (set once by setK), KMER_DYN(C)
+	 * --> T == 8 (T == 0 as marker)
+	 * --> 32 * (C - 1) <= k < 32 * C, layout of KMer<k> with T == 8 (k % 32 == 0: first block is unused)
+	 */
+	template<unsigned K, unsigned B, unsigned C>
+	struct KMer<K, B, 0, C> {
+		uint64_t data[C];
+		static uint32 _k;
+		static uint32 _c_offset;	// uint32: not aliased by the stores to data
+		static uint64_t _c_mask;
+	public:
+		/*
+		 * sets the size k of all k-mers of this type
+		 */
+		static inline void setK(const uint32 &k) {
+			_k = k;
+			_c_offset = 64 - (2 * (k % 32));
+			_c_mask = (k % 32) ? (uint64_t) 0xffffffffffffffff << _c_offset : 0;
+		}
+
+		/*
+		 * size k of the k-mers
+		 */
+		static inline uint32 getK() {
+			return _k;
+		}
+
+		/*
+		 * clears this KMer
+		 */
+		inline void clear() {
+			*data = KMER_EMPTY_T8;
+		}
+
+		/*
+		 * copy function
+		 */
+		inline void set(const KMer<K> &kMer) {
+			for (uint c = 0; c < C; ++c)
+				data[c] = kMer.data[c];
+		}
+
+		/*
+		 * fills the data of this KMer in dependence of the passed bytes (== sequence of bases, e.g. s-mer)
+		 */
+		inline void set(const byte *const &bytes) {
+			uint64 cd;
+			for (uint c(C); c--;) {
+				memcpy(&cd, bytes + 8 * (C - 1 - c), sizeof(uint64));
+				data[c] = __builtin_bswap64(cd);
+			}
+			// cleaning up unused space
+			*data &= _c_mask;
+		}
+
+		/*
+		 * fills the data of this KMer in dependence of the passed bytes (== sequence of bases, e.g. s-mer)
+		 * INVERSE k-mer
+		 */
+		inline void setInv(const byte *const &bytes) {
+			uint64 *p;
+			for (uint c = 0; c < C; ++c) {
+				// inverts the bases and reverses the bytes, the bases and the 2-bit blocks
+				memcpy(p = data + c, bytes + 8 * c, sizeof(uint64));
+				*p = ~*p;
+				*p = ((*p & 0xf0f0f0f0f0f0f0f0) >> 4)
+				     | ((*p & 0x0f0f0f0f0f0f0f0f) << 4);
+				*p = ((*p & 0xcccccccccccccccc) >> 2)
+				     | ((*p & 0x3333333333333333) << 2);
+			}
+			if (_k % 32) {
+				for (uint c = C; --c;) {
+					data[c] <<= _c_offset;
+					data[c] |= (data[c - 1] >> (2 * (_k % 32)));
+				}
+				data[0] <<= _c_offset;
+			} else {
+				for (uint c = C; --c;)
+					data[c] = data[c - 1];
+				*data = 0;
+			}
+		}
+
+		/*
+		 * sets the k-mer and the inverse k-mer
+		 */
+		static inline void set(const byte *const &bytes, KMer<K> &kMer,
+		                       KMer<K> &iKMer) {
+			kMer.set(bytes);
+			iKMer.setInv(bytes);
+		}
+
+		/*
+		 * returns a reference to the normalized KMer
+		 */
+		inline const KMer<K> &getNormalized(const KMer<K> &invKMer) const {
+			for (uint i = C - 1; i; i--)
+				if (data[i] < invKMer.data[i])
+					return *this;
+				else if (data[i] > invKMer.data[i])
+					return invKMer;
+			return data[0] < invKMer.data[0] ? *this : invKMer;
+		}
+
+		/*
+		 * shifts the whole k-mer and adds a new base
+		 */
+		inline void next(const uint8_t &b) {
+			if (C == 1 || _c_offset < 64) {
+				for (uint c = C - 1; c > 0; --c)
+					data[c] = (data[c] << 2) | (data[c - 1] >> 62);
+				data[0] = (data[0] << 2) | (((uint64) b) << _c_offset);
+			} else {
+				// entire first block is unused
+				for (uint c = C - 1; c > 1; --c)
+					data[c] = (data[c] << 2) | (data[c - 1] >> 62);
+				data[1] = (data[1] << 2) | b;
+			}
+		}
+
+		/*
+		 * shifts the whole inverse k-mer and adds a new base
+		 */
+		inline void nextInv(const uint8_t &b) {
+			for (uint c = 0; c < C - 1; ++c)
+				data[c] = (data[c] >> 2) | ((data[c + 1] & 0x3) << 62);
+			data[C - 1] >>= 2;
+			data[C - 1] |= ((uint64) (~b)) << 62;
+			*data &= _c_mask;
+		}
+
+		/*
+		 * checks, whether data are equal or not
+		 */
+		inline bool isEqual(const KMer<K> &kMer) const {
+			for (uint c = 0; c < C; ++c)
+				if (data[c] != kMer.data[c])
+					return false;
+			return true;
+		}
+
+		/*
+		 * checks, whether it is empty
+		 * DEPRECATED
+		 */
+		inline bool isEmpty() const {
+			return *data == KMER_EMPTY_T8;
+		}
+
+		/*
+		 * magic hash function for counting
+		 */
+		inline uint64_t getHash() const {
+			if (C == 1)
+				return ((*data >> _c_offset) * C_0 + C_1) % 849399569653;
+			uint64_t x = 0;
+			for(int c = 0; c<C; ++c) {
+				x += C_0 * x + data[c];
+			}
+			return x;
+		}
+
+		/*
+		 * second magic hash function for distribution on threads
+		 */
+		inline uint64_t getPartHash() const {
+			if (C == 1)
+				return ((*data >> _c_offset) * C_3 + C_4) % 849399569653;
+			const uint16_t * bytes = (uint16_t*) (data + (C == 2 ? 0 : 1));
+			uint64_t x = 0;
+			for(int i=0; i<8; i++) {
+				x += C_0 * x + bytes[i];
+			}
+			return x;
+		}
+
+		/*
+		 * opposite of set
+		 * returns a simple byte representation of this KMer
+		 */
+		inline void toByte(byte *const bytes) const {
+			uint64 cd;
+			for (uint c(C); --c;) {
+				cd = __builtin_bswap64(data[c]);
+				memcpy(bytes + 8 * (C - 1 - c), &cd, sizeof(uint64));
+			}
+			// first block (bytes of the last k % 32 bases)
+			cd = __builtin_bswap64(*data);
+			memcpy(bytes + 8 * (C - 1), &cd, ((_k & 0x1f) + 3) / 4);
+		}
+
+		/*
+		 * returns true if the data are equal
+		 */
+		inline bool operator==(const KMer<K, B, 0, C> &other) const {
+			return isEqual(other);
+		}
+
+		/*
+		 * returns true if the data are not equal
+		 */
+		inline bool operator!=(const KMer<K, B, 0, C> &other) const {
+			return !operator==(other);
+		}
+	};
+
+	template<unsigned K, unsigned B, unsigned C>
+	uint32 KMer<K, B, 0, C>::_k = 32 * (C - 1);
+
+	template<unsigned K, unsigned B, unsigned C>
+	uint32 KMer<K, B, 0, C>::_c_offset = 64;
+
+	template<unsigned K, unsigned B, unsigned C>
+	uint64_t KMer<K, B, 0, C>::_c_mask = 0;
+
+
 /*
  * KMer for 16 <= k <= 31
  * --> 5 <= B <= 8
@@ -342,6 +573,13 @@ namespace gerbil {
 		static constexpr uint64_t _c_offset = 64 - (2 * K);
 		static constexpr uint64_t _c_mask = 0xffffffffffffffff << _c_offset;
 	public:
+		/*
+		 * size k of the k-mers
+		 */
+		static constexpr uint32 getK() {
+			return K;
+		}
+
 		/*
 		 * clears this KMer
 		 */
@@ -518,6 +756,13 @@ namespace gerbil {
 		static constexpr uint32 _c_offset = 32 - (2 * K);
 		static constexpr uint32 _c_mask = 0xffffffff << _c_offset;
 	public:
+		/*
+		 * size k of the k-mers
+		 */
+		static constexpr uint32 getK() {
+			return K;
+		}
+
 		/*
 		 * clears this KMer
 		 */
@@ -650,9 +895,19 @@ namespace gerbil {
 
 	template<unsigned K, unsigned B, unsigned C>
 	bool operator<(const KMer<K, B, 8, C> &l, const KMer<K, B, 8, C> &r) {
-		for (uint i(1); i < C; ++i)
-			if (l.data[i] < r.data[i])
-				return true;
+		// lexicographic, most significant word (data[C - 1]) first
+		for (uint i = C - 1; i; --i)
+			if (l.data[i] != r.data[i])
+				return l.data[i] < r.data[i];
+		return *(l.data) < *(r.data);
+	}
+
+	template<unsigned K, unsigned B, unsigned C>
+	bool operator<(const KMer<K, B, 0, C> &l, const KMer<K, B, 0, C> &r) {
+		// lexicographic, most significant word (data[C - 1]) first
+		for (uint i = C - 1; i; --i)
+			if (l.data[i] != r.data[i])
+				return l.data[i] < r.data[i];
 		return *(l.data) < *(r.data);
 	}
 
@@ -672,7 +927,28 @@ namespace gerbil {
  */
 	template<unsigned K>
 	constexpr uint16 getKMerCompactByteNumbers() {
-		return (K + 3) >> 2;
+		return (KMer<K>::getK() + 3) >> 2;
+	}
+
+/*
+ * compares two stored k-mers of size_B bytes
+ * reads up to 7 bytes behind both
+ */
+	inline bool isEqualKMerBytes(const byte *const a, const byte *const b, const uint32 &size_B) {
+		uint64 x, y;
+		uint32 i = 0;
+		for (; i + 8 <= size_B; i += 8) {
+			memcpy(&x, a + i, sizeof(uint64));
+			memcpy(&y, b + i, sizeof(uint64));
+			if (x != y)
+				return false;
+		}
+		if (i == size_B)
+			return true;
+		// the remaining bytes are the low bytes of the words
+		memcpy(&x, a + i, sizeof(uint64));
+		memcpy(&y, b + i, sizeof(uint64));
+		return !((x ^ y) << (64 - 8 * (size_B - i)));
 	}
 
 /*
@@ -683,7 +959,7 @@ namespace gerbil {
 	void printKMer(const KMer<K> &kMer) {
 		byte *a = new byte[sizeof(KMer<K>)];
 		kMer.toByte(a);
-		printByteCodedSeqN(a, K);
+		printByteCodedSeqN(a, KMer<K>::getK());
 		delete[] a;
 	}
 
@@ -692,6 +968,8 @@ namespace gerbil {
  * DEPRECATED
  */
 	inline uint32 getKMerByteNumbers(const uint32_t &k) {
+		if (k > MAX_STATIC_KMER_SIZE)
+			return 8 * GET_KMER_DYN_C(k);
 		uint32 b = GET_KMER_B(k);
 		uint32 t = GET_KMER_T(b);
 		return GET_KMER_C(b, t) * t;
@@ -704,6 +982,14 @@ namespace gerbil {
 		return (k + 3) / 4;
 	}
 
+/*
+ * size of a k-mer in the KMerBundles and hash tables of the CPU hashers
+ * equal to cpu::KMerBundle<K>::kMerSize_B()
+ */
+	inline uint32_t getKMerStoredByteNumbers(const uint32_t &k) {
+		return KMER_PACKED ? getKMerCompactByteNumbers(k) : getKMerByteNumbers(k);
+	}
+
 }
 
 #endif /* KMER_H_ */
@@ -0,0 +1,214 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef KMEREXTRACTOR_H_
+#define KMEREXTRACTOR_H_
+
+#include "KMer.h"
+#include "KMerHash.h"
+#include <cstring>
+#include <vector>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace gerbil {
+
+/*
+ * extracts the k-mers and inverse k-mers of a super-mer word by word (k > 32)
+ * the super-mer and its reverse complement are shifted once to the four base offsets of a byte,
+ * each word of a k-mer is then a single byte aligned load, independent of the other k-mers
+ * (KMer::next and KMer::nextInv shift all words per base);
+ * the data of a k-mer are the byte reversed stream, reversed by SSSE3/AVX2 shuffles if available
+ */
+template<unsigned K>
+class KMerExtractor {
+	static constexpr uint32 _words = sizeof(KMer<K>) / sizeof(uint64);
+
+	// first word (data[0]) holds the last k % 32 bases in its high bits
+	static inline uint64 getMask() {
+		return (KMer<K>::getK() % 32) ? ~0ull << (64 - 2 * (KMer<K>::getK() % 32)) : 0;
+	}
+
+	std::vector<byte> _fwd[4];		// super-mer shifted by 0, 1, 2, 3 bases
+	std::vector<byte> _inv[4];		// reverse complement, shifted by 0, 1, 2, 3 bases
+	const byte* _fwdData[4];
+	const byte* _invData[4];
+	uint32 _invOffset;				// base of the inverse k-mer of k-mer 0 (in the reverse complement)
+
+	static inline uint64 load(const byte* p) {
+		uint64 word;
+		memcpy(&word, p, sizeof(uint64));
+		return __builtin_bswap64(word);
+	}
+
+	// k-mer at s (data[_words - 1] is the first word)
+	static inline void extract(const byte* s, KMer<K> &kMer) {
+		uint64* data = (uint64*) &kMer;
+		uint32 c = 0;
+#if defined(__AVX2__)
+		const __m256i reverse = _mm256_setr_epi8(
+				15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+				15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		for(; c + 4 <= _words; c += 4) {
+			const __m256i x = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*) (s + 8 * c)), reverse);
+			_mm256_storeu_si256((__m256i*) (data + _words - c - 4), _mm256_permute4x64_epi64(x, 0x4e));
+		}
+#endif
+#if defined(__AVX2__) || defined(__SSSE3__)
+		const __m128i reverse16 = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+		for(; c + 2 <= _words; c += 2)
+			_mm_storeu_si128((__m128i*) (data + _words - c - 2),
+					_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) (s + 8 * c)), reverse16));
+#endif
+		for(; c < _words; ++c)
+			data[_words - 1 - c] = load(s + 8 * c);
+		data[0] &= getMask();
+	}
+
+	inline const byte* getFwd(const uint32 &p) const {
+		return _fwdData[p & 0x3] + (p >> 2);
+	}
+
+	inline const byte* getInv(const uint32 &p) const {
+		const uint32 q = _invOffset - p;
+		return _invData[q & 0x3] + (q >> 2);
+	}
+
+	static inline void shift(std::vector<byte>* streams, const size_t &size) {
+		for(uint32 r = 1; r < 4; ++r) {
+			const byte* s = streams[0].data();
+			byte* d = streams[r].data();
+			for(size_t i = 0; i < size; ++i)
+				d[i] = (s[i] << 2 * r) | (s[i + 1] >> (8 - 2 * r));
+		}
+	}
+
+public:
+	KMerExtractor() : _fwdData(), _invData(), _invOffset(0) {}
+
+	// words are loaded if the k-mer has more than one word (single word k-mers are shifted per base)
+	static constexpr bool isWordParallel() { return _words > 1; }
+
+	// prepares the k-mers of the super-mer b with l bases
+	inline void load(const byte* b, const uint16 &l) {
+		const size_t size = (l + 3) >> 2;
+		const size_t padded = size + 8 * _words + 1;
+		if(_fwd[0].size() < padded)
+			for(uint32 r = 0; r < 4; ++r) {
+				_fwd[r].assign(padded, 0);
+				_inv[r].assign(padded, 0);
+				_fwdData[r] = _fwd[r].data();
+				_invData[r] = _inv[r].data();
+			}
+		memcpy(_fwd[0].data(), b, size);
+
+		// reverse complement of each byte (the bases after l end up in front of the first base)
+		for(size_t i = 0; i < size; ++i) {
+			byte x = ~b[size - 1 - i];
+			x = (x >> 4) | (x << 4);
+			_inv[0][i] = ((x & 0xcc) >> 2) | ((x & 0x33) << 2);
+		}
+		_invOffset = 4 * size - KMer<K>::getK();
+
+		shift(_fwd, size);
+		shift(_inv, size);
+	}
+
+	// k-mer p (0 <= p <= l - k)
+	inline void get(const uint32 &p, KMer<K> &kMer) const {
+		extract(getFwd(p), kMer);
+	}
+
+	// inverse k-mer p (reverse complement of k-mer p, as KMer::setInv)
+	inline void getInv(const uint32 &p, KMer<K> &iKMer) const {
+		extract(getInv(p), iKMer);
+	}
+
+	// normalized k-mer p (as KMer::getNormalized), only the words up to the first difference are compared
+	// (the strand is selected without a branch, it is random)
+	inline void getNormalized(const uint32 &p, KMer<K> &nKMer) const {
+		const byte* f = getFwd(p);
+		const byte* r = getInv(p);
+		uint64 fw = load(f), rw = load(r);
+		for(uint32 c = 1; fw == rw && c < _words; ++c) {
+			fw = load(f + 8 * c) & (c + 1 < _words ? ~0ull : getMask());
+			rw = load(r + 8 * c) & (c + 1 < _words ? ~0ull : getMask());
+		}
+		const uintptr_t select = -(uintptr_t) (fw < rw);
+		extract((const byte*) (((uintptr_t) f & select) | ((uintptr_t) r & ~select)), nKMer);
+	}
+};
+
+/*
+ * splits the super-mer b with l bases into its k-mers (normalized if NORM), add(kMer, fwd, rev) is called
+ * for each k-mer, fwd and rev are the rolled hashes of a rolling hash policy (0 otherwise)
+ * (the split of KmerHasher and of the AutoTuner calibration)
+ */
+template<unsigned K, bool NORM, typename F>
+inline void splitSuperMer(const byte* b, const uint16 &l, KMerExtractor<K> &extractor, F &&add) {
+	const uint32 k = KMer<K>::getK();
+	constexpr bool rolling = KMER_HASH_POLICY::isRolling<K>();
+	const bool wordParallel = KMerExtractor<K>::isWordParallel() && k >= KMER_EXTRACTOR_MIN_K;
+	KMer<K> kMer, iKMer;
+	uint64 fwd = 0, rev = 0;
+
+	if(rolling)
+		KMER_HASH_POLICY::init<K>(b, fwd, rev);
+	if(wordParallel)
+		extractor.load(b, l);
+	if(NORM) {
+		KMer<K>::set(b, kMer, iKMer);
+		add(kMer.getNormalized(iKMer), fwd, rev);
+	}
+	else {
+		kMer.set(b);
+		add(kMer, fwd, rev);
+	}
+	for(uint32 i = k; i < l; ++i) {
+		const byte nextBase = (*(b + (i >> 2)) >> (6 - ((i & 0x3) << 1))) & 0x3;
+		if(rolling)
+			KMER_HASH_POLICY::roll<K>(fwd, rev,
+					(*(b + ((i - k) >> 2)) >> (6 - (((i - k) & 0x3) << 1))) & 0x3, nextBase);
+		if(wordParallel) {
+			if(NORM)
+				extractor.getNormalized(i - k + 1, kMer);
+			else
+				extractor.get(i - k + 1, kMer);
+			add(kMer, fwd, rev);
+			continue;
+		}
+		kMer.next(nextBase);
+		if(NORM) {
+			iKMer.nextInv(nextBase);
+			add(kMer.getNormalized(iKMer), fwd, rev);
+		}
+		else
+			add(kMer, fwd, rev);
+	}
+}
+
+}
+
+#endif /* KMEREXTRACTOR_H_ */
@@ -0,0 +1,283 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef KMERHASH_H_
+#define KMERHASH_H_
+
+#include "KMer.h"
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace gerbil {
+
+/*
+ * hash policies of the hash tables (hash) and the KmerDistributer (partHash)
+ * both functions must be independent: a hasher only gets the k-mers of some buckets
+ * the default policy is KMER_HASH_POLICY (config.h)
+ * rolling policies (isRolling<K>()) update the hash per base while a super-mer is split,
+ * the hash is carried with the k-mer in the KMerBundle (no hashing in the hasher)
+ */
+
+// number of 64 bit words of a k-mer (a 32 bit k-mer is a single word)
+template<unsigned K>
+constexpr uint32 getKMerWordsNumber() {
+	return sizeof(KMer<K>) == 4 ? 1 : sizeof(KMer<K>) / 8;
+}
+
+// word c of the data of a k-mer (all bits, equal k-mers have equal words)
+template<unsigned K>
+inline uint64 getKMerWord(const KMer<K> &kMer, const uint32 &c) {
+	return sizeof(KMer<K>) == 4 ? *(const uint32*) &kMer : ((const uint64*) &kMer)[c];
+}
+
+/*
+ * interface of the rolling hash for policies which hash each k-mer from scratch
+ */
+struct KMerHashNotRolling {
+	template<unsigned K>
+	static constexpr bool isRolling() { return false; }
+
+	// state of the first k-mer of a super-mer (2 bit bases, 4 per byte)
+	template<unsigned K>
+	static inline void init(const byte* bases, uint64 &fwd, uint64 &rev) {}
+
+	// next k-mer: base out leaves, base in enters
+	template<unsigned K>
+	static inline void roll(uint64 &fwd, uint64 &rev, const uint8_t &out, const uint8_t &in) {}
+
+	static inline uint64 hashOf(const uint64 &fwd, const uint64 &rev) { return 0; }
+
+	static inline uint64 partHashOf(const uint64 &fwd, const uint64 &rev) { return 0; }
+};
+
+/*
+ * the original functions of KMer (multiply-add over the words, low mixing)
+ */
+struct KMerHashLegacy : public KMerHashNotRolling {
+	template<unsigned K>
+	static inline uint64 hash(const KMer<K> &kMer) {
+		return kMer.getHash();
+	}
+
+	template<unsigned K>
+	static inline uint64 partHash(const KMer<K> &kMer) {
+		return kMer.getPartHash();
+	}
+
+	static const char* getName() { return "legacy"; }
+};
+
+/*
+ * multiply-xorshift of wyhash: 64x64->128 bit product, folded (one product per two words)
+ */
+struct KMerHashMix : public KMerHashNotRolling {
+	static inline uint64 mum(const uint64 &a, const uint64 &b) {
+		const __uint128_t r = (__uint128_t) a * b;
+		return (uint64) r ^ (uint64) (r >> 64);
+	}
+
+	template<unsigned K>
+	static inline uint64 mix(const KMer<K> &kMer, uint64 h) {
+		uint32 c = 0;
+		for(; c + 1 < getKMerWordsNumber<K>(); c += 2)
+			h = mum(getKMerWord<K>(kMer, c) ^ 0xa0761d6478bd642full, getKMerWord<K>(kMer, c + 1) ^ h);
+		if(c < getKMerWordsNumber<K>())
+			h = mum(getKMerWord<K>(kMer, c) ^ 0xa0761d6478bd642full, h ^ 0xe7037ed1a0b428dbull);
+		return h;
+	}
+
+	template<unsigned K>
+	static inline uint64 hash(const KMer<K> &kMer) {
+		return mix<K>(kMer, 0x8ebc6af09c88c6e3ull);
+	}
+
+	template<unsigned K>
+	static inline uint64 partHash(const KMer<K> &kMer) {
+		return mix<K>(kMer, 0x589965cc75374cc3ull);
+	}
+
+	static const char* getName() { return "mix"; }
+};
+
+/*
+ * CRC32C of the words (SSE4.2 if compiled with -msse4.2, otherwise a table)
+ * 32 bits spread by a multiplication; partHash uses the byte swapped words,
+ * a second seed would only xor a constant (crc is linear)
+ */
+struct KMerHashCrc32c : public KMerHashNotRolling {
+	static inline uint32 crc(uint32 crc, const uint64 &word) {
+#ifdef __SSE4_2__
+		return _mm_crc32_u64(crc, word);
+#else
+		static const struct Table {
+			uint32 entries[256];
+			Table() {
+				for(uint32 i = 0; i < 256; ++i) {
+					uint32 c = i;
+					for(uint32 j = 0; j < 8; ++j)
+						c = c & 1 ? (c >> 1) ^ 0x82f63b78 : c >> 1;
+					entries[i] = c;
+				}
+			}
+		} table;
+		for(uint32 i = 0; i < 8; ++i)
+			crc = table.entries[(crc ^ (word >> (8 * i))) & 0xff] ^ (crc >> 8);
+		return crc;
+#endif
+	}
+
+	template<unsigned K>
+	static inline uint64 hash(const KMer<K> &kMer) {
+		uint32 h = 0xffffffff;
+		for(uint32 c = 0; c < getKMerWordsNumber<K>(); ++c)
+			h = crc(h, getKMerWord<K>(kMer, c));
+		return h * 0x9e3779b97f4a7c15ull;
+	}
+
+	template<unsigned K>
+	static inline uint64 partHash(const KMer<K> &kMer) {
+		uint32 h = 0xffffffff;
+		for(uint32 c = 0; c < getKMerWordsNumber<K>(); ++c)
+			h = crc(h, __builtin_bswap64(getKMerWord<K>(kMer, c)));
+		return h;
+	}
+
+	static const char* getName() { return "crc32c"; }
+};
+
+/*
+ * canonical ntHash (forward + reverse complement strand) for multi-word k-mers,
+ * a rolled hash costs O(1) per base instead of O(C) per k-mer; single word k-mers use KMerHashMix
+ * the states are multiplied by x in GF(2^64) (primitive x^64 + x^4 + x^3 + x + 1) instead of rotated,
+ * the powers of x do not repeat (period 2^64 - 1): with a 64 bit rotation, equal bases 64 apart cancel,
+ * with the split rotation of ntHash2 (33/31 bits), two equal substitutions 33 apart give the same state
+ * as the pair 31 bases further
+ */
+struct KMerHashNt {
+	// v * x
+	static inline uint64 mulx(const uint64 &v) {
+		return (v << 1) ^ (-(v >> 63) & 0x1bull);
+	}
+
+	// v / x
+	static inline uint64 divx(const uint64 &v) {
+		return (v >> 1) ^ (-(v & 1) & 0x800000000000000dull);
+	}
+
+	static inline uint64 seed(const uint8_t &base) {
+		static const uint64 seeds[4] = {
+				0x3c8bfbb395c60474ull, 0x3193c18562a02b4cull, 0x20323ed082572324ull, 0x295549f54be24456ull};
+		return seeds[base];
+	}
+
+	// seed(base) * x^n (n <= MAX_KMER_SIZE)
+	static inline uint64 seed(const uint8_t &base, const uint32 &n) {
+		static const struct Table {
+			uint64 entries[MAX_KMER_SIZE + 1][4];
+			Table() {
+				for(uint8_t b = 0; b < 4; ++b) {
+					uint64 v = seed(b);
+					for(uint32 i = 0; i <= MAX_KMER_SIZE; ++i, v = mulx(v))
+						entries[i][b] = v;
+				}
+			}
+		} table;
+		return table.entries[n][base];
+	}
+
+	template<unsigned K>
+	static constexpr bool isRolling() { return getKMerWordsNumber<K>() > 1; }
+
+	// fwd = xor of seed(base i) * x^(K - 1 - i), rev = xor of seed(3 - base i) * x^i (Horner)
+	template<unsigned K>
+	static inline void init(const byte* bases, uint64 &fwd, uint64 &rev) {
+		const uint32 k = KMer<K>::getK();
+		fwd = rev = 0;
+		for(uint32 i = 0; i < k; ++i) {
+			const uint8_t base = (bases[i >> 2] >> (6 - ((i & 0x3) << 1))) & 0x3;
+			fwd = mulx(fwd) ^ seed(base);
+			rev = divx(rev) ^ seed(3 - base);
+		}
+		for(uint32 i = 1; i < k; ++i)
+			rev = mulx(rev);
+	}
+
+	template<unsigned K>
+	static inline void roll(uint64 &fwd, uint64 &rev, const uint8_t &out, const uint8_t &in) {
+		fwd = mulx(fwd) ^ seed(out, KMer<K>::getK()) ^ seed(in);
+		rev = divx(rev ^ seed(3 - out)) ^ seed(3 - in, KMer<K>::getK() - 1);
+	}
+
+	// both states are mixed (ordered, the same for both strands), a sum of the states lets near-palindromic
+	// k-mers collide whose states only cancel in the sum
+	static inline uint64 hashOf(const uint64 &fwd, const uint64 &rev) {
+		return KMerHashMix::mum(std::min(fwd, rev) ^ 0xa0761d6478bd642full, std::max(fwd, rev) ^ 0x8ebc6af09c88c6e3ull);
+	}
+
+	static inline uint64 partHashOf(const uint64 &fwd, const uint64 &rev) {
+		return KMerHashMix::mum(std::min(fwd, rev) ^ 0xe7037ed1a0b428dbull, std::max(fwd, rev) ^ 0x589965cc75374cc3ull);
+	}
+
+	// from scratch (equal to the rolled hash of the k-mer and of its reverse complement)
+	// (the first base is the highest of the last word, data[0] holds the last K % 32 bases in its high bits,
+	// none if K % 32 == 0)
+	template<unsigned K>
+	static inline void getState(const KMer<K> &kMer, uint64 &fwd, uint64 &rev) {
+		const uint32 k = KMer<K>::getK();
+		fwd = rev = 0;
+		for(uint32 c = getKMerWordsNumber<K>(); c--;) {
+			uint64 word = getKMerWord<K>(kMer, c);
+			for(uint32 j = c ? 32 : k % 32; j--; word <<= 2) {
+				const uint8_t base = word >> 62;
+				fwd = mulx(fwd) ^ seed(base);
+				rev = divx(rev) ^ seed(3 - base);
+			}
+		}
+		for(uint32 i = 1; i < k; ++i)
+			rev = mulx(rev);
+	}
+
+	template<unsigned K>
+	static inline uint64 hash(const KMer<K> &kMer) {
+		if(!isRolling<K>())
+			return KMerHashMix::hash<K>(kMer);
+		uint64 fwd, rev;
+		getState<K>(kMer, fwd, rev);
+		return hashOf(fwd, rev);
+	}
+
+	template<unsigned K>
+	static inline uint64 partHash(const KMer<K> &kMer) {
+		if(!isRolling<K>())
+			return KMerHashMix::partHash<K>(kMer);
+		uint64 fwd, rev;
+		getState<K>(kMer, fwd, rev);
+		return partHashOf(fwd, rev);
+	}
+
+	static const char* getName() { return "nthash"; }
+};
+
+}
+
+#endif /* KMERHASH_H_ */
@@ -0,0 +1,179 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef KMERQUOTIENT_H_
+#define KMERQUOTIENT_H_
+
+#include "KMer.h"
+
+namespace gerbil {
+
+/*
+ * quotient keys of the hash tables of the CPU hashers (Application::setQuotientKeys)
+ *
+ * the head of a packed k-mer (its first min(2k, 64) bits) is xored with a hash of the rest
+ * (k > 32 only) and permuted (invertible), which gives x = q * partSize + home
+ * home is the first probe of the k-mer, a key only stores q and the probe step s of its entry:
+ *   [q << 6 | s (little endian, quotient bytes)][rest of the packed k-mer]
+ * the home of an entry at pos is pos - (1^2 + ... + s^2) (quadratic probing), so the k-mer is restored
+ * from the key and its position, equal k-mers have equal keys at the same position
+ */
+
+#define KMER_QUOTIENT_STEP_BITS 6
+#define KMER_QUOTIENT_MAX_STEPS ((1 << KMER_QUOTIENT_STEP_BITS) - 1)
+
+// bits of the head of a k-mer
+inline uint32 getKMerQuotientHeadBits(const uint32 &k) {
+	return k < 32 ? 2 * k : 64;
+}
+
+/*
+ * size of a quotient key of a k-mer in a table of partSize entries
+ * (never more than getKMerCompactByteNumbers(k))
+ */
+inline uint32 getKMerQuotientByteNumbers(const uint32 &k, const uint64 &partSize) {
+	uint32 log2PartSize = 0;
+	for (uint64 p = partSize; p >>= 1;)
+		++log2PartSize;
+	const uint32 headBits = getKMerQuotientHeadBits(k);
+	const uint32 qBits = headBits > log2PartSize ? headBits - log2PartSize : 0;
+	return (qBits + KMER_QUOTIENT_STEP_BITS + 7) / 8 + (headBits == 64 ? getKMerCompactByteNumbers(k) - 8 : 0);
+}
+
+template<unsigned K>
+class KMerQuotient {
+	uint32 _kMerSize_B;         // packed k-mer
+	uint32 _headBits;
+	uint32 _shift;              // of the xorshifts, at least half of the head
+	uint64 _headMask;
+	uint64 _partSize;
+	uint32 _qSize_B;            // bytes of q and s
+	uint64 _qMask;
+	uint32 _keySize_B;
+
+	static constexpr uint64 M1 = 0xbf58476d1ce4e5b9ULL;
+	static constexpr uint64 M2 = 0x94d049bb133111ebULL;
+	uint64 _m1Inv, _m2Inv;      // modular inverses (mod 2^64, therefore mod 2^headBits)
+
+	static inline uint64 inverse(const uint64 &m) {
+		uint64 inv = m;
+		for (uint32 i = 0; i < 5; ++i)
+			inv *= 2 - m * inv;
+		return inv;
+	}
+
+	// hash of the bytes behind the head (k > 32)
+	inline uint64 getRestHash(const byte *const rest) const {
+		uint64 h = 0, w;
+		const uint32 restSize_B = _kMerSize_B - 8;
+		for (uint32 i = 0; i < restSize_B; i += 8) {
+			memcpy(&w, rest + i, sizeof(uint64));
+			if (restSize_B - i < 8)
+				w &= ~0ULL >> (64 - 8 * (restSize_B - i));
+			h = (h ^ w) * M2;
+			h ^= h >> 32;
+		}
+		return h;
+	}
+
+	inline uint64 permute(uint64 x) const {
+		x ^= x >> _shift;
+		x = (x * M1) & _headMask;
+		x ^= x >> _shift;
+		x = (x * M2) & _headMask;
+		return x ^ (x >> _shift);
+	}
+
+	inline uint64 unpermute(uint64 x) const {
+		x ^= x >> _shift;
+		x = (x * _m2Inv) & _headMask;
+		x ^= x >> _shift;
+		x = (x * _m1Inv) & _headMask;
+		return x ^ (x >> _shift);
+	}
+
+public:
+	KMerQuotient() :
+			_kMerSize_B(getKMerCompactByteNumbers<K>()), _headBits(getKMerQuotientHeadBits(KMer<K>::getK())),
+			_shift((_headBits + 1) / 2), _headMask(_headBits == 64 ? ~0ULL : (1ULL << _headBits) - 1),
+			_m1Inv(inverse(M1)), _m2Inv(inverse(M2)) {
+		setPartSize(128);
+	}
+
+	// size of the table (entries)
+	inline void setPartSize(const uint64 &partSize) {
+		_partSize = partSize;
+		_keySize_B = getKMerQuotientByteNumbers(KMer<K>::getK(), partSize);
+		_qSize_B = _keySize_B - (_headBits == 64 ? _kMerSize_B - 8 : 0);
+		_qMask = _qSize_B == 8 ? ~0ULL : (1ULL << (8 * _qSize_B)) - 1;
+	}
+
+	inline const uint32 &getKeySize_B() const {
+		return _keySize_B;
+	}
+
+	// key (step 0) and home of a packed k-mer, returns its hash x
+	// reads and writes up to 7 bytes behind the k-mer / key
+	inline uint64 encode(const byte *const kMer, byte *const key, uint64 &home) const {
+		uint64 head;
+		memcpy(&head, kMer, sizeof(uint64));
+		head = __builtin_bswap64(head) >> (64 - _headBits);
+		if (_headBits == 64)
+			head ^= getRestHash(kMer + 8);
+		const uint64 x = permute(head);
+		home = x % _partSize;
+		const uint64 q = (x / _partSize) << KMER_QUOTIENT_STEP_BITS;
+		// (the rest overwrites the bytes behind q)
+		memcpy(key, &q, sizeof(uint64));
+		if (_headBits == 64)
+			memcpy(key + _qSize_B, kMer + 8, _kMerSize_B - 8);
+		return x;
+	}
+
+	// sets the probe step of a key
+	inline void setStep(byte *const key, const uint64 &step) const {
+		*key = (*key & ~KMER_QUOTIENT_MAX_STEPS) | step;
+	}
+
+	// restores the packed k-mer of the key at pos, reads and writes up to 7 bytes behind the key / k-mer
+	inline void decode(const byte *const key, const uint64 &pos, byte *const kMer) const {
+		uint64 q;
+		memcpy(&q, key, sizeof(uint64));
+		q &= _qMask;
+		const uint64 step = q & KMER_QUOTIENT_MAX_STEPS;
+		const uint64 offset = (step * (step + 1) * (2 * step + 1) / 6) % _partSize;
+		const uint64 home = pos >= offset ? pos - offset : pos + _partSize - offset;
+		uint64 head = unpermute((q >> KMER_QUOTIENT_STEP_BITS) * _partSize + home);
+		if (_headBits == 64) {
+			head ^= getRestHash(key + _qSize_B);
+			memcpy(kMer + 8, key + _qSize_B, _kMerSize_B - 8);
+			head = __builtin_bswap64(head);
+			memcpy(kMer, &head, sizeof(uint64));
+		} else {
+			head = __builtin_bswap64(head << (64 - _headBits));
+			memcpy(kMer, &head, sizeof(uint64));
+		}
+	}
+};
+
+}
+
+#endif /* KMERQUOTIENT_H_ */
@@ -0,0 +1,88 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef KMCCONSUMER_H_
+#define KMCCONSUMER_H_
+
+#include <functional>
+
+#include "Bundle.h"
+
+namespace gerbil {
+
+/*
+ * receives counted k-mers while run2 extracts them (instead of collecting them in listKmer)
+ * all methods are called by the single KmcWriter thread
+ */
+class KmcConsumer {
+public:
+	virtual ~KmcConsumer() {}
+
+	// called for each filled KmcBundle, the bundle is reused after the call returns
+	virtual void consume(const KmcBundle &kmcBundle) = 0;
+
+	// called once after the last bundle
+	virtual void finish() {}
+};
+
+/*
+ * decodes each k-mer to a base string and passes it with its counter to a callback
+ * only k-mers with lowerBound <= counter <= upperBound are passed
+ */
+class KmcCallbackConsumer : public KmcConsumer {
+public:
+	typedef std::function<void(const char* kMerSeq, const uint32 &counter)> TCallback;
+private:
+	uint32 _k;
+	uint32 _lowerBound;
+	uint32 _upperBound;
+	TCallback _callback;
+	char* _kMerSeq;
+public:
+	KmcCallbackConsumer(const uint32 &k, TCallback callback,
+			const uint32 &lowerBound = 0, const uint32 &upperBound = (uint32) -1) :
+			_k(k), _lowerBound(lowerBound), _upperBound(upperBound), _callback(callback) {
+		_kMerSeq = new char[_k + 1];
+		_kMerSeq[_k] = '\0';
+	}
+
+	~KmcCallbackConsumer() {
+		delete[] _kMerSeq;
+	}
+
+	void consume(const KmcBundle &kmcBundle) {
+		const byte* p = kmcBundle.getData();
+		const byte* end = p + kmcBundle.getSize();
+		const byte* kMer;
+		uint32 counter;
+		while(p < end) {
+			p = KmcBundle::nextRecord(p, _k, counter, kMer);
+			if(counter >= _lowerBound && counter <= _upperBound) {
+				KmcBundle::toSequence(kMer, _k, _kMerSeq);
+				_callback(_kMerSeq, counter);
+			}
+		}
+	}
+};
+
+}
+
+#endif /* KMCCONSUMER_H_ */
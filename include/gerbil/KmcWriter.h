@@ -24,6 +24,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "SyncQueue.h"
 #include "Bundle.h"
+#include "KmcConsumer.h"
+#include "Telemetry.h"
 
 namespace gerbil {
 
@@ -36,13 +38,20 @@ class KmcWriter {
 	uint32_t _k;
 	TOutputFormat _outputFormat;
 	std::vector<std::pair<std::string,uint32> > *listKmer;
+	KmcConsumer* _consumer;					// receives all bundles instead of listKmer (optional)
 
 	SyncSwapQueueMPSC<KmcBundle>* _kmcSyncSwapQueue;
 
 	uint64_t _fileSize;
+	uint64_t _kmcBundlesNumber;				// number of non-empty KmcBundles
+	uint64_t _kmcBundlesSize;				// size of all KmcBundles
+
+	// writes the offsets of all record boundaries at bundle starts to <fileName>.idx (used by toFasta)
+	void writeChunkIndex(const std::vector<uint64_t> &chunkIndex);
 public:
 	KmcWriter(int _upperBound, int _lowerBound,std::string fileName,
-			SyncSwapQueueMPSC<KmcBundle>* kmcSyncSwapQueue, const uint32_t &k, const TOutputFormat pOutputFormat);
+			SyncSwapQueueMPSC<KmcBundle>* kmcSyncSwapQueue, const uint32_t &k, const TOutputFormat pOutputFormat,
+			KmcConsumer* consumer = NULL);
 	~KmcWriter();
 	
 	std::vector<std::pair<std::string,uint32>> *getListKmer(){
@@ -54,6 +63,9 @@ public:
 	void joinWithoutDelete();
 	void deleteProcessThread();
 	void print();
+
+	// adds the statistic to the telemetry report
+	void report(TelemetryStage &stage);
 };
 
 }
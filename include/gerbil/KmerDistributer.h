@@ -26,6 +26,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unistd.h>
 #include <atomic>
 #include "KMer.h"
+#include "KMerHash.h"
 
 namespace gerbil {
 
@@ -73,6 +74,11 @@ public:
 	inline const double& getUkmerRatio() const{ return _ukmerRatio; }
 	inline double getTotalCapacity() const{ return _totalCapacity; }
 
+	// last throughput of a hasher thread (k-mers / us)
+	inline double getThroughput(const bool gpu, const uint32_t tId) const {
+		return throughput[gpu ? numThreadsCPU + tId : tId];
+	}
+
 	inline void setRdy(){ _rdy = true; }
 	inline void waitUntilRdy() const{
 		while(!_rdy)
@@ -113,11 +119,12 @@ public:
 
 	/**
 	 * Determines the bucket id of a kmer.
+	 * H: hash policy (KMerHash.h), independent of the hash of the tables
 	 * @param kmer The Kmer that should be hashed
 	 * @return A number betweeen zero and the total number
 	 * of hasher threads.
 	 */
-	template<uint32_t K>
+	template<uint32_t K, typename H = KMER_HASH_POLICY>
 	uint32_t inline distributeKMer(const KMer<K>& kmer,
 			const uint32_t curFileId) const {
 
@@ -130,7 +137,16 @@ public:
 		}*/
 
 		// Determine hash value of kmer by table lookup
-		const uint64_t hash = kmer.getPartHash() % BUCKETSIZE;
+		return distributeHash(H::partHash(kmer), curFileId);
+	}
+
+	/**
+	 * Like distributeKMer, for a part hash which is already known
+	 * (e.g. rolled while splitting a super-mer).
+	 */
+	uint32_t inline distributeHash(const uint64_t partHash,
+			const uint32_t curFileId) const {
+		const uint64_t hash = partHash % BUCKETSIZE;
 		//const uint32_t hash = kmer.getPartHash() & (BUCKETSIZE-1);
 		return buckets[curFileId][hash];
 	}
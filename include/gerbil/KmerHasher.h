@@ -27,6 +27,10 @@
 #include "CpuHasher.h"
 #include "GpuHasher.h"
 #include "KmerDistributer.h"
+#include "Telemetry.h"
+#include "PerfCounters.h"
+#include "NumaTopology.h"
+#include "KMerExtractor.h"
 
 namespace gerbil {
 
@@ -75,9 +79,28 @@ namespace gerbil {
 		uint64 _kMersNumberCPU, _kMersNumberGPU;
 		uint64 _uKMersNumberCPU, _uKMersNumberGPU;
 		uint64 _btUKMersNumberCPU, _btUKMersNumberGPU;
+		uint64 _probesNumber;                // probed hash table entries (CPU)
+		uint64 _fKMersNumber;                // k-mers which did not fit into the hash tables (CPU)
+		uint64 _failureTableKMersNumber;     // k-mers counted in the failure tables (CPU)
+		uint64 _spilledNumber;               // KMerBundles of failure buffers stored on disk (CPU)
+		uint64 _prefilterSpilledNumber;      // KMerBundles of first occurrences stored on disk (CPU, prefilter)
+		uint64 _keySize_B;                   // size of a key in the largest hash table (CPU)
+		uint64 _overflowNumber;              // counters which exceeded their size (CPU)
+		uint64 _singletonsNumber;            // k-mers which occurred once (CPU, prefilter)
+		SyncQueueStat _kMerQueueStat;        // blocking statistic of all KMerBundle queues
+		std::atomic<uint64> _splitKMersNumber; // k-mers of all completely split bins (progress)
+
+		// hardware events of the hot loops (optional)
+		PerfRegion _perfSplit;
+		PerfRegion _perfFill;
+		PerfRegion _perfExtract;
 
 		uint64 _maxKmcHashtableSize;
 		uint32 _kMerBundlesNumber;
+		bool _quotientKeys;                  // quotient keys in the hash tables (CPU)
+		uint32 _counterSize_B;               // size of the counters in the hash tables (CPU)
+		bool _prefilter;                     // k-mers enter the hash tables on their second occurrence (CPU)
+		uint32 _prefilterBundlesNumber;      // KMerBundles of first occurrences in memory per hasher (CPU)
 
 		uint64 _histogram[HISTOGRAM_SIZE];
 
@@ -130,7 +153,8 @@ namespace gerbil {
 						cpu::HasherTask<K> cpuHasher(_numCPUHasher,
 						                             _distributor,
 						                             &_kmcSyncSwapQueue, _tempFiles, _thresholdMin,
-						                             _maxKmcHashtableSize, _tempFolder);
+						                             _maxKmcHashtableSize, _tempFolder, _quotientKeys,
+						                             _counterSize_B, _prefilter, _prefilterBundlesNumber);
 
 						// create  Hash Tables (GPU-side)
 						gpu::HasherTask<K> gpuHasher(_numGPUHasher,
@@ -147,15 +171,20 @@ namespace gerbil {
 						const uint32_t total_threads = _numCPUHasher + _numGPUHasher;
 
 						for (uint8 i = 0; i < _numCPUHasher; ++i) {
+							// bundle pool on the node of its hasher
+							NumaTopology::pin(NumaTopology::getNode(i, _numCPUHasher));
 							// TODO: Calibrate the argument here
 							cpuKMerQueues[i] = new SyncSwapQueueMPSC<cpu::KMerBundle<K>>(
 									_kMerBundlesNumber / total_threads);
+							cpuKMerQueues[i]->monitor("kMerBundleQueue", i);
 						}
+						NumaTopology::unpin();
 
 						for (uint8 i = 0; i < _numGPUHasher; ++i) {
 							// TODO: Calibrate the argument here
 							gpuKMerQueues[i] = new SyncSwapQueueMPSC<gpu::KMerBundle<K>>(
 									_kMerBundlesNumber / total_threads);
+							gpuKMerQueues[i]->monitor("gpuKMerBundleQueue", i);
 						}
 
 						// start splitting
@@ -183,11 +212,15 @@ namespace gerbil {
 						_kmcSyncSwapQueue.finalize();
 
 						// clean up
-						for (uint8 i = 0; i < _numCPUHasher; ++i)
+						for (uint8 i = 0; i < _numCPUHasher; ++i) {
+							_kMerQueueStat += cpuKMerQueues[i]->getStat();
 							delete cpuKMerQueues[i];
+						}
 
-						for (uint8 i = 0; i < _numGPUHasher; ++i)
+						for (uint8 i = 0; i < _numGPUHasher; ++i) {
+							_kMerQueueStat += gpuKMerQueues[i]->getStat();
 							delete gpuKMerQueues[i];
+						}
 
 						delete[] cpuKMerQueues;
 						delete[] gpuKMerQueues;
@@ -203,6 +236,16 @@ namespace gerbil {
 						_kMersNumberGPU = gpuHasher.getKMersNumber();
 						_uKMersNumberGPU = gpuHasher.getUKMersNumber();
 						_btUKMersNumberGPU = gpuHasher.getBtUKMersNumber();
+						_probesNumber = cpuHasher.getProbesNumber();
+						_fKMersNumber = cpuHasher.getFKMersNumber();
+						_failureTableKMersNumber = cpuHasher.getFailureTableKMersNumber();
+						_spilledNumber = cpuHasher.getSpilledNumber();
+						_prefilterSpilledNumber = cpuHasher.getPrefilterSpilledNumber();
+						_keySize_B = cpuHasher.getKeySize_B();
+						_overflowNumber = cpuHasher.getOverflowNumber();
+						_singletonsNumber = cpuHasher.getSingletonsNumber();
+						_perfFill.add(cpuHasher.getPerfFill());
+						_perfExtract.add(cpuHasher.getPerfExtract());
 					});
 
 		}
@@ -214,9 +257,11 @@ namespace gerbil {
     {                                                                                            \
         /* 																						\
 		 * determine id of hash table according to current										\
-		 * split ratio.																			\
+		 * split ratio (with the rolled hash of a rolling hash policy).							\
 		 */                                                                                        \
-        const uint32_t h = _distributor->distributeKMer<K>(kmer, curTempFileId);                    \
+        const uint32_t h = rolling                                                                \
+                ? _distributor->distributeHash(KMER_HASH_POLICY::partHashOf(fwd, rev), curTempFileId)    \
+                : _distributor->distributeKMer<K>(kmer, curTempFileId);                            \
         if(h != NULL_BUCKET_VALUE) {                                                            \
             /* assign kmer to bundle cpu or gpu */                                                    \
             if(h >= _numCPUHasher) {                                                                \
@@ -229,12 +274,14 @@ namespace gerbil {
                 }                                                                                    \
             }                                                                                        \
             else {                                                                                    \
-                /* add to cpu */                                                                    \
-                if (!cpuKMerBundles[h]->add(kmer)) {                                                \
+                /* add to cpu (with the rolled hash, dropped by bundles without hashes) */            \
+                const uint64 kMerHash = rolling ? KMER_HASH_POLICY::hashOf(fwd, rev) : 0;            \
+                if (!cpuKMerBundles[h]->add(kmer, kMerHash)) {                                        \
                     cpuKMerBundles[h]->setTempFileId(curTempFileId);                                \
                     cpuKMerBundles[h]->setTempFileRun(curTempRun);                                \
                     cpuKMerQueues[h]->swapPush(cpuKMerBundles[h]);                                    \
-                    cpuKMerBundles[h]->add(kmer);                                                    \
+                    ++transfers[cpuHasherNodes[h] != node];                                            \
+                    cpuKMerBundles[h]->add(kmer, kMerHash);                                            \
                 }                                                                                    \
             }                                                                                        \
         }                                                                                             \
@@ -260,23 +307,37 @@ namespace gerbil {
 
 			// temporary variables
 			SuperBundle *sb = new SuperBundle();// the current super bundle in use
-			KMer<K> kMer, iKMer;        // the current k-mer/ inverse k-mer in use
-			const KMer<K> *nKMer;                    // the current normalized k-mer
 			uint16 l;                                // size of current super s-mer
 			byte *b;                        // byte representation of current s-mer.
-			size_t h;                // current hash value of k-mer (see distributor)
-			byte nextBase;                            // next base of current s-mer
 			uint_tfn curTempFileId;    // id of temp file, note: each temp file has its own id
 
+			// rolling hash of the k-mers (forward and reverse complement strand, see splitSuperMer)
+			constexpr bool rolling = KMER_HASH_POLICY::isRolling<K>();
+
+			// long k-mers are loaded word by word out of the shifted super-mer
+			KMerExtractor<K> extractor;
+
+			PerfCounters perfCounters;
+			PerfStat perfStat;
+
+			// numa: KMerBundles pushed to hashers of the own node [0] and of other nodes [1]
+			const uint32 node = NumaTopology::getNode(threadId, _processSplitterThreadsNumber);
+			uint32 *cpuHasherNodes = new uint32[_numCPUHasher];
+			uint64 transfers[2] = {0, 0};
+
 			// Kmer bundles
 			cpu::KMerBundle<K> **cpuKMerBundles =
 					new cpu::KMerBundle<K> *[_numCPUHasher];
 			gpu::KMerBundle<K> **gpuKMerBundles =
 					new gpu::KMerBundle<K> *[_numGPUHasher];
 
-			// init Kmer bundles
-			for (uint8_t i = 0; i < _numCPUHasher; i++)
+			// init Kmer bundles (on the node of their hasher)
+			for (uint8_t i = 0; i < _numCPUHasher; i++) {
+				cpuHasherNodes[i] = NumaTopology::getNode(i, _numCPUHasher);
+				NumaTopology::pin(cpuHasherNodes[i]);
 				cpuKMerBundles[i] = new cpu::KMerBundle<K>();
+			}
+			NumaTopology::pin(node);
 			for (uint8_t i = 0; i < _numGPUHasher; i++)
 				gpuKMerBundles[i] = new gpu::KMerBundle<K>();
 
@@ -312,6 +373,8 @@ namespace gerbil {
 				}
 				// get number of kmers in this file
 				uint64_t kmersInFile = _tempFiles[curTempFileId].getKMersNumber();
+				const uint runsNumber = _tempFiles[curTempFileId].getNumberOfRuns();
+				const uint runId = curTempRun;
 
 				/* Update the distributor that controls the ratio of
 				 *  kmers distributed the various hash tables. */
@@ -320,10 +383,6 @@ namespace gerbil {
 					                                    _tempFiles[curTempFileId].getNumberOfRuns(), kmersInFile);
 				this->barrier->sync();
 
-				// Some sort of progress bar
-				if (threadId == 0)
-					putchar('*');
-
 				// if super bundle is not yet empty and belongs the the current file
 				if (!sb->isEmpty() && sb->tempFileId == curTempFileId && sb->tempFileRun == curTempRun) {
 
@@ -341,6 +400,7 @@ namespace gerbil {
 #ifdef DEB_MESS_SUPERSPLITTER
 						sw.proceed();
 #endif
+						perfCounters.start();
 
 
 						// while ?
@@ -348,41 +408,18 @@ namespace gerbil {
 
 #if false
 							if(curTempRun == _tempFiles[curTempFileId].getNumberOfRuns() - 1) test_smerCounter++;
-							if(curTempRun == _tempFiles[curTempFileId].getNumberOfRuns() - 1) testS_kmerCounter += l - K + 1;
+							if(curTempRun == _tempFiles[curTempFileId].getNumberOfRuns() - 1) testS_kmerCounter += l - k + 1;
 #endif
 
-							// extract first kmer out of supermer and add to kmer bundle
-							if (NORM) {
-								// normalize first
-								KMer<K>::set(b, kMer, iKMer);
-								nKMer = &kMer.getNormalized(iKMer);
-								ADD_KMER_TO_BUNDLE((*nKMer), curTempFileId, curTempRun)
-
-							} else {
-								// just add to bundle
-								kMer.set(b);
-								ADD_KMER_TO_BUNDLE(kMer, curTempFileId, curTempRun);
-							}
-
-							// extract all other kmers from supermer
-							for (uint i = K; i < l; ++i) {
-								nextBase = (*(b + (i >> 2))
-										>> (6 - ((i & 0x3) << 1))) & 0x3;
-								kMer.next(nextBase);
-
-								// add to bundle
-								if (NORM) {
-									iKMer.nextInv(nextBase);
-									nKMer = &kMer.getNormalized(iKMer);
-									ADD_KMER_TO_BUNDLE((*nKMer), curTempFileId, curTempRun);
-								} else {
-									ADD_KMER_TO_BUNDLE(kMer, curTempFileId, curTempRun);
-								}
-							}
+							// extract all kmers out of supermer and add them to kmer bundles
+							splitSuperMer<K, NORM>(b, l, extractor,
+									[&](const KMer<K> &kMer, const uint64 &fwd, const uint64 &rev)
+									ADD_KMER_TO_BUNDLE(kMer, curTempFileId, curTempRun));
 						}
 
 						// clean up?
 						sb->clear();
+						perfCounters.stop(perfStat);
 
 						// timing
 #ifdef DEB_MESS_SUPERSPLITTER
@@ -396,6 +433,7 @@ namespace gerbil {
 							cpuKMerBundles[i]->setTempFileId(curTempFileId);
 							cpuKMerBundles[i]->setTempFileRun(curTempRun);
 							cpuKMerQueues[i]->swapPush(cpuKMerBundles[i]);
+							++transfers[cpuHasherNodes[i] != node];
 						}
 					}
 
@@ -424,6 +462,11 @@ namespace gerbil {
 				memoryBarrier();
 
 				this->barrier->sync();
+
+				// progress: each run covers an equal share of the k-mers of the file
+				if (threadId == 0)
+					_splitKMersNumber += kmersInFile / runsNumber
+							+ (runId + 1 == runsNumber ? kmersInFile % runsNumber : 0);
 			}
 
 #if false
@@ -432,6 +475,11 @@ namespace gerbil {
 			_test_smerCounter += test_smerCounter;
 #endif
 
+			if (perfCounters.isOpen())
+				_perfSplit.add(threadId, perfStat);
+			NumaTopology::addTransfers(transfers[0], transfers[1]);
+			delete[] cpuHasherNodes;
+
 			// clean up
 			delete sb;
 
@@ -475,7 +523,11 @@ namespace gerbil {
 		           const bool &norm, std::string pTempFolder,
 		           const uint64 &maxKmcHashtableSize, const uint32 &kMerBundlesNumber,
 		           uint_tfn *tempFilesOrder,
-		           KmerDistributer *distributor
+		           KmerDistributer *distributor,
+		           const bool &quotientKeys = false,
+		           const uint32 &counterSize_B = sizeof(uint_cv),
+		           const bool &prefilter = false,
+		           const uint32 &prefilterBundlesNumber = PREFILTER_KMER_BUNDLES_NUMBER_PER_THREAD
 		) :
 				_kmcSyncSwapQueue(kmcBundlesNumber),
 				_processSplitterThreadsNumber(processSplitterThreadsNumber),
@@ -486,9 +538,12 @@ namespace gerbil {
 				_superBundleQueue(superBundleQueue), _tempFiles(
 				tempFiles), _processThread(NULL), _kMersNumberCPU(0), _kMersNumberGPU(
 				0), _uKMersNumberCPU(0), _uKMersNumberGPU(0), _btUKMersNumberCPU(
-				0), _btUKMersNumberGPU(0), _maxKmcHashtableSize(
+				0), _btUKMersNumberGPU(0), _probesNumber(0), _fKMersNumber(0), _failureTableKMersNumber(0), _spilledNumber(0), _prefilterSpilledNumber(0), _keySize_B(0), _overflowNumber(0), _singletonsNumber(0), _splitKMersNumber(0),
+				_maxKmcHashtableSize(
 				maxKmcHashtableSize), _syncSplitterCounter(0), _kMerBundlesNumber(
-				kMerBundlesNumber), _tempFilesOrder(tempFilesOrder), _distributor(distributor) {
+				kMerBundlesNumber), _tempFilesOrder(tempFilesOrder), _distributor(distributor),
+				_quotientKeys(quotientKeys), _counterSize_B(counterSize_B), _prefilter(prefilter),
+				_prefilterBundlesNumber(prefilterBundlesNumber) {
 
 			// create array of threads
 			_processSplitterThreads =
@@ -496,6 +551,8 @@ namespace gerbil {
 
 			barrier = new Barrier(_processSplitterThreadsNumber);
 
+			_kmcSyncSwapQueue.monitor("kmcBundleQueue");
+
 #if false
 			_test_kmerCounter = 0;
 			_testS_kmerCounter = 0;
@@ -531,16 +588,24 @@ namespace gerbil {
 		void process() {
 
 #define C_PROC(x) case x: process_template<x>(); break
+#define C_PROC_DYN(c) case c: KMer<KMER_DYN(c)>::setK(_k); process_template<KMER_DYN(c)>(); break
+
+#if MAX_STATIC_KMER_SIZE
+			// one template specialization per k
+			if (_k <= MAX_STATIC_KMER_SIZE) {
+				switch (_k) {
+						LOOP128(MAX_STATIC_KMER_SIZE, C_PROC);
+					default:
+						throw std::runtime_error(
+								std::string("Gerbil Error: Unsupported k"));
+				}
+				return;
+			}
+#endif
 
-			// decide which template specialization to use
-			switch (_k) {
-
-					//LOOP512(MAX_KMER_SIZE, C_PROC);
-					LOOP128(MAX_KMER_SIZE, C_PROC);
-					//C_PROC(28);
-					//C_PROC(40);
-					//C_PROC(56);
-					//C_PROC(65);
+			// k-mers with a runtime k, one specialization per number of words
+			switch (GET_KMER_DYN_C(_k)) {
+				LOOP_KMER_DYN(C_PROC_DYN);
 				default:
 					throw std::runtime_error(
 							std::string("Gerbil Error: Unsupported k"));
@@ -553,6 +618,11 @@ namespace gerbil {
 			IF_DEB(printf("all KmerHashers are rdy...\n"));
 		}
 
+		// returns the number of k-mers of all completely split bins (weighted by runs)
+		uint64 getSplitKMersNumber() const {
+			return _splitKMersNumber.load(std::memory_order_relaxed);
+		}
+
 		void print() {
 			printf("kmers (CPU)     : %12lu\n", _kMersNumberCPU);
 			printf("kmers (GPU)     : %12lu\n", _kMersNumberGPU);
@@ -560,6 +630,30 @@ namespace gerbil {
 			printf("ukmers (GPU)    : %12lu\n", _uKMersNumberGPU);
 			printf("below th (CPU)  : %12lu\n", _btUKMersNumberCPU);
 			printf("below th (GPU)  : %12lu\n", _btUKMersNumberGPU);
+			if (!_perfSplit.isEmpty()) {
+				_perfSplit.print("hasher split", "k-mer", _kMersNumberCPU + _kMersNumberGPU);
+				_perfFill.print("hasher fill", "k-mer", _kMersNumberCPU);
+				_perfExtract.print("hasher extract", "uk-mer", _uKMersNumberCPU);
+			}
+		}
+
+		/*
+		 * adds the statistic to the telemetry report
+		 */
+		void report(TelemetryStage &stage) {
+			stage.add("hasher.kMers", _kMersNumberCPU + _kMersNumberGPU);
+			stage.add("hasher.uKMers", _uKMersNumberCPU + _uKMersNumberGPU);
+			stage.add("hasher.belowThreshold", _btUKMersNumberCPU + _btUKMersNumberGPU);
+			stage.add("hasher.probes", _probesNumber);
+			stage.add("hasher.failedKMers", _fKMersNumber);
+			stage.add("hasher.failureTableKMers", _failureTableKMersNumber);
+			stage.add("hasher.failureBufferSpills", _spilledNumber);
+			stage.add("hasher.prefilterSpills", _prefilterSpilledNumber);
+			stage.add("hasher.keyBytes", _keySize_B);
+			stage.add("hasher.overflowCounters", _overflowNumber);
+			stage.add("hasher.singletons", _singletonsNumber);
+			stage.addQueue("kMerBundleQueue", _kMerQueueStat);
+			stage.addQueue("kmcBundleQueue", _kmcSyncSwapQueue.getStat());
 		}
 
 		SyncSwapQueueMPSC<KmcBundle> *getKmcSyncSwapQueue() {
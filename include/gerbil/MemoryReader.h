@@ -0,0 +1,96 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef MEMORYREADER_H_
+#define MEMORYREADER_H_
+
+#include "SyncQueue.h"
+#include "Telemetry.h"
+#include "Bundle.h"
+#include "ReadSource.h"
+#include "global.h"
+
+namespace gerbil {
+
+/*
+ * pulls reads from a ReadSource and stores them in ReadBundles
+ * (in-memory replacement for FastReader + FastParser)
+ */
+class MemoryReader {
+private:
+	ReadSource* _readSource;                    // source of reads
+	bool _skipEstimate;                         // skip the error estimation
+	double _erate;                              // estimated error rate (qualities)
+
+	std::atomic<uint64> _readsNumber;           // number of reads
+	std::atomic<uint64> _basesNumber;           // number of bases
+	SyncSwapQueueMPMC<ReadBundle> _syncQueue;   // SyncSwapQueue for ReadBundles
+
+	std::thread *_processThread;                // thread
+
+	// adds a read, splits reads which exceed a ReadBundle (overlap of k-1 bases)
+	void storeRead(const char *read, uint32 length, ReadBundle *&readBundle);
+
+public:
+	SyncSwapQueueMPMC<ReadBundle> *getSyncQueue();          // returns SyncSwapQueue of ReadBundles
+
+	inline uint64 getReadsNumber() { return _readsNumber; } // returns total number of reads
+
+	inline uint64 getBasesNumber() { return _basesNumber; } // returns number of bases read so far
+
+	inline uint64 getBasesNumberHint() { return _readSource->getBasesNumberHint(); } // expected number of bases
+
+	inline double getErate() { return _erate; }            // returns the estimated error rate
+
+	/*
+	 * constructor
+	 */
+	MemoryReader(const uint32 &readBundlesNumber, ReadSource* readSource, bool skipEstimate);
+
+	/*
+	 * starts the entire working process
+	 */
+	void process();
+
+	/*
+	 * joins the thread
+	 */
+	void join();
+
+	/*
+	 * prints some statistical outputs
+	 */
+	void print();
+
+	/*
+	 * adds the statistic to the telemetry report
+	 */
+	void report(TelemetryStage &stage);
+
+	/*
+	 * destructor
+	 */
+	~MemoryReader();
+};
+
+}
+
+#endif /* MEMORYREADER_H_ */
@@ -0,0 +1,97 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef MEMORYTRACKER_H_
+#define MEMORYTRACKER_H_
+
+#include "types.h"
+
+namespace gerbil {
+
+class TelemetryStage;
+
+// components of the pipeline with large buffers
+typedef enum {
+	mc_fastBundles,     // FastBundles (queues, parsers)
+	mc_readBundles,     // ReadBundles (queues, parsers, splitters)
+	mc_superBundles,    // SuperBundles (queues, splitters, SuperWriter, SuperReader)
+	mc_bins,            // in-memory bins
+	mc_kMerBundles,     // KMerBundles (queues, splitters, failure buffers)
+	mc_hashTables,      // hash tables of the hashers
+	mc_kmcBundles,      // KmcBundles (queues, hashers, KmcWriter)
+	mc_output,          // counted k-mers kept for the caller (listKmer)
+	mc_number           // number of components
+} TMemoryComponent;
+
+/*
+ * accounts the actual allocations of the large buffers: live and peak bytes per component and in total
+ * required allocations are always recorded (budget exceedances are counted), optional ones
+ * (in-memory bins, hash tables) are refused or downsized if they would exceed the budget
+ */
+class MemoryTracker {
+public:
+	// sets the budget (0: unlimited) and clears all counters
+	static void reset(const uint64 &budget_B);
+
+	static uint64 getBudget();
+
+	// records a required allocation, returns false if it exceeds the budget
+	static bool acquire(const TMemoryComponent &component, const uint64 &size_B);
+
+	// records an allocation only if it fits into the budget
+	static bool tryAcquire(const TMemoryComponent &component, const uint64 &size_B);
+
+	// records an allocation of at most size_B which fits into the budget, but at least minSize_B
+	// returns the granted size
+	static uint64 acquireUpTo(const TMemoryComponent &component, const uint64 &size_B, const uint64 &minSize_B);
+
+	static void release(const TMemoryComponent &component, const uint64 &size_B);
+
+	static uint64 getLive();
+	static uint64 getPeak();
+	static uint64 getLive(const TMemoryComponent &component);
+	static uint64 getPeak(const TMemoryComponent &component);
+
+	// number of required allocations beyond the budget, refused and downsized allocations
+	static uint64 getExceededNumber();
+	static uint64 getRefusedNumber();
+	static uint64 getDownsizedNumber();
+
+	// sets all peaks to the live values and clears the counters (start of a stage)
+	static void resetPeaks();
+
+	static const char* getName(const TMemoryComponent &component);
+
+	/*
+	 * prints the peaks of all components and the estimate
+	 */
+	static void print(const uint64 &estimated_B);
+
+	/*
+	 * adds the peaks of all components and the estimate to the telemetry report
+	 */
+	static void report(TelemetryStage &stage, const uint64 &estimated_B);
+};
+
+}
+
+#endif /* MEMORYTRACKER_H_ */
@@ -0,0 +1,79 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef NUMATOPOLOGY_H_
+#define NUMATOPOLOGY_H_
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace gerbil {
+
+class TelemetryStage;
+
+/*
+ * NUMA nodes of the machine (sysfs) and placement of the phase two threads
+ * thread i of n runs on node i * nodes / n, so splitter i and hasher i share a node
+ * memory follows the threads by first touch (hash tables, failure buffers, KMerBundle pools)
+ * without an effect on single node machines or if disabled
+ */
+class NumaTopology {
+public:
+	// reads the nodes and their cpus within the affinity of the process (e.g. taskset, a cpu binding
+	// of the batch system), a single node of all allowed cpus if not available
+	static void detect(const std::string &sysPath = "/sys/devices/system/node");
+
+	// pinning is active only with more than one node
+	static void setEnabled(const bool &enabled);
+
+	static bool isEnabled();
+
+	static uint32 getNodesNumber();
+
+	// node of thread tId of threadsNumber threads
+	static uint32 getNode(const uint32 &tId, const uint32 &threadsNumber);
+
+	// binds the calling thread to the cpus of a node, false if not enabled or failed
+	static bool pin(const uint32 &node);
+
+	// restores the affinity of the process (as found by detect) for the calling thread
+	static void unpin();
+
+	// KMerBundles pushed by splitters to hashers of the same node and of other nodes
+	static void addTransfers(const uint64 &local, const uint64 &remote);
+
+	static void resetTransfers();
+
+	static uint64 getRemoteTransfersNumber();
+
+	// remote / all KMerBundles
+	static double getRemoteRatio();
+
+	static void print();
+
+	static void report(TelemetryStage &stage);
+};
+
+}
+
+#endif /* NUMATOPOLOGY_H_ */
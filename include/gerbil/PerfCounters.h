@@ -0,0 +1,118 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#include <mutex>
+#include <vector>
+
+#include "types.h"
+
+namespace gerbil {
+
+// cycles, instructions, LLC misses, branch misses
+#define PERF_EVENTS_NUMBER 4
+
+/*
+ * hardware events of a code region (sum of all measured sections of a thread)
+ */
+struct PerfStat {
+	uint64 values[PERF_EVENTS_NUMBER];
+	uint64 sections;            // number of measured sections
+
+	PerfStat() : sections(0) {
+		for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i)
+			values[i] = 0;
+	}
+
+	PerfStat &operator+=(const PerfStat &stat) {
+		for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i)
+			values[i] += stat.values[i];
+		sections += stat.sections;
+		return *this;
+	}
+};
+
+/*
+ * hardware counters (perf_event_open) of the calling thread, user space only
+ * must be created by the measured thread, disabled by default (no syscalls at all)
+ * events which are not supported by the cpu/kernel stay 0
+ */
+class PerfCounters {
+	int _fds[PERF_EVENTS_NUMBER];           // _fds[0] is the group leader, -1: not available
+	uint _slots[PERF_EVENTS_NUMBER];        // position of an event in a group read (PERF_EVENTS_NUMBER: not available)
+	uint _slotsNumber;
+	uint64 _start[PERF_EVENTS_NUMBER];
+	uint64 _startEnabled;                   // time of the group (for multiplexing)
+	uint64 _startRunning;
+
+	static bool __enabled;
+
+	bool read(uint64* values, uint64 &enabled, uint64 &running);
+
+public:
+	PerfCounters();
+	~PerfCounters();
+
+	inline bool isOpen() const {
+		return _fds[0] >= 0;
+	}
+
+	// begins a section
+	void start();
+
+	// ends a section and adds the events to stat
+	void stop(PerfStat &stat);
+
+	static void setEnabled(const bool &enabled);
+
+	static bool isEnabled();
+
+	// true if the cycle counter can be opened (e.g. perf_event_paranoid, virtual machines)
+	static bool isSupported();
+
+	static const char* getEventName(const uint &event);
+};
+
+/*
+ * hardware events of a code region per thread
+ */
+class PerfRegion {
+	std::mutex _mtx;
+	std::vector<PerfStat> _threads;
+
+public:
+	void add(const uint32 &threadId, const PerfStat &stat);
+
+	// merges all threads of region
+	void add(PerfRegion &region);
+
+	bool isEmpty();
+
+	// prints totals (per element, e.g. per k-mer) and all threads
+	void print(const char* name, const char* elementName, const uint64 &elementsNumber);
+};
+
+}
+
+#endif /* PERFCOUNTERS_H_ */
@@ -0,0 +1,90 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef PROGRESSREPORTER_H_
+#define PROGRESSREPORTER_H_
+
+#include <string>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#include "types.h"
+
+namespace gerbil {
+
+/*
+ * reports the progress of the current step periodically (thread)
+ * stderr ("-"): a line per report
+ * status file: a single JSON object, replaced at each report (for schedulers)
+ * the progress of a step is polled from its components by a callback
+ */
+class ProgressReporter {
+public:
+	// returns the done and the total amount of work (total 0: unknown)
+	typedef std::function<void(uint64 &done, uint64 &total)> TProgress;
+
+private:
+	std::string _fileName;          // "-": stderr
+	uint32 _interval_ms;
+	std::thread* _thread;
+	std::mutex _mtx;
+	std::condition_variable _cv;
+	bool _stop;
+
+	std::string _step;              // current step ("": none)
+	std::string _unit;              // unit of work (e.g. B, k-mers)
+	TProgress _progress;
+
+	double _start_s;                // start of process
+	double _stepStart_s;            // start of current step
+	double _lastReport_s;
+	double _lastChange_s;           // last change of done (stall detection)
+	uint64 _lastDone;
+	double _rate;                   // smoothed work per s
+
+	void report(const bool &final);     // requires lock
+
+public:
+	ProgressReporter();
+	~ProgressReporter();
+
+	// starts the reporter thread, returns false if the status file can not be written
+	bool start(const std::string &fileName, const uint32 &interval_ms = PROGRESS_INTERVAL_MS);
+
+	void stop();
+
+	inline bool isRunning() const {
+		return _thread != NULL;
+	}
+
+	// begins a new step (no effect if the reporter is not running)
+	void setStep(const std::string &step, const std::string &unit, TProgress progress);
+
+	// reports the final state of the current step, the callback is not used afterwards
+	void finishStep();
+};
+
+}
+
+#endif /* PROGRESSREPORTER_H_ */
@@ -0,0 +1,59 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef QUEUEMONITOR_H_
+#define QUEUEMONITOR_H_
+
+#include <string>
+
+#include "types.h"
+
+namespace gerbil {
+
+class MonitoredQueue;
+
+/*
+ * samples all registered queues periodically and writes a timeline (csv):
+ * time_ms, queue, id, fill, capacity, waiting producers/consumers and
+ * the time producers were blocked / consumers starved since the previous sample
+ * disabled by default (no overhead), queues register only while enabled
+ */
+class QueueMonitor {
+public:
+	// starts sampling, returns false if the file can not be created
+	static bool start(const std::string &fileName, const uint32 &interval_ms = QUEUE_MONITOR_INTERVAL_MS);
+
+	// takes a last sample and closes the timeline
+	static void stop();
+
+	static bool isEnabled();
+
+	// registers a queue (only if enabled)
+	static void add(MonitoredQueue *queue, const std::string &name, const uint32 &id);
+
+	// unregisters a queue (takes a last sample)
+	static void remove(MonitoredQueue *queue);
+};
+
+}
+
+#endif /* QUEUEMONITOR_H_ */
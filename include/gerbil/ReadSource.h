@@ -0,0 +1,81 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef READSOURCE_H_
+#define READSOURCE_H_
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+namespace gerbil {
+
+/*
+ * in-memory input for run1 (replaces FastReader and FastParser)
+ * next() is called by a single thread, one read per call
+ */
+class ReadSource {
+public:
+	virtual ~ReadSource() {}
+
+	// returns the next read (and its qualities or NULL), false if there are no more reads
+	// the memory must stay valid until the following call
+	virtual bool next(const char* &read, uint32 &length, const char* &qualities) = 0;
+
+	// returns the approximate number of bases (0: unknown)
+	virtual uint64 getBasesNumberHint() { return 0; }
+};
+
+/*
+ * reads (and optional qualities) of string vectors, nothing is copied
+ */
+class MemoryReadSource : public ReadSource {
+	const std::vector<std::string> &_reads;
+	const std::vector<std::string> *_qualities;
+	size_t _next;
+public:
+	MemoryReadSource(const std::vector<std::string> &reads,
+			const std::vector<std::string> *qualities = NULL) :
+			_reads(reads), _qualities(qualities), _next(0) {
+	}
+
+	bool next(const char* &read, uint32 &length, const char* &qualities) {
+		if(_next >= _reads.size())
+			return false;
+		read = _reads[_next].data();
+		length = _reads[_next].size();
+		qualities = _qualities ? (*_qualities)[_next].data() : NULL;
+		++_next;
+		return true;
+	}
+
+	uint64 getBasesNumberHint() {
+		uint64 basesNumber = 0;
+		for(const std::string &read : _reads)
+			basesNumber += read.size();
+		return basesNumber;
+	}
+};
+
+}
+
+#endif /* READSOURCE_H_ */
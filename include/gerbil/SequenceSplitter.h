@@ -23,6 +23,8 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SUPERSPLITTER_H_
 
 #include "SyncQueue.h"
+#include "Telemetry.h"
+#include "PerfCounters.h"
 #include "Bundle.h"
 
 namespace gerbil {
@@ -49,6 +51,12 @@ class SequenceSplitter{
 
 	std::atomic<uint64> _baseNumbers;  // total number of bases
 
+	uint64* _binSuperBundles;          // number of stored SuperBundles per temporary file
+	uint64* _binSMers;                 // number of stored s-mers per temporary file
+	uint64* _binKMers;                 // number of stored k-mers per temporary file
+
+	PerfRegion _perfScan;              // hardware events of the splitting loop (optional)
+
 	uint32_t invMMer(const uint32_t &mmer);    // inverts a minimizer
 	bool isAllowed(uint32 mmer);               // checks whether a minimizer is allowed (special, tested strategies)
 	void detMMerHisto();                       // calculation of a histogram (special, tested strategies)
@@ -81,11 +89,21 @@ public:
      */
 	void join();
     
+    /*
+     * returns the final statistic of a temporary file (after join)
+     */
+    void getBinStat(const uint_tfn &tempFileId, uint64 &superBundles, uint64 &sMers, uint64 &kMers) const;
+
     /*
      * prints some statistical outputs
      */
     void print();
 
+    /*
+     * adds the statistic to the telemetry report
+     */
+    void report(TelemetryStage &stage);
+
     /*
      * destructor
      */
@@ -25,6 +25,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Bundle.h"
 #include "SyncQueue.h"
 #include "TempFile.h"
+#include "Telemetry.h"
 #include "KmerDistributer.h"
 
 namespace gerbil {
@@ -42,6 +43,9 @@ class SuperReader {
 	std::thread* _processThread;					// process thread
 
 	KmerDistributer* _distributor;
+
+	uint64 _superBundlesNumber;						// number of read SuperBundles
+	uint64 _multiRunBinsNumber;						// number of bins which are read more than once
 	
 	/*
 	 * starts the working process of a single thread
@@ -72,6 +76,11 @@ public:
    	 */
 	void join();
 
+	/*
+	 * adds the statistic to the telemetry report
+	 */
+	void report(TelemetryStage &stage);
+
 	/*
 	 * constructor
 	 */
@@ -24,6 +24,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "SyncQueue.h"
 #include "TempFile.h"
+#include "Telemetry.h"
 
 namespace gerbil {
 
@@ -53,7 +54,8 @@ public:
 	 */
 	SuperWriter(std::string pTempFolder,
 			SyncSwapQueueMPSC<SuperBundle>** superBundleQueues,
-			const uint_tfn &tempFilesNumber, const uint64 &maxBufferSize);
+			const uint_tfn &tempFilesNumber, const uint64 &maxBufferSize,
+			const bool inMemory = false, const bool pipelined = false);
 
     /*
      * starts the entire working process
@@ -70,6 +72,11 @@ public:
      */
 	void print();
 
+	/*
+	 * adds the statistic to the telemetry report
+	 */
+	void report(TelemetryStage &stage);
+
 	/*
 	 * destructor
 	 */
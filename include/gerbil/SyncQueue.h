@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SYNCQUEUE_H_
 
 #include "types.h"
+#include "QueueMonitor.h"
 #include <queue>
 #include <thread>
 #include <mutex>
@@ -30,10 +31,136 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <condition_variable>
 #include <boost/thread/thread.hpp>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 
 namespace gerbil {
 
+// always-on statistic of a queue (only updated if a thread has to wait)
+struct SyncQueueStat {
+	// (atomic: the producers and consumers of lock-free queues add waits while the monitor samples)
+	std::atomic<uint64> pushWaits;       // number of blocked push operations (queue full)
+	std::atomic<uint64> pushWait_ns;     // time of blocked push operations
+	std::atomic<uint64> popWaits;        // number of blocked pop operations (queue empty)
+	std::atomic<uint64> popWait_ns;      // time of blocked pop operations
+
+	SyncQueueStat() : pushWaits(0), pushWait_ns(0), popWaits(0), popWait_ns(0) {}
+
+	SyncQueueStat(const SyncQueueStat &stat) : pushWaits(0), pushWait_ns(0), popWaits(0), popWait_ns(0) {
+		*this = stat;
+	}
+
+	SyncQueueStat &operator=(const SyncQueueStat &stat) {
+		pushWaits.store(stat.pushWaits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		pushWait_ns.store(stat.pushWait_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		popWaits.store(stat.popWaits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		popWait_ns.store(stat.popWait_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return *this;
+	}
+
+	static inline uint64 now_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	inline void addPushWait(const uint64 &start_ns) {
+		pushWaits.fetch_add(1, std::memory_order_relaxed);
+		pushWait_ns.fetch_add(now_ns() - start_ns, std::memory_order_relaxed);
+	}
+
+	inline void addPopWait(const uint64 &start_ns) {
+		popWaits.fetch_add(1, std::memory_order_relaxed);
+		popWait_ns.fetch_add(now_ns() - start_ns, std::memory_order_relaxed);
+	}
+
+	SyncQueueStat &operator+=(const SyncQueueStat &stat) {
+		pushWaits.fetch_add(stat.pushWaits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		pushWait_ns.fetch_add(stat.pushWait_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		popWaits.fetch_add(stat.popWaits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		popWait_ns.fetch_add(stat.popWait_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		return *this;
+	}
+};
+
+// state of a queue at a point of time
+struct QueueSample {
+	uint64 fill;            // number of filled items
+	uint64 capacity;        // max. number of items
+	uint32 pushWaiting;     // number of blocked producers
+	uint32 popWaiting;      // number of waiting consumers
+	SyncQueueStat stat;     // blocking statistic until now
+};
+
+// blocking statistic and runtime monitoring (see QueueMonitor) shared by all queues
+class MonitoredQueue {
+protected:
+	SyncQueueStat _stat;                    // blocking statistic
+	std::atomic<uint32> _pushWaiting;       // number of blocked producers
+	std::atomic<uint32> _popWaiting;        // number of waiting consumers
+	bool _monitored;                        // registered at QueueMonitor
+
+	MonitoredQueue() : _pushWaiting(0), _popWaiting(0), _monitored(false) {}
+
+	// must be called by the destructor of the derived class (sample() is still valid)
+	inline void unmonitor() {
+		if(_monitored)
+			QueueMonitor::remove(this);
+		_monitored = false;
+	}
+
+	inline void beginPushWait(uint64 &waitStart) {
+		if(!waitStart) {
+			waitStart = SyncQueueStat::now_ns();
+			++_pushWaiting;
+		}
+	}
+
+	inline void endPushWait(const uint64 &waitStart) {
+		if(waitStart) {
+			--_pushWaiting;
+			_stat.addPushWait(waitStart);
+		}
+	}
+
+	inline void beginPopWait(uint64 &waitStart) {
+		if(!waitStart) {
+			waitStart = SyncQueueStat::now_ns();
+			++_popWaiting;
+		}
+	}
+
+	inline void endPopWait(const uint64 &waitStart) {
+		if(waitStart) {
+			--_popWaiting;
+			_stat.addPopWait(waitStart);
+		}
+	}
+
+	inline void sampleWaits(QueueSample &sample) const {
+		sample.pushWaiting = _pushWaiting.load(std::memory_order_relaxed);
+		sample.popWaiting = _popWaiting.load(std::memory_order_relaxed);
+		sample.stat = _stat;
+	}
+
+public:
+	virtual ~MonitoredQueue() {}
+
+	inline const SyncQueueStat &getStat() const {
+		return _stat;
+	}
+
+	// registers the queue at the QueueMonitor (if enabled)
+	void monitor(const std::string &name, const uint32 &id = 0) {
+		if(!_monitored && QueueMonitor::isEnabled()) {
+			QueueMonitor::add(this, name, id);
+			_monitored = true;
+		}
+	}
+
+	// current state of the queue (called by the QueueMonitor)
+	virtual void sample(QueueSample &sample) = 0;
+};
+
 // base class for special synchronized queues
 class SyncSwapQueue {
 protected:
@@ -83,7 +210,7 @@ public:
 #define SSQ_SPSC_WAIT sched_yield()
 //#define SSQ_SPSC_WAIT usleep(1);
 template <typename T>
-class SyncSwapQueueSPSC: public SyncSwapQueue{
+class SyncSwapQueueSPSC: public SyncSwapQueue, public MonitoredQueue{
 	T** _data;
 	IF_QUEUE_STAT(
 		uint64 _wPush;
@@ -112,6 +239,7 @@ public:
 	}
 
 	~SyncSwapQueueSPSC(){
+		unmonitor();
 		T** p_end = _data + _size;
 		for(T** p(_data); p < p_end; ++p)
 			delete *p;
@@ -128,16 +256,25 @@ public:
 		)
 	}
 
+	void sample(QueueSample &sample) {
+		sample.fill = (_size + _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_relaxed)) % _size;
+		sample.capacity = _size - 1;
+		sampleWaits(sample);
+	}
+
 	void swapPush(T* &item) {
 		IF_QUEUE_STAT(_swPush.proceed();)
 		assert(!_isFinalized);
 		const auto current_head = _head.load(std::memory_order_relaxed);
 		const size_t next_head = increment(current_head);
 		IF_QUEUE_STAT(++_ops;)
+		uint64 waitStart = 0;
 		while(next_head == _tail.load(std::memory_order_acquire)){
+			beginPushWait(waitStart);
 			IF_QUEUE_STAT(++_wPush;)
 			SSQ_SPSC_WAIT;
 		}
+		endPushWait(waitStart);
 		std::swap(_data[current_head], item);
 		_head.store(next_head, std::memory_order_release);
 		IF_QUEUE_STAT(
@@ -154,11 +291,14 @@ public:
 		IF_QUEUE_STAT(_swPop.proceed();)
 		const auto current_tail = _tail.load(std::memory_order_relaxed);
 		std::atomic<size_t> current_head;
+		uint64 waitStart = 0;
 		while(current_tail == (current_head = _head.load(std::memory_order_acquire)) && !_isFinalized) {
+			beginPopWait(waitStart);
 			IF_QUEUE_STAT(++_wPop;)
 			//SSQ_SPSC_WAIT;
 			usleep(FAST_BLOCK_SIZE_B / 1024 * (MIN_FASTBUNDLEBUFFER_SIZE_B / FAST_BLOCK_SIZE_B / 32));
 		}
+		endPopWait(waitStart);
 		if(current_tail == current_head) {
 			assert(_isFinalized);
 			IF_QUEUE_STAT(_swPop.hold();)
@@ -174,7 +314,7 @@ public:
 
 
 template <typename T>
-class SyncSwapQueueMPSC{
+class SyncSwapQueueMPSC: public MonitoredQueue{
 	typedef enum {sq_empty, sq_fill} TSQState;
 
 	T** _data;
@@ -226,6 +366,7 @@ public:
 	}
 
 	~SyncSwapQueueMPSC(){
+		unmonitor();
 		for(uint i = 0; i < _maxSize; i++)
 			delete _data[i];
 
@@ -258,6 +399,13 @@ public:
 	  return !_size;
 	}
 
+	void sample(QueueSample &sample) {
+		std::unique_lock<std::mutex> lock(_mtx);
+		sample.fill = _size;
+		sample.capacity = _maxSize;
+		sampleWaits(sample);
+	}
+
 	void finalize() {
 		_finalize = true;
 		_cv_empty.notify_one();
@@ -271,7 +419,9 @@ public:
 		IF_QUEUE_STAT(
 			++_ops;
 		)
+		uint64 waitStart = 0;
 		while(*_prod_s_p == sq_fill){
+			beginPushWait(waitStart);
 			IF_QUEUE_STAT(
 				++_wPush;
 				_swPush.proceed();
@@ -281,6 +431,7 @@ public:
 				_swPush.hold();
 			)
 		}
+		endPushWait(waitStart);
 
 		T* swap = *_prod_d_p;
 		*(_prod_d_p++) = item;
@@ -305,7 +456,9 @@ public:
 	 */
 	bool swapPop(T* &item) {
 		std::unique_lock<std::mutex> ulock(_mtx);
+		uint64 waitStart = 0;
 		while(!_finalize && !_size) {
+			beginPopWait(waitStart);
 			IF_QUEUE_STAT(
 				++_wPop;
 				_swPop.proceed();
@@ -315,6 +468,7 @@ public:
 				_swPop.hold();
 			)
 		}
+		endPopWait(waitStart);
 		if(!_size)
 			return false;
 		T* swap = *_cons_d_p;
@@ -359,7 +513,7 @@ public:
 };
 
 template <typename T>
-class SyncSwapQueueSPMC{
+class SyncSwapQueueSPMC: public MonitoredQueue{
 	typedef enum {sq_empty, sq_fill} TSQState;
 
 	T** _data;
@@ -411,6 +565,7 @@ public:
 	}
 
 	~SyncSwapQueueSPMC(){
+		unmonitor();
 		/*for(_cons_d_p = _data, _prod_d_p = _data + _maxSize; _cons_d_p < _prod_d_p; _cons_d_p++)
 			if(*_cons_d_p)
 				delete *_cons_d_p;*/
@@ -434,6 +589,13 @@ public:
 	  return !_size;
 	}
 
+	void sample(QueueSample &sample) {
+		std::unique_lock<std::mutex> lock(_mtx);
+		sample.fill = _size;
+		sample.capacity = _maxSize;
+		sampleWaits(sample);
+	}
+
 	void finalize() {
 		_finalize = true;
 		_cv_empty.notify_all();
@@ -447,7 +609,9 @@ public:
 		IF_QUEUE_STAT(
 			++_ops;
 		)
+		uint64 waitStart = 0;
 		while(*_prod_s_p == sq_fill) {
+			beginPushWait(waitStart);
 			IF_QUEUE_STAT(
 				++_wPush;
 				_swPush.proceed();
@@ -457,6 +621,7 @@ public:
 				_swPush.hold();
 			)
 		}
+		endPushWait(waitStart);
 
 		T* swap = *_prod_d_p;
 		*(_prod_d_p++) = item;
@@ -478,7 +643,9 @@ public:
 
 	bool swapPop(T* &item) {
 		std::unique_lock<std::mutex> ulock(_mtx);
+		uint64 waitStart = 0;
 		while(!_finalize && !_size) {
+			beginPopWait(waitStart);
 			IF_QUEUE_STAT(
 				++_wPop;
 				_swPop.proceed();
@@ -488,6 +655,7 @@ public:
 				_swPop.hold();
 			)
 		}
+		endPopWait(waitStart);
 		if(!_size)
 			return false;
 
@@ -527,7 +695,7 @@ public:
 };
 
 template <typename T>
-class SyncSwapQueueMPMC{
+class SyncSwapQueueMPMC: public MonitoredQueue{
 	typedef enum {sq_empty, sq_fill} TSQState;
 
 	T** _data;
@@ -579,6 +747,7 @@ public:
 	}
 
 	~SyncSwapQueueMPMC(){
+		unmonitor();
 		/*for(_cons_d_p = _data, _prod_d_p = _data + _maxSize; _cons_d_p < _prod_d_p; _cons_d_p++)
 			if(*_cons_d_p)
 				delete *_cons_d_p;*/
@@ -602,6 +771,13 @@ public:
 	  return !_size;
 	}
 
+	void sample(QueueSample &sample) {
+		std::unique_lock<std::mutex> lock(_mtx);
+		sample.fill = _size;
+		sample.capacity = _maxSize;
+		sampleWaits(sample);
+	}
+
 	void finalize() {
 		_finalize = true;
 		_cv_empty.notify_all();
@@ -615,7 +791,9 @@ public:
 		IF_QUEUE_STAT(
 			++_ops;
 		)
+		uint64 waitStart = 0;
 		while(*_prod_s_p == sq_fill) {
+			beginPushWait(waitStart);
 			IF_QUEUE_STAT(
 				++_wPush;
 				_swPush.proceed();
@@ -625,6 +803,7 @@ public:
 				_swPush.hold();
 			)
 		}
+		endPushWait(waitStart);
 
 		T* swap = *_prod_d_p;
 		*(_prod_d_p++) = item;
@@ -646,7 +825,9 @@ public:
 
 	bool swapPop(T* &item) {
 		std::unique_lock<std::mutex> ulock(_mtx);
+		uint64 waitStart = 0;
 		while(!_finalize && !_size) {
+			beginPopWait(waitStart);
 			IF_QUEUE_STAT(
 				++_wPop;
 				_swPop.proceed();
@@ -656,6 +837,7 @@ public:
 				_swPop.hold();
 			)
 		}
+		endPopWait(waitStart);
 		if(!_size)
 			return false;
 
@@ -0,0 +1,92 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "SyncQueue.h"
+
+namespace gerbil {
+
+/*
+ * statistic of a single stage
+ * components add their counters (aggregated over all threads) at the end of the stage
+ */
+class TelemetryStage {
+	std::string _name;                                          // name of stage
+	std::vector<std::pair<std::string, uint64>> _counters;      // counters (bytes, reads, k-mers, ...)
+	std::vector<std::pair<std::string, double>> _values;        // times and rates
+
+public:
+	TelemetryStage(const std::string &name) : _name(name) {}
+
+	const std::string &getName() const { return _name; }
+
+	// adds a counter (counters with the same name are summed up)
+	void add(const std::string &name, const uint64 &value);
+
+	// sets a value (times in s, rates)
+	void set(const std::string &name, const double &value);
+
+	// adds the blocking statistic of a queue
+	void addQueue(const std::string &name, const SyncQueueStat &stat);
+
+	// returns a counter (0 if missing)
+	uint64 getCounter(const std::string &name) const;
+
+	// returns a value (0 if missing)
+	double getValue(const std::string &name) const;
+
+	void fprintJson(FILE *file) const;
+};
+
+/*
+ * always-on registry of statistics of all stages, exported as JSON report
+ */
+class Telemetry {
+	std::vector<std::pair<std::string, std::string>> _params;  // parameters of the run
+	std::deque<TelemetryStage> _stages;                         // stages in order of creation (stable references)
+
+public:
+	// sets a parameter of the run (k, threads, memory, ...)
+	void setParam(const std::string &name, const std::string &value);
+
+	void setParam(const std::string &name, const uint64 &value);
+
+	// returns the stage with the given name (created at the first call)
+	TelemetryStage &getStage(const std::string &name);
+
+	const std::deque<TelemetryStage> &getStages() const { return _stages; }
+
+	void clear();
+
+	// writes the report, returns false on failure
+	bool saveJson(const std::string &fileName) const;
+};
+
+}
+
+#endif /* TELEMETRY_H_ */
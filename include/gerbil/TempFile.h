@@ -22,6 +22,11 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef BINFILE_H_
 #define BINFILE_H_
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include "Bundle.h"
 
 namespace gerbil {
@@ -29,6 +34,10 @@ namespace gerbil {
 	class TempFile {
 		static uint_tfn __nextId;       // guaranteed unique ids
 
+		static std::atomic<uint64> __memoryUsage;   // memory of all in-memory bins
+		static uint64 __memoryLimit;                // limit for all in-memory bins
+		static std::atomic<uint64> __memoryPeak;    // max. memory of all in-memory bins
+
 		uint_tfn _id;                   // id of bin file
 
 		std::string _filename;          // filename
@@ -42,16 +51,70 @@ namespace gerbil {
 
 		uint64 _numberOfRuns;           // number of runs
 
+		bool _inMemory;                 // bin is kept in memory (instead of file)
+		std::vector<byte *> _blocks;    // memory blocks: [uint32 size][SuperBundle data] entries
+		uint64 _blockSize;              // size of last block
+		uint64 _blockFilled;            // filled bytes of last block
+		uint64 _memorySize;             // total size of all blocks
+		uint64 _readBlock;              // read position (block)
+		uint64 _readOffset;             // read position (offset in block)
+
+		bool _pipelined;                // bin is handed over to step2 as soon as it is complete
+		bool _announced;                // final statistic is known
+		bool _complete;                 // all SuperBundles are written, bin is closed
+		uint64 _writtenNumber;          // number of written SuperBundles
+		uint64 _expectedNumber;         // number of announced SuperBundles
+		std::mutex _completeMutex;
+		std::condition_variable _completeCV;
+
+		// closes the bin if all announced SuperBundles are written (requires lock)
+		void checkComplete();
+
+		// appends a SuperBundle to memory, returns false if the memory limit is exceeded
+		bool writeM(const byte *data, const uint32 &size);
+
+		// moves all SuperBundles from memory to file
+		bool spill();
+
+		void freeMemory();
+
 	public:
+		// sets the limit of memory for all in-memory bins
+		static void setMemoryLimit(const uint64 &limit) { __memoryLimit = limit; }
+
+		// returns the memory of all in-memory bins
+		static uint64 getMemoryUsage() { return __memoryUsage.load(); }
+
+		// returns the max. memory of all in-memory bins
+		static uint64 getMemoryPeak() { return __memoryPeak.load(); }
 
 		TempFile();
 
+		// bin without a file and without a unique id (statistic only, e.g. the calibration)
+		explicit TempFile(const uint_tfn &id);
+
 		void loadStats(std::string path, FILE *file);
 
 		~TempFile();
 
 		bool openW(const std::string filename);
 
+		// keeps the bin in memory, falls back to the file if the memory limit is exceeded
+		bool openM(const std::string filename);
+
+		bool isInMemory() const { return _inMemory; }
+
+		// statistic is not updated by write(), but announced by the producer of the SuperBundles
+		void setPipelined() { _pipelined = true; }
+
+		bool isPipelined() const { return _pipelined; }
+
+		// sets the final statistic of a pipelined bin, the bin is complete after the last SuperBundle is written
+		void announce(const uint64 &superBundles, const uint64 &smers, const uint64 &kmers);
+
+		// blocks until all SuperBundles of a pipelined bin are written
+		void waitUntilComplete();
+
 		bool openR();
 
 		bool write(SuperBundle *superBundle);
@@ -71,7 +134,7 @@ namespace gerbil {
 		const uint64 &getSize() const;
 
 		inline const void calcNumberOfRuns(const double ratio, const uint64 maxUkmers);
-		inline const void initNumberOfRuns() { _numberOfRuns = 1; }
+		inline const void initNumberOfRuns(const uint64 &runs = 1) { _numberOfRuns = runs; }
 
 		const uint64 &getNumberOfRuns() const;
 
@@ -37,6 +37,10 @@ namespace gerbil {
 
 #define HYBRID_COUNTER false
 
+// k-mers of the KMerBundles and hash tables of the CPU hashers take getKMerCompactByteNumbers<K>() bytes
+// (four bases per byte), else sizeof(KMer<K>)
+#define KMER_PACKED true
+
 #ifdef GPU
 #define IF_GPU(x) x
 #else
@@ -83,8 +87,22 @@ namespace gerbil {
 #define FILL_GPU 0.5
 #define START_RATIO FILL
 
+// hash policy of the hash tables and the KmerDistributer (KMerHash.h),
+// KMerHashNt rolls the hash while splitting super-mers (k > 32, mix otherwise)
+#define KMER_HASH_POLICY KMerHashNt
+
+// minimal k of the word by word k-mer extraction of the splitter (KMerExtractor.h),
+// shorter k-mers are shifted per base (as fast up to three words)
+#define KMER_EXTRACTOR_MIN_K 96
+
 #define HISTOGRAM_SIZE 512
 
+// prefilter of the hash tables (Application::setPrefilter): bits per expected distinct k-mer of a bin
+// and bits per k-mer of the blocked bloom filter, in-memory KMerBundles of the first occurrences
+#define BLOOM_FILTER_BITS 8
+#define BLOOM_FILTER_HASHES 4
+#define PREFILTER_KMER_BUNDLES_NUMBER_PER_THREAD 8
+
 
 /*
  * default parameters
@@ -96,7 +114,10 @@ namespace gerbil {
 #define DEF_KMER_RANGE 128
 #define DEF_KMER_SIZE 28
 #define MIN_KMER_SIZE 8
-#define MAX_KMER_SIZE 128//DEF_KMER_RANGE+MIN_KMER_SIZE // re defined in bella with 128
+#define MAX_KMER_SIZE 512//DEF_KMER_RANGE+MIN_KMER_SIZE // re defined in bella with 128
+#ifndef MAX_STATIC_KMER_SIZE
+#define MAX_STATIC_KMER_SIZE 0		// 0: one instantiation per number of words (KMER_DYN(c)), 128: one per k <= 128
+#endif
 
 #define DEF_MEMORY_SIZE ((uint64_t)  4 * 1024)
 #define MIN_MEMORY_SIZE ((uint64_t)       512)
@@ -120,6 +141,10 @@ namespace gerbil {
 
 #define FAILUREBUFFER_KMER_BUNDLES_NUMBER_PER_THREAD 1
 
+// second-level hash tables of the CPU hashers (FailureTable): initial number of entries (power of 2), maximal fill
+#define FAILURETABLE_MIN_SIZE 4096
+#define FAILURETABLE_FILL 0.7
+
 #define SB_WRITER_THREADS_NUMBER 1
 
 
@@ -160,6 +185,27 @@ namespace gerbil {
 
 #define MEM_KEY_HT    0.8
 
+// in-memory bins (step1 --> step2 without temp files)
+#define IN_MEMORY_BINS_MAX_RATIO         0.5                 // max. share of memory for bins
+#define TEMPFILE_MEMORY_BLOCK_MIN_SIZE_B    KB_TO_B( 64)
+#define TEMPFILE_MEMORY_BLOCK_MAX_SIZE_B    MB_TO_B(  4)
+
+#define QUEUE_MONITOR_INTERVAL_MS          10                 // default sampling interval of queues
+#define PROGRESS_INTERVAL_MS             1000                 // default interval of progress reports
+
+// auto tuner (calibration of the stages on a synthetic sample)
+#define AUTOTUNE_SAMPLE_BASES            MB_TO_B(  4)         // bases of the sample (phase one)
+#define AUTOTUNE_SAMPLE_KMERS            MB_TO_B(  1)         // max. k-mers of the sample (phase two)
+#define AUTOTUNE_HASHTABLE_SIZE_B        MB_TO_B( 64)         // hash table of the calibration (beyond the caches)
+#define AUTOTUNE_READ_LENGTH             1000                 // length of the sampled reads
+#define AUTOTUNE_COVERAGE                4                    // coverage of the random genome of the sample
+#define AUTOTUNE_QUEUE_BUFFER_MS         250                  // queues buffer this time of the consumer throughput
+#define AUTOTUNE_HEADROOM                1.25                 // over-provisioning of consuming stages
+
+// huge pages (hash tables and KMerBundle pools, optional)
+#define HUGE_PAGE_SIZE_B                 MB_TO_B(  2)         // slab of the bundle pools, alignment of THP
+#define HUGE_PAGE_1G_SIZE_B              GB_TO_B(  1)
+
 #define NULL_BUCKET_VALUE UINT_MAX
 
 
@@ -173,6 +219,9 @@ namespace gerbil {
 #define LOOP256(N, X) LOOP128(N-128, X); LOOP128(N, X)
 #define LOOP512(N, X) LOOP256(N-256, X); LOOP256(N, X)
 
+// word numbers c of KMER_DYN(c) for k <= MAX_KMER_SIZE
+#define LOOP_KMER_DYN(X) X(1); X(2); X(3); X(4); X(5); X(6); X(7); X(8); X(9); X(10); X(11); X(12); X(13); X(14); X(15); X(16); X(17)
+
 }
 
 #endif /* CONFIG_H_ */
@@ -0,0 +1,157 @@
+/*
+ * ReadGenerator.cpp
+ */
+
+#include "ReadGenerator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+gerbil::ReadGeneratorConfig gerbil::ReadGeneratorConfig::shortReads() {
+	ReadGeneratorConfig config;
+	config.genomeSize = 5000000;
+	config.coverage = 30;
+	config.errorRate = 0.001;
+	config.indelRatio = 0.0;
+	config.readLength = rl_normal;
+	config.readLengthMean = 150;
+	config.readLengthSd = 0;
+	config.seed = 1;
+	return config;
+}
+
+gerbil::ReadGeneratorConfig gerbil::ReadGeneratorConfig::longReads() {
+	ReadGeneratorConfig config;
+	config.genomeSize = 5000000;
+	config.coverage = 30;
+	config.errorRate = 0.12;
+	config.indelRatio = 0.8;
+	config.readLength = rl_lognormal;
+	config.readLengthMean = 10000;
+	config.readLengthSd = 5000;
+	config.seed = 1;
+	return config;
+}
+
+gerbil::ReadGenerator::ReadGenerator(const ReadGeneratorConfig &config) : _config(config) {
+	if(!_config.genomeSize)
+		_config.genomeSize = 1;
+	if(!_config.readLengthMean)
+		_config.readLengthMean = 1;
+
+	// genome (independent of the reads)
+	_rng.seed(_config.seed);
+	_genome.resize(_config.genomeSize);
+	for(char &base : _genome)
+		base = randomBase();
+
+	reset();
+}
+
+void gerbil::ReadGenerator::reset() {
+	_rng.seed(_config.seed + 1);
+	_basesNumber = 0;
+	_readsNumber = 0;
+}
+
+double gerbil::ReadGenerator::uniform() {
+	// 53 random bits in [0, 1)
+	return (_rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double gerbil::ReadGenerator::normal() {
+	// Box-Muller
+	const double u1 = 1.0 - uniform();
+	const double u2 = uniform();
+	return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+char gerbil::ReadGenerator::randomBase() {
+	return "ACGT"[_rng() >> 62];
+}
+
+gerbil::uint32 gerbil::ReadGenerator::nextReadLength() {
+	double length;
+	if(_config.readLength == rl_lognormal) {
+		const double mean = _config.readLengthMean;
+		const double sd = _config.readLengthSd;
+		const double sigma2 = std::log(1.0 + sd * sd / (mean * mean));
+		length = std::exp(std::log(mean) - sigma2 / 2 + std::sqrt(sigma2) * normal());
+	}
+	else
+		length = _config.readLengthMean + _config.readLengthSd * normal();
+	length = std::round(length);
+	if(length < 1)
+		return 1;
+	if(length > _config.genomeSize)
+		return _config.genomeSize;
+	return (uint32) length;
+}
+
+bool gerbil::ReadGenerator::next(const char* &read, uint32 &length, const char* &qualities) {
+	if(_basesNumber >= _config.genomeSize * _config.coverage)
+		return false;
+
+	const uint32 readLength = nextReadLength();
+	const uint64 pos = (uint64) (uniform() * (_config.genomeSize - readLength + 1));
+	const bool reverse = uniform() < 0.5;
+
+	_read.clear();
+	for(uint32 i = 0; i < readLength; ++i) {
+		char base;
+		if(reverse) {
+			switch(_genome[pos + readLength - 1 - i]) {
+				case 'A': base = 'T'; break;
+				case 'C': base = 'G'; break;
+				case 'G': base = 'C'; break;
+				default:  base = 'A'; break;
+			}
+		}
+		else
+			base = _genome[pos + i];
+
+		if(uniform() < _config.errorRate) {
+			if(uniform() < _config.indelRatio) {
+				if(uniform() < 0.5)
+					continue;                       // deletion
+				_read.push_back(randomBase());      // insertion
+			}
+			else {
+				// substitution
+				char sub;
+				while((sub = randomBase()) == base);
+				base = sub;
+			}
+		}
+		_read.push_back(base);
+	}
+
+	_basesNumber += readLength;
+	++_readsNumber;
+
+	read = _read.data();
+	length = _read.size();
+	qualities = NULL;
+	return true;
+}
+
+gerbil::uint64 gerbil::ReadGenerator::getBasesNumberHint() {
+	return _config.genomeSize * _config.coverage;
+}
+
+bool gerbil::ReadGenerator::writeFasta(const std::string &fileName) {
+	FILE* file = fopen(fileName.c_str(), "w");
+	if(!file)
+		return false;
+	const char* read;
+	const char* qualities;
+	uint32 length;
+	bool ok = true;
+	while(ok && next(read, length, qualities)) {
+		ok = fprintf(file, ">read%lu\n", _readsNumber) > 0
+			&& fwrite(read, 1, length, file) == length
+			&& fputc('\n', file) != EOF;
+	}
+	return !fclose(file) && ok;
+}
@@ -0,0 +1,90 @@
+/*********************************************************************************
+Copyright (c) 2016 Marius Erbert, Steffen Rechner
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+of the Software, and to permit persons to whom the Software is furnished to do
+so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************************/
+
+#ifndef READGENERATOR_H_
+#define READGENERATOR_H_
+
+#include <string>
+#include <random>
+
+#include "../../include/gerbil/ReadSource.h"
+
+namespace gerbil {
+
+typedef enum {
+	rl_normal,      // short reads (illumina like)
+	rl_lognormal    // long reads (pacbio/nanopore like)
+} TReadLength;
+
+struct ReadGeneratorConfig {
+	uint64 genomeSize;          // number of bases of the random genome
+	double coverage;            // number of read bases / genome size
+	double errorRate;           // probability of an error per base
+	double indelRatio;          // ratio of insertions and deletions of all errors
+	TReadLength readLength;     // distribution of read lengths
+	uint32 readLengthMean;
+	uint32 readLengthSd;
+	uint64 seed;
+
+	// 150 bp, 0.1 % substitutions
+	static ReadGeneratorConfig shortReads();
+
+	// ~10 kbp, 12 % errors (mostly indels)
+	static ReadGeneratorConfig longReads();
+};
+
+/*
+ * deterministic synthetic genome and reads (sampled from both strands)
+ * the same config yields the same reads on all platforms (own distributions on top of mt19937_64)
+ */
+class ReadGenerator : public ReadSource {
+	ReadGeneratorConfig _config;
+	std::string _genome;
+	std::mt19937_64 _rng;
+	uint64 _basesNumber;        // generated bases
+	uint64 _readsNumber;        // generated reads
+	std::string _read;
+
+	double uniform();
+	double normal();
+	uint32 nextReadLength();
+	char randomBase();
+
+public:
+	ReadGenerator(const ReadGeneratorConfig &config);
+
+	// restarts with the first read
+	void reset();
+
+	bool next(const char* &read, uint32 &length, const char* &qualities);
+
+	uint64 getBasesNumberHint();
+
+	// writes all reads (from the current position) as fasta file, returns false on failure
+	bool writeFasta(const std::string &fileName);
+
+	const uint64 &getReadsNumber() const { return _readsNumber; }
+	const uint64 &getBasesNumber() const { return _basesNumber; }
+};
+
+}
+
+#endif /* READGENERATOR_H_ */
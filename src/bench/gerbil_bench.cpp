@@ -0,0 +1,363 @@
+/*
+ * gerbil_bench.cpp
+ *
+ * runs step1, step2 and both steps on synthetic reads for all combinations
+ * of k, threads and memory; each run is a child process (peak RSS per run)
+ * results are written as JSON lines
+ */
+
+#include "../../include/gerbil/Application.h"
+#include "ReadGenerator.h"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <boost/filesystem.hpp>
+
+using namespace gerbil;
+
+// counts the k-mers of step2 instead of writing them
+class CountingConsumer : public KmcConsumer {
+	uint32 _k;
+	uint64 _kMersNumber;
+public:
+	CountingConsumer(const uint32 &k) : _k(k), _kMersNumber(0) {}
+
+	void consume(const KmcBundle &kmcBundle) {
+		const byte* p = kmcBundle.getData();
+		const byte* end = p + kmcBundle.getSize();
+		const byte* kMer;
+		uint32 counter;
+		while(p < end) {
+			p = KmcBundle::nextRecord(p, _k, counter, kMer);
+			++_kMersNumber;
+		}
+	}
+
+	const uint64 &getKMersNumber() const { return _kMersNumber; }
+};
+
+// result of a single run
+struct BenchResult {
+	int status;             // exit status of the child (0: ok)
+	double realtime_s;
+	uint64 kMers;           // k-mers of the step (step1: split, step2: hashed)
+	uint64 uKMers;          // distinct k-mers (step2 only)
+	uint64 outputKMers;     // k-mers passed to the consumer (step2 only)
+	uint64 multiRunBins;    // bins which are read more than once (step2 only)
+	uint64 keyBytes;        // size of a hash table key (step2 only)
+	uint64 overflowCounters; // counters which exceeded their size (step2 only)
+	uint64 singletons;      // k-mers which occurred once, kept out of the hash tables (step2 only)
+	uint64 prefilterSpills; // KMerBundles of first occurrences stored on disk (step2 only)
+	uint64 peakRss_kB;
+};
+
+struct BenchParams {
+	ReadGeneratorConfig readConfig;
+	bool memoryInput;
+	bool quotientKeys;
+	uint32 counterSize_B;
+	bool prefilter;
+	std::string workDir;
+	std::string fastFileName;
+	std::string tempDir;
+};
+
+void printHelp() {
+	printf("gerbil_bench [option]*\n");
+	printf("  -p <short|long>   read preset (default: short)\n");
+	printf("  -g <bases>        genome size\n");
+	printf("  -c <x>            coverage\n");
+	printf("  -r <rate>         error rate\n");
+	printf("  -a <ratio>        ratio of indels of all errors\n");
+	printf("  -l <mean>[:<sd>]  read length\n");
+	printf("  -s <seed>         seed of the generator (default: 1)\n");
+	printf("  -i <file|memory>  input of step1 (default: file)\n");
+	printf("  -k <list>         k-mer sizes (default: 31)\n");
+	printf("  -t <list>         numbers of threads (default: 4)\n");
+	printf("  -e <list>         memory sizes in MB (default: 0 => auto)\n");
+	printf("  -x <list>         steps: 1, 2 and/or e2e (default: 1,2,e2e)\n");
+	printf("  -q <0|1>          quotient keys in the hash tables (default: 0)\n");
+	printf("  -w <1|2|4>        bytes of the counters of the hash tables (default: 4)\n");
+	printf("  -b <0|1>          bloom prefilter of the hash tables (default: 0)\n");
+	printf("  -d <dir>          working directory (default: gerbil_bench.tmp)\n");
+	printf("  -o <file>         results as JSON lines (default: stdout)\n");
+	printf("lists are separated by ',', e.g. -k 21,31,55\n");
+}
+
+std::vector<std::string> splitList(const std::string &list) {
+	std::vector<std::string> items;
+	std::stringstream ss(list);
+	std::string item;
+	while(std::getline(ss, item, ','))
+		if(!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+std::vector<uint64> splitNumbers(const std::string &list) {
+	std::vector<uint64> numbers;
+	for(const std::string &item : splitList(list))
+		numbers.push_back(std::stoull(item));
+	return numbers;
+}
+
+void cleanDir(const std::string &dir) {
+	boost::filesystem::remove_all(dir);
+	boost::filesystem::create_directories(dir);
+}
+
+// executed by the child, the result is written to fd
+void runStep(const BenchParams &params, const std::string &step, const uint32 &k,
+		const uint32 &threads, const uint64 &memory, const int &fd) {
+	// gerbil prints its progress to stdout
+	const int devNull = open("/dev/null", O_WRONLY);
+	if(devNull >= 0)
+		dup2(devNull, STDOUT_FILENO);
+	verbose = false;
+
+	// step1 reads from memory: all reads are generated before the run (part of the peak RSS)
+	std::vector<std::string> reads;
+	if(params.memoryInput && step != "2") {
+		ReadGenerator generator(params.readConfig);
+		const char* read;
+		const char* qualities;
+		uint32 length;
+		while(generator.next(read, length, qualities))
+			reads.push_back(std::string(read, length));
+	}
+	MemoryReadSource readSource(reads);
+
+	Application application(0.002, params.readConfig.errorRate, false, (int) params.readConfig.coverage, k,
+			params.memoryInput ? "" : params.fastFileName, params.tempDir + "/", DEF_THRESHOLD_MIN,
+			params.workDir + "/out", true);
+	CountingConsumer consumer(k);
+	application.setKmcConsumer(&consumer);
+	if(params.memoryInput)
+		application.setReadSource(&readSource);
+	application.setThreadsNumber(threads);
+	application.setMemorySize(memory);
+	application.setQuotientKeys(params.quotientKeys);
+	application.setCounterSize(params.counterSize_B);
+	application.setPrefilter(params.prefilter);
+	if(step == "1") {
+		application.setSingleStep(1);
+		application.setLeaveBinStat(true);
+	}
+	else if(step == "2") {
+		application.setSingleStep(2);
+		application.setLeaveBinStat(true);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	application.process();
+	const double realtime_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BenchResult result = {0, realtime_s, 0, 0, consumer.getKMersNumber(), 0, 0, 0, 0, 0, 0};
+	for(const TelemetryStage &stage : application.getTelemetry().getStages()) {
+		if(stage.getName() == "stage1" && step == "1")
+			result.kMers = stage.getCounter("splitter.kMers");
+		else if(stage.getName() == "stage2") {
+			result.kMers = stage.getCounter("hasher.kMers");
+			result.uKMers = stage.getCounter("hasher.uKMers");
+			result.multiRunBins = stage.getCounter("superReader.multiRunBins");
+			result.keyBytes = stage.getCounter("hasher.keyBytes");
+			result.overflowCounters = stage.getCounter("hasher.overflowCounters");
+			result.singletons = stage.getCounter("hasher.singletons");
+			result.prefilterSpills = stage.getCounter("hasher.prefilterSpills");
+		}
+	}
+	if(write(fd, &result, sizeof(result)) != sizeof(result))
+		exit(1);
+}
+
+// runs a step in a child process
+BenchResult benchStep(const BenchParams &params, const std::string &step, const uint32 &k,
+		const uint32 &threads, const uint64 &memory) {
+	BenchResult result = {-1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+	int fds[2];
+	if(pipe(fds)) {
+		perror("pipe");
+		return result;
+	}
+	fflush(stdout);
+	const pid_t pid = fork();
+	if(pid < 0) {
+		perror("fork");
+		return result;
+	}
+	if(!pid) {
+		close(fds[0]);
+		runStep(params, step, k, threads, memory, fds[1]);
+		_exit(0);
+	}
+	close(fds[1]);
+	BenchResult childResult;
+	const bool received = read(fds[0], &childResult, sizeof(childResult)) == sizeof(childResult);
+	close(fds[0]);
+
+	int status;
+	struct rusage usage;
+	if(wait4(pid, &status, 0, &usage) != pid)
+		return result;
+	if(received)
+		result = childResult;
+	result.status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+	if(!received && !result.status)
+		result.status = -1;
+	result.peakRss_kB = usage.ru_maxrss;
+	return result;
+}
+
+void printResult(FILE* out, const BenchParams &params, const std::string &step, const uint32 &k,
+		const uint32 &threads, const uint64 &memory, const uint64 &readsNumber, const BenchResult &result) {
+	fprintf(out, "{\"step\": \"%s\", \"k\": %u, \"threads\": %u, \"memory_mb\": %lu, \"input\": \"%s\", "
+			"\"quotientKeys\": %s, \"counterBytes\": %u, \"prefilter\": %s, \"status\": %d", step.c_str(), k,
+			threads, memory, params.memoryInput ? "memory" : "file", params.quotientKeys ? "true" : "false",
+			params.counterSize_B, params.prefilter ? "true" : "false", result.status);
+	if(!result.status) {
+		fprintf(out, ", \"realtime_s\": %.6f, \"reads\": %lu, \"kMers\": %lu", result.realtime_s, readsNumber, result.kMers);
+		if(step != "1")
+			fprintf(out, ", \"uKMers\": %lu, \"outputKMers\": %lu, \"multiRunBins\": %lu, \"keyBytes\": %lu, "
+					"\"overflowCounters\": %lu, \"singletons\": %lu, \"prefilterSpills\": %lu", result.uKMers,
+					result.outputKMers, result.multiRunBins, result.keyBytes, result.overflowCounters, result.singletons,
+					result.prefilterSpills);
+		fprintf(out, ", \"reads_per_s\": %.1f, \"kMers_per_s\": %.1f",
+				result.realtime_s ? readsNumber / result.realtime_s : 0,
+				result.realtime_s ? result.kMers / result.realtime_s : 0);
+	}
+	fprintf(out, ", \"peakRss_kB\": %lu}\n", result.peakRss_kB);
+	fflush(out);
+}
+
+int main(int argc, char** argv) {
+	BenchParams params;
+	params.readConfig = ReadGeneratorConfig::shortReads();
+	params.memoryInput = false;
+	params.quotientKeys = false;
+	params.counterSize_B = sizeof(uint_cv);
+	params.prefilter = false;
+	params.workDir = "gerbil_bench.tmp";
+
+	std::vector<uint64> ks(1, 31), threadsNumbers(1, 4), memorySizes(1, 0);
+	std::vector<std::string> steps = {"1", "2", "e2e"};
+	std::string outFileName;
+
+	// parse options (presets first, single values override them)
+	for(int i = 1; i + 1 < argc; i += 2)
+		if(!strcmp(argv[i], "-p"))
+			params.readConfig = strcmp(argv[i + 1], "long") ? ReadGeneratorConfig::shortReads()
+			                                                 : ReadGeneratorConfig::longReads();
+	for(int i = 1; i < argc; i += 2) {
+		if(i + 1 >= argc || argv[i][0] != '-' || strlen(argv[i]) != 2) {
+			printHelp();
+			return 1;
+		}
+		const std::string value(argv[i + 1]);
+		try {
+			switch(argv[i][1]) {
+				case 'p': break;
+				case 'g': params.readConfig.genomeSize = std::stoull(value); break;
+				case 'c': params.readConfig.coverage = std::stod(value); break;
+				case 'r': params.readConfig.errorRate = std::stod(value); break;
+				case 'a': params.readConfig.indelRatio = std::stod(value); break;
+				case 'l': {
+					const size_t colon = value.find(':');
+					params.readConfig.readLengthMean = std::stoul(value.substr(0, colon));
+					if(colon != std::string::npos)
+						params.readConfig.readLengthSd = std::stoul(value.substr(colon + 1));
+					break;
+				}
+				case 's': params.readConfig.seed = std::stoull(value); break;
+				case 'i': params.memoryInput = value == "memory"; break;
+				case 'k': ks = splitNumbers(value); break;
+				case 't': threadsNumbers = splitNumbers(value); break;
+				case 'e': memorySizes = splitNumbers(value); break;
+				case 'x': steps = splitList(value); break;
+				case 'q': params.quotientKeys = std::stoul(value); break;
+				case 'w': params.counterSize_B = std::stoul(value); break;
+				case 'b': params.prefilter = std::stoul(value); break;
+				case 'd': params.workDir = value; break;
+				case 'o': outFileName = value; break;
+				default:
+					printHelp();
+					return 1;
+			}
+		} catch(const std::exception &e) {
+			std::cerr << "invalid value '" << value << "' of option " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	FILE* out = outFileName.empty() ? stdout : fopen(outFileName.c_str(), "w");
+	if(!out) {
+		std::cerr << "unable to create '" << outFileName << "'" << std::endl;
+		return 23;
+	}
+
+	params.fastFileName = params.workDir + "/reads.fa";
+	params.tempDir = params.workDir + "/temp";
+	boost::filesystem::create_directories(params.workDir);
+
+	// generate the reads once (the file is the input of step1 unless -i memory)
+	ReadGenerator generator(params.readConfig);
+	if(params.memoryInput) {
+		const char* read;
+		const char* qualities;
+		uint32 length;
+		while(generator.next(read, length, qualities));
+	}
+	else if(!generator.writeFasta(params.fastFileName)) {
+		std::cerr << "unable to write '" << params.fastFileName << "'" << std::endl;
+		return 23;
+	}
+	const ReadGeneratorConfig &rc = params.readConfig;
+	fprintf(out, "{\"dataset\": {\"genomeSize\": %lu, \"coverage\": %g, \"errorRate\": %g, \"indelRatio\": %g, "
+			"\"readLength\": \"%s\", \"readLengthMean\": %u, \"readLengthSd\": %u, \"seed\": %lu, "
+			"\"reads\": %lu, \"bases\": %lu}}\n",
+			rc.genomeSize, rc.coverage, rc.errorRate, rc.indelRatio,
+			rc.readLength == rl_lognormal ? "lognormal" : "normal", rc.readLengthMean, rc.readLengthSd, rc.seed,
+			generator.getReadsNumber(), generator.getBasesNumber());
+	fflush(out);
+
+	const bool step1 = std::find(steps.begin(), steps.end(), "1") != steps.end();
+	const bool step2 = std::find(steps.begin(), steps.end(), "2") != steps.end();
+	const bool e2e = std::find(steps.begin(), steps.end(), "e2e") != steps.end();
+
+	for(const uint64 &k : ks)
+		for(const uint64 &threads : threadsNumbers)
+			for(const uint64 &memory : memorySizes) {
+				std::cerr << "k=" << k << " threads=" << threads << " memory=" << memory << " MB" << std::endl;
+				if(step1 || step2) {
+					// step2 processes the bins of step1
+					cleanDir(params.tempDir);
+					const BenchResult result = benchStep(params, "1", k, threads, memory);
+					if(step1)
+						printResult(out, params, "1", k, threads, memory, generator.getReadsNumber(), result);
+					if(step2) {
+						if(result.status)
+							printResult(out, params, "2", k, threads, memory, generator.getReadsNumber(), result);
+						else
+							printResult(out, params, "2", k, threads, memory, generator.getReadsNumber(),
+									benchStep(params, "2", k, threads, memory));
+					}
+				}
+				if(e2e) {
+					cleanDir(params.tempDir);
+					printResult(out, params, "e2e", k, threads, memory, generator.getReadsNumber(),
+							benchStep(params, "e2e", k, threads, memory));
+				}
+			}
+
+	boost::filesystem::remove_all(params.tempDir);
+	boost::filesystem::remove(params.fastFileName);
+	boost::filesystem::remove(params.workDir + "/out");
+	if(out != stdout)
+		fclose(out);
+	return 0;
+}
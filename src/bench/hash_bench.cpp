@@ -0,0 +1,237 @@
+/*
+ * hash_bench.cpp
+ *
+ * compares the hash policies (KMerHash.h) on random and low-complexity k-mers:
+ * uniformity of the KmerDistributer buckets (chi-square), collisions of the full hashes and probe lengths of the
+ * hash table fill (as in cpu::HasherTask); for rolling policies, the rolled hashes of the
+ * canonical k-mers of a long super-mer are checked against the hashes computed from scratch;
+ * results are written as JSON lines
+ */
+
+#include "../../include/gerbil/KMerHash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace gerbil;
+
+// buckets of the KmerDistributer
+#define HASH_BENCH_BUCKETS 512
+
+// hashers of the probe benchmark (the table gets the k-mers of the first hasher)
+#define HASH_BENCH_HASHERS 8
+
+// kinds of input bases
+enum HashBenchInput {
+	hbi_random,         // random bases
+	hbi_lowComplexity,  // short tandem repeats (period 1-6)
+	hbi_periodic        // tandem repeats with periods which divide 64 (1-64)
+};
+
+// random bases or tandem repeats with 2 % substitutions
+std::vector<uint8_t> generateBases(const uint64 &n, const HashBenchInput &input, std::mt19937_64 &rng) {
+	std::vector<uint8_t> bases;
+	bases.reserve(n);
+	while(bases.size() < n) {
+		if(input == hbi_random) {
+			bases.push_back(rng() & 0x3);
+			continue;
+		}
+		uint8_t unit[64];
+		const uint32 period = input == hbi_periodic ? 1 << (rng() % 7) : 1 + rng() % 6;
+		for(uint32 i = 0; i < period; ++i)
+			unit[i] = rng() & 0x3;
+		const uint32 length = 50 + rng() % 450;
+		for(uint32 i = 0; i < length && bases.size() < n; ++i)
+			bases.push_back(rng() % 50 ? unit[i % period] : rng() & 0x3);
+	}
+	return bases;
+}
+
+// distinct canonical k-mers of all positions (4 bases per byte as in the super-mers)
+template<unsigned K>
+std::vector<KMer<K>> getKMers(const std::vector<uint8_t> &bases) {
+	const uint32 B = GET_KMER_B(K);
+	std::vector<KMer<K>> kMers;
+	std::vector<byte> bytes(sizeof(KMer<K>) + 64);
+	for(uint64 p = 0; p + 4 * B <= bases.size(); ++p) {
+		for(uint32 i = 0; i < B; ++i)
+			bytes[i] = bases[p + 4 * i] << 6 | bases[p + 4 * i + 1] << 4 | bases[p + 4 * i + 2] << 2 | bases[p + 4 * i + 3];
+		KMer<K> kMer, iKMer;
+		KMer<K>::set(bytes.data(), kMer, iKMer);
+		kMers.push_back(kMer.getNormalized(iKMer));
+	}
+	std::sort(kMers.begin(), kMers.end());
+	kMers.erase(std::unique(kMers.begin(), kMers.end(),
+			[](const KMer<K> &a, const KMer<K> &b) { return a.isEqual(b); }), kMers.end());
+	return kMers;
+}
+
+// maximal number of probes of a k-mer (as in cpu::HasherTask)
+uint32 getMaxSteps(uint64 partSize) {
+	uint32 ms = 5;
+	while(partSize >>= 1)
+		++ms;
+	return ms;
+}
+
+template<unsigned K, typename H>
+void benchPolicy(const std::vector<KMer<K>> &kMers, const char* input) {
+	// uniformity of the buckets
+	std::vector<uint64> buckets(HASH_BENCH_BUCKETS, 0);
+	for(const KMer<K> &kMer : kMers)
+		++buckets[H::partHash(kMer) % HASH_BENCH_BUCKETS];
+	const double expected = (double) kMers.size() / HASH_BENCH_BUCKETS;
+	double chi2 = 0;
+	uint64 maxBucket = 0;
+	for(const uint64 &b : buckets) {
+		chi2 += (b - expected) * (b - expected) / expected;
+		maxBucket = std::max(maxBucket, b);
+	}
+
+	// collisions of the full hashes (k-mers which share a hash with another k-mer)
+	std::unordered_map<uint64, uint32> hashes;
+	hashes.reserve(kMers.size());
+	uint32 maxPerHash = 0;
+	for(const KMer<K> &kMer : kMers)
+		maxPerHash = std::max(maxPerHash, ++hashes[H::hash(kMer)]);
+	const uint64 collisions = kMers.size() - hashes.size();
+
+	// k-mers of the first hasher (buckets are split into equal ranges)
+	std::vector<KMer<K>> part;
+	for(const KMer<K> &kMer : kMers)
+		if(H::partHash(kMer) % HASH_BENCH_BUCKETS < HASH_BENCH_BUCKETS / HASH_BENCH_HASHERS)
+			part.push_back(kMer);
+	std::shuffle(part.begin(), part.end(), std::mt19937_64(2));
+
+	// fill of a table with load FILL
+	const uint64 partSize = std::max<uint64>(part.size() / FILL, 128);
+	const uint32 maxSteps = getMaxSteps(partSize);
+	std::vector<KMer<K>> keys(partSize);
+	std::vector<uint_cv> values(partSize);
+	for(KMer<K> &key : keys)
+		key.clear();
+	uint64 probes = 0, maxProbes = 0, failures = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for(const KMer<K> &kMer : part) {
+		uint64 hPos = H::hash(kMer) % partSize;
+		uint64 i = 0;
+		while(true) {
+			KMer<K>* curKey = keys.data() + hPos;
+			if(curKey->isEmpty()) {
+				values[hPos] = 1;
+				curKey->set(kMer);
+				break;
+			}
+			if(curKey->isEqual(kMer)) {
+				++values[hPos];
+				break;
+			}
+			if(++i > maxSteps) {
+				++failures;
+				break;
+			}
+			hPos += i * i;
+			hPos %= partSize;
+		}
+		probes += i + 1;
+		maxProbes = std::max(maxProbes, i + 1);
+	}
+	const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	printf("{\"k\": %u, \"input\": \"%s\", \"policy\": \"%s\", \"kmers\": %lu, \"bucket_chi2_per_df\": %.3f, "
+	       "\"bucket_max_per_mean\": %.3f, \"hash_collisions\": %lu, \"max_kmers_per_hash\": %u, "
+	       "\"hasher_kmers\": %lu, \"probes_per_kmer\": %.3f, \"max_probes\": %lu, "
+	       "\"failures\": %lu, \"ns_per_kmer\": %.2f}\n",
+	       K, input, H::getName(), kMers.size(), chi2 / (HASH_BENCH_BUCKETS - 1), maxBucket / expected,
+	       collisions, maxPerHash, part.size(), part.empty() ? 0 : (double) probes / part.size(), maxProbes, failures,
+	       part.empty() ? 0 : ns / part.size());
+}
+
+// rolls over all bases (one super-mer, as in the splitter) and compares with hashing from scratch
+template<unsigned K, typename H>
+void benchRolling(const std::vector<uint8_t> &bases, const char* input) {
+	if(!H::template isRolling<K>() || bases.size() < K)
+		return;
+	std::vector<byte> bytes(bases.size() / 4 + 1 + sizeof(KMer<K>));
+	for(uint64 i = 0; i < bases.size(); ++i)
+		bytes[i >> 2] |= bases[i] << (6 - ((i & 0x3) << 1));
+	const byte* b = bytes.data();
+	const uint64 kMersNumber = bases.size() - K + 1;
+
+	// rolled (partHash and hash as the splitter and the hasher)
+	auto start = std::chrono::steady_clock::now();
+	uint64 fwd, rev, x = 0;
+	H::template init<K>(b, fwd, rev);
+	x += H::partHashOf(fwd, rev) ^ H::hashOf(fwd, rev);
+	for(uint64 i = K; i < bases.size(); ++i) {
+		H::template roll<K>(fwd, rev, bases[i - K], bases[i]);
+		x += H::partHashOf(fwd, rev) ^ H::hashOf(fwd, rev);
+	}
+	const double rolledNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	// from scratch (of the canonical k-mers)
+	KMer<K> kMer, iKMer;
+	uint64 y = 0, mismatches = 0;
+	start = std::chrono::steady_clock::now();
+	KMer<K>::set(b, kMer, iKMer);
+	y += H::partHash(kMer.getNormalized(iKMer)) ^ H::hash(kMer.getNormalized(iKMer));
+	for(uint64 i = K; i < bases.size(); ++i) {
+		kMer.next(bases[i]);
+		iKMer.nextInv(bases[i]);
+		const KMer<K> &nKMer = kMer.getNormalized(iKMer);
+		y += H::partHash(nKMer) ^ H::hash(nKMer);
+	}
+	const double scratchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+	// check (per k-mer)
+	KMer<K>::set(b, kMer, iKMer);
+	H::template init<K>(b, fwd, rev);
+	mismatches += H::hash(kMer.getNormalized(iKMer)) != H::hashOf(fwd, rev);
+	for(uint64 i = K; i < bases.size(); ++i) {
+		kMer.next(bases[i]);
+		iKMer.nextInv(bases[i]);
+		H::template roll<K>(fwd, rev, bases[i - K], bases[i]);
+		const KMer<K> &nKMer = kMer.getNormalized(iKMer);
+		mismatches += H::hash(nKMer) != H::hashOf(fwd, rev) || H::partHash(nKMer) != H::partHashOf(fwd, rev);
+	}
+
+	printf("{\"k\": %u, \"input\": \"%s\", \"policy\": \"%s\", \"kmers\": %lu, \"rolled_ns_per_kmer\": %.2f, "
+	       "\"scratch_ns_per_kmer\": %.2f, \"mismatches\": %lu, \"sums_equal\": %s}\n",
+	       K, input, H::getName(), kMersNumber, rolledNs / kMersNumber, scratchNs / kMersNumber, mismatches,
+	       x == y ? "true" : "false");
+}
+
+template<unsigned K>
+void benchK(const std::vector<uint8_t> &bases, const char* input) {
+	const std::vector<KMer<K>> kMers = getKMers<K>(bases);
+	benchPolicy<K, KMerHashLegacy>(kMers, input);
+	benchPolicy<K, KMerHashMix>(kMers, input);
+	benchPolicy<K, KMerHashCrc32c>(kMers, input);
+	benchPolicy<K, KMerHashNt>(kMers, input);
+	benchRolling<K, KMerHashNt>(bases, input);
+}
+
+int main(int argc, char** argv) {
+	if(argc > 2) {
+		printf("hash_bench [<bases>]\n");
+		return 1;
+	}
+	const uint64 basesNumber = argc > 1 ? std::stoull(argv[1]) : 1 << 22;
+
+	std::mt19937_64 rng(1);
+	for(const HashBenchInput input : {hbi_random, hbi_lowComplexity, hbi_periodic}) {
+		const std::vector<uint8_t> bases = generateBases(basesNumber, input, rng);
+		const char* name = input == hbi_random ? "random" : input == hbi_lowComplexity ? "lowcomplexity" : "periodic";
+		benchK<15>(bases, name);
+		benchK<31>(bases, name);
+		benchK<63>(bases, name);
+		benchK<95>(bases, name);
+		benchK<128>(bases, name);
+	}
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * hashtable_bench.cpp
+ *
+ * measures k-mers/s of the hash table fill (keys, counters and probe of cpu::HasherTask) with a table of
+ * normal pages, transparent huge pages, 2 MB and 1 GB pages; results are written as JSON lines
+ */
+
+#include "../../include/gerbil/CpuHasher.h"
+#include "../../include/gerbil/HugePages.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gerbil;
+
+// k of the benchmark (T8/C1, 8 bytes per k-mer as for most runs)
+#define HASHTABLE_BENCH_K 31
+
+// distinct k-mers in the input stream (larger than the caches)
+#define HASHTABLE_BENCH_SET_SIZE (1 << 22)
+
+typedef KMer<HASHTABLE_BENCH_K> TKMer;
+typedef cpu::KMerBundle<HASHTABLE_BENCH_K> TKMerBundle;
+
+// keys as stored by the KMerBundles (packed with KMER_PACKED), counters of sizeof(uint_cv), 0: empty entry
+void benchMode(const THugePages &mode, const uint64 &entries, const std::vector<byte> &kMers,
+               const std::vector<uint64> &hashes, const uint64 &kMersNumber) {
+	HugePages::setMode(mode);
+	const uint64 mapped_B = HugePages::getMapped_B(hp_1g) + HugePages::getMapped_B(hp_2m)
+			+ HugePages::getMapped_B(hp_transparent);
+	const uint64 fallbacks = HugePages::getFallbacksNumber();
+	const uint64 huge_B = HugePages::getMapped_B(hp_1g) + HugePages::getMapped_B(hp_2m);
+
+	const uint64 keySize_B = TKMerBundle::kMerSize_B();
+	// (comparisons read up to 7 bytes behind a key)
+	const uint64 keys_B = entries * keySize_B + sizeof(uint64);
+	const auto startAlloc = std::chrono::steady_clock::now();
+	byte* keys = (byte*) HugePages::allocate(keys_B);
+	uint_cv* counters = (uint_cv*) HugePages::allocate(entries * sizeof(uint_cv));
+	memset(counters, 0, entries * sizeof(uint_cv));
+	const double alloc_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - startAlloc).count();
+
+	// fill as KMCHT_fill (hash of the KMerBundle, probe of cpu::HasherTask)
+	const uint64 maxSteps = cpu::getMaxProbeSteps(entries);
+	uint64 probes = 0, failures = 0;
+	uint64 hPos, steps;
+	const auto start = std::chrono::steady_clock::now();
+	for(uint64 j = 0; j < kMersNumber; ++j) {
+		const uint64 n = j & (HASHTABLE_BENCH_SET_SIZE - 1);
+		const byte* key = kMers.data() + n * keySize_B;
+		hPos = hashes[n] % entries;
+		const int found = cpu::probeKey<HASHTABLE_BENCH_K, uint_cv>(keys, counters, entries, keySize_B, maxSteps,
+				key, hPos, steps);
+		if(found > 0)
+			++counters[hPos];
+		else if(!found) {
+			counters[hPos] = 1;
+			memcpy(keys + hPos * keySize_B, key, keySize_B);
+		}
+		else
+			++failures;
+		probes += steps + 1;
+	}
+	const double fill_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("{\"mode\": \"%s\", \"table_MB\": %lu, \"key_B\": %lu, \"kmers\": %lu, \"kmers_per_s\": %.0f, "
+	       "\"probes_per_kmer\": %.3f, \"failures\": %lu, \"alloc_clear_s\": %.3f, "
+	       "\"mapped_MB\": %lu, \"hugetlb_MB\": %lu, \"fallbacks\": %lu}\n",
+	       HugePages::getName(mode), B_TO_MB(entries * (keySize_B + sizeof(uint_cv))), keySize_B, kMersNumber,
+	       kMersNumber / fill_s, (double) probes / kMersNumber, failures, alloc_s,
+	       B_TO_MB(HugePages::getMapped_B(hp_1g) + HugePages::getMapped_B(hp_2m)
+	               + HugePages::getMapped_B(hp_transparent) - mapped_B),
+	       B_TO_MB(HugePages::getMapped_B(hp_1g) + HugePages::getMapped_B(hp_2m) - huge_B),
+	       HugePages::getFallbacksNumber() - fallbacks);
+
+	HugePages::release(keys, keys_B);
+	HugePages::release(counters, entries * sizeof(uint_cv));
+}
+
+int main(int argc, char** argv) {
+	if(argc > 3) {
+		printf("hashtable_bench [<table-MB>] [<kmers>]\n");
+		return 1;
+	}
+	const uint64 table_MB = argc > 1 ? std::stoull(argv[1]) : 1024;
+	const uint64 table_B = MB_TO_B(table_MB);
+	const uint64 kMersNumber = argc > 2 ? std::stoull(argv[2]) : 1 << 26;
+	const uint64 keySize_B = TKMerBundle::kMerSize_B();
+	const uint64 entries = table_B / (keySize_B + sizeof(uint_cv));
+
+	// random normalized k-mers (2 bit per base, 4 bases per byte), stored with their hashes as by a KMerBundle
+	std::mt19937_64 rng(1);
+	std::vector<byte> bytes(HASHTABLE_BENCH_SET_SIZE + 64);
+	for(byte &b : bytes)
+		b = rng();
+	std::vector<byte> kMers(HASHTABLE_BENCH_SET_SIZE * keySize_B + sizeof(TKMer));
+	std::vector<uint64> hashes(HASHTABLE_BENCH_SET_SIZE);
+	TKMer kMer, iKMer;
+	for(uint32 i = 0; i < HASHTABLE_BENCH_SET_SIZE; ++i) {
+		TKMer::set(bytes.data() + i, kMer, iKMer);
+		const TKMer &nKMer = kMer.getNormalized(iKMer);
+		TKMerBundle::storeKMer(kMers.data() + i * keySize_B, nKMer);
+		hashes[i] = KMER_HASH_POLICY::hash(nKMer);
+	}
+
+	const THugePages modes[] = {hp_none, hp_transparent, hp_2m, hp_1g};
+	for(const THugePages &mode : modes)
+		benchMode(mode, entries, kMers, hashes, kMersNumber);
+	return 0;
+}
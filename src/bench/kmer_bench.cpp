@@ -0,0 +1,219 @@
+/*
+ * kmer_bench.cpp
+ *
+ * measures ns/op of the KMer primitives for representative k of all static specialisations
+ * (T4/C1, T8/C1, T8/C>1), each next to the runtime k (T == 0) of the same size, and of splitting a super-mer into k-mers and inverse k-mers
+ * (per base shifts or KMerExtractor); results are written as JSON lines
+ */
+
+#include "../../include/gerbil/KMer.h"
+#include "../../include/gerbil/KMerExtractor.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace gerbil;
+
+// number of k-mers / bases in the working sets (L1 resident)
+#define KMER_BENCH_SET_SIZE 1024
+
+// prevents the elimination of the measured code
+volatile uint64 __sink;
+
+// xor of all words of a k-mer
+template<unsigned K>
+inline uint64 fold(const KMer<K> &kMer) {
+	uint32 words[sizeof(KMer<K>) / sizeof(uint32)];
+	memcpy(words, &kMer, sizeof(words));
+	uint64 x = 0;
+	for(const uint32 &w : words)
+		x ^= w;
+	return x;
+}
+
+// forces the k-mer to be stored (without any further work)
+inline void escape(const void* p) {
+	asm volatile("" : : "g"(p) : "memory");
+}
+
+// returns the minimal ns/op of all repeats
+template<typename F>
+double measure(const uint64 &ops, const uint32 &repeats, F f) {
+	double best = 0;
+	for(uint32 r = 0; r < repeats; ++r) {
+		const auto start = std::chrono::steady_clock::now();
+		__sink = f(ops);
+		const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		if(!r || ns < best)
+			best = ns;
+	}
+	return best / ops;
+}
+
+void printResult(const uint32 &k, const uint32 &t, const uint32 &c, const char* op, const double &ns) {
+	printf("{\"k\": %u, \"T\": %u, \"C\": %u, \"op\": \"%s\", \"ns_per_op\": %.3f}\n", k, t, c, op, ns);
+}
+
+template<unsigned K>
+void benchKMer(const uint64 &ops, const uint32 &repeats, std::mt19937_64 &rng) {
+	typedef KMer<K> TKMer;
+	const uint32 k = KMer<K>::getK();
+	const uint32 B = GET_KMER_B(K);
+	const uint32 T = IS_KMER_DYN(K) ? 0 : GET_KMER_T(B);
+	const uint32 C = GET_KMER_C(B, GET_KMER_T(B));
+
+	// random bases (2 bit per base, 4 bases per byte), with space for the last k-mer
+	std::vector<byte> bytes(KMER_BENCH_SET_SIZE + 8 * C + 64);
+	for(byte &b : bytes)
+		b = rng();
+	std::vector<uint8_t> bases(KMER_BENCH_SET_SIZE);
+	for(uint8_t &b : bases)
+		b = rng() & 0x3;
+
+	// k-mers and their inverse
+	std::vector<TKMer> kMers(KMER_BENCH_SET_SIZE), iKMers(KMER_BENCH_SET_SIZE);
+	for(uint32 i = 0; i < KMER_BENCH_SET_SIZE; ++i)
+		TKMer::set(bytes.data() + i, kMers[i], iKMers[i]);
+	const TKMer* kp = kMers.data();
+	const TKMer* ikp = iKMers.data();
+	const byte* bp = bytes.data();
+	const uint8_t* basep = bases.data();
+
+	printResult(k, T, C, "set", measure(ops, repeats, [&](const uint64 &n) {
+		TKMer kMer, iKMer;
+		for(uint64 i = 0; i < n; ++i) {
+			TKMer::set(bp + (i & (KMER_BENCH_SET_SIZE - 1)), kMer, iKMer);
+			escape(&kMer);
+			escape(&iKMer);
+		}
+		return fold<K>(kMer) ^ fold<K>(iKMer);
+	}));
+
+	printResult(k, T, C, "next", measure(ops, repeats, [&](const uint64 &n) {
+		TKMer kMer(kp[0]);
+		for(uint64 i = 0; i < n; ++i)
+			kMer.next(basep[i & (KMER_BENCH_SET_SIZE - 1)]);
+		return fold<K>(kMer);
+	}));
+
+	printResult(k, T, C, "nextInv", measure(ops, repeats, [&](const uint64 &n) {
+		TKMer iKMer(ikp[0]);
+		for(uint64 i = 0; i < n; ++i)
+			iKMer.nextInv(basep[i & (KMER_BENCH_SET_SIZE - 1)]);
+		return fold<K>(iKMer);
+	}));
+
+	printResult(k, T, C, "getNormalized", measure(ops, repeats, [&](const uint64 &n) {
+		uint64 x = 0;
+		for(uint64 i = 0; i < n; ++i) {
+			const uint64 j = i & (KMER_BENCH_SET_SIZE - 1);
+			x += &kp[j].getNormalized(ikp[j]) == kp + j;
+		}
+		return x;
+	}));
+
+	printResult(k, T, C, "getHash", measure(ops, repeats, [&](const uint64 &n) {
+		uint64 x = 0;
+		for(uint64 i = 0; i < n; ++i)
+			x += kp[i & (KMER_BENCH_SET_SIZE - 1)].getHash();
+		return x;
+	}));
+
+	printResult(k, T, C, "getPartHash", measure(ops, repeats, [&](const uint64 &n) {
+		uint64 x = 0;
+		for(uint64 i = 0; i < n; ++i)
+			x += kp[i & (KMER_BENCH_SET_SIZE - 1)].getPartHash();
+		return x;
+	}));
+
+	printResult(k, T, C, "isEqual", measure(ops, repeats, [&](const uint64 &n) {
+		uint64 x = 0;
+		for(uint64 i = 0; i < n; ++i)
+			x += kp[i & (KMER_BENCH_SET_SIZE - 1)].isEqual(kp[(i + 1) & (KMER_BENCH_SET_SIZE - 1)]);
+		return x;
+	}));
+
+	std::vector<byte> outBytes(8 * C);
+	byte* out = outBytes.data();
+	printResult(k, T, C, "toByte", measure(ops, repeats, [&](const uint64 &n) {
+		uint64 x = 0;
+		for(uint64 i = 0; i < n; ++i) {
+			kp[i & (KMER_BENCH_SET_SIZE - 1)].toByte(out);
+			x += out[0];
+		}
+		return x;
+	}));
+
+	// one super-mer of all bytes, normalized k-mers (as in the splitter)
+	const uint16 l = 4 * KMER_BENCH_SET_SIZE;
+	printResult(k, T, C, "splitNext", measure(ops, repeats, [&](const uint64 &n) {
+		TKMer kMer, iKMer, nKMer;
+		for(uint64 i = 0; i < n;) {
+			TKMer::set(bp, kMer, iKMer);
+			nKMer.set(kMer.getNormalized(iKMer));
+			escape(&nKMer);
+			++i;
+			for(uint32 j = k; j < l && i < n; ++j, ++i) {
+				const uint8_t base = (bp[j >> 2] >> (6 - ((j & 0x3) << 1))) & 0x3;
+				kMer.next(base);
+				iKMer.nextInv(base);
+				nKMer.set(kMer.getNormalized(iKMer));
+				escape(&nKMer);
+			}
+		}
+		return fold<K>(nKMer);
+	}));
+
+	if(KMerExtractor<K>::isWordParallel()) {
+		KMerExtractor<K> extractor;
+		printResult(k, T, C, "splitExtract", measure(ops, repeats, [&](const uint64 &n) {
+			TKMer nKMer;
+			for(uint64 i = 0; i < n;) {
+				extractor.load(bp, l);
+				for(uint32 p = 0; p + k <= l && i < n; ++p, ++i) {
+					extractor.getNormalized(p, nKMer);
+					escape(&nKMer);
+				}
+			}
+			return fold<K>(nKMer);
+		}));
+	}
+}
+
+// runtime k, as instantiated by the KmerHasher
+template<unsigned C>
+void benchKMerDyn(const uint32 &k, const uint64 &ops, const uint32 &repeats, std::mt19937_64 &rng) {
+	KMer<KMER_DYN(C)>::setK(k);
+	benchKMer<KMER_DYN(C)>(ops, repeats, rng);
+}
+
+int main(int argc, char** argv) {
+	if(argc > 3) {
+		printf("kmer_bench [<ops>] [<repeats>]\n");
+		return 1;
+	}
+	const uint64 ops = argc > 1 ? std::stoull(argv[1]) : 1 << 24;
+	const uint32 repeats = argc > 2 ? std::stoul(argv[2]) : 5;
+
+	std::mt19937_64 rng(1);
+
+	// static specialisation and runtime k of the same size
+#define BENCH_K(k) benchKMer<k>(ops, repeats, rng); benchKMerDyn<GET_KMER_DYN_C(k)>(k, ops, repeats, rng)
+	BENCH_K(15);
+	BENCH_K(28);
+	BENCH_K(31);
+	BENCH_K(32);
+	BENCH_K(55);
+	BENCH_K(64);
+	BENCH_K(100);
+	BENCH_K(128);
+#undef BENCH_K
+
+	// runtime k only
+	benchKMerDyn<8>(255, ops, repeats, rng);
+	benchKMerDyn<16>(500, ops, repeats, rng);
+	return 0;
+}
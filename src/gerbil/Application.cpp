@@ -86,9 +86,14 @@ gerbil::Application::Application(
 		_superSplitterThreadsNumber(0), _hasherThreadsNumber(0), _thresholdMin(thresholdMin), _memSize(0),
 		_threadsNumber(0), _norm(DEF_NORM),
 		_fastFileName(fastFileName), _tempFolderName(tempFolderName), _kmcFileName(kmcFileName), _tempFiles(NULL),
-		_rtRun1(0.0), _rtRun2(0.0), _memoryUsage1(0), _memoryUsage2(0),
+		_rtRun1(0.0), _rtRun2(0.0), _memoryUsage1(0), _memoryUsage2(0), _memoryUsageOverlap(0),
 		_readerParserThreadsNumber(1), _numGPUs(0),
-		_singleStep(0), _leaveBinStat(false), _histogram(0), _outputFormat(of_fasta), _skipEstimate(skipEstimate)
+		_singleStep(0), _leaveBinStat(false), _histogram(0), _outputFormat(of_fasta), _skipEstimate(skipEstimate),
+		listKmer(NULL), _kmcConsumer(NULL), _readSource(NULL), _inMemoryBins(true),
+		_overlapSteps(true), _timelineInterval_ms(QUEUE_MONITOR_INTERVAL_MS),
+		_perfCounters(false), _progressInterval_ms(PROGRESS_INTERVAL_MS),
+		_autoTune(false), _numa(true), _hugePages(hp_none), _quotientKeys(false),
+		_counterSize_B(sizeof(uint_cv)), _prefilter(false)
 {
 
 }
@@ -121,18 +126,50 @@ void gerbil::Application::process() {
 	
 	checkParams();	
 
+	initTelemetry();
+
+	// actual memory of the large buffers, optional allocations respect the budget
+	MemoryTracker::reset(MB_TO_B(_memSize));
+
+	if(_autoTune && verbose)
+		_autoTuner.print();
+
 	ReadBundle::setK(_k);
+
+	if(!_timelineFileName.empty() && !QueueMonitor::start(_timelineFileName, _timelineInterval_ms))
+		std::cerr << "unable to write queue timeline '" << _timelineFileName << "'" << std::endl;
+
+	NumaTopology::detect();
+	NumaTopology::setEnabled(_numa);
+	HugePages::setMode(_hugePages);
+
+	PerfCounters::setEnabled(_perfCounters);
+	if(_perfCounters && !PerfCounters::isSupported())
+		std::cerr << "hardware counters are not available (perf_event_open)" << std::endl;
+
+	if(!_progressFileName.empty() && !_progressReporter.start(_progressFileName, _progressInterval_ms))
+		std::cerr << "unable to write progress '" << _progressFileName << "'" << std::endl;
 	
 	if (_singleStep != 2)
 		run1();
 	else
 		loadBinStat();
 
-	if (_singleStep != 1)
+	// run2 is started by run1 if both steps overlap
+	if (_singleStep != 1 && !(_overlapSteps && !_singleStep))
 		run2();
 
 	if(_singleStep != 1 && !_leaveBinStat)
 		std::remove((_tempFolderName + "binStatFile.txt").c_str());
+
+	_progressReporter.stop();
+	QueueMonitor::stop();
+
+	if(_autoTune)
+		_autoTuner.report(_telemetry.getStage("autotune"));
+
+	if(!_reportFileName.empty() && !_telemetry.saveJson(_reportFileName))
+		std::cerr << "unable to write report '" << _reportFileName << "'" << std::endl;
 }
 /**
  * @brief factorial
@@ -219,6 +256,7 @@ void gerbil::Application::run1() {
 	// time
 	StopWatch sw(CLOCK_REALTIME);
 	sw.start();
+	MemoryTracker::resetPeaks();
 	std::cout<<"memory calculation"<<"\n";
 	// calculate memory
 	uint32 frBlocksNumber, readBundlesNumber, superBundlesNumber;
@@ -229,73 +267,202 @@ void gerbil::Application::run1() {
 
 	std::cout<<"start running first phase"<<"\n";
 	// init pipeline
-	FastReader fastReader(frBlocksNumber, _fastFileName,
-			_readerParserThreadsNumber);
-	FastParser fastParser(readBundlesNumber, fastReader.getFileType(), st_reads,
-			fastReader.getSyncSwapQueues(), _readerParserThreadsNumber, _skipEstimate);
+	FastReader* fastReader = NULL;
+	FastParser* fastParser = NULL;
+	MemoryReader* memoryReader = NULL;
+	SyncSwapQueueMPMC<ReadBundle>* readBundleQueue;
+	if(_readSource) {
+		memoryReader = new MemoryReader(readBundlesNumber, _readSource, _skipEstimate);
+		readBundleQueue = memoryReader->getSyncQueue();
+	}
+	else {
+		fastReader = new FastReader(frBlocksNumber, _fastFileName,
+				_readerParserThreadsNumber);
+		fastParser = new FastParser(readBundlesNumber, fastReader->getFileType(), st_reads,
+				fastReader->getSyncSwapQueues(), _readerParserThreadsNumber, _skipEstimate);
+		readBundleQueue = fastParser->getSyncQueue();
+	}
+	// progress: read bytes of all files or bases of the read source
+	if(memoryReader)
+		_progressReporter.setStep("1", "bases", [memoryReader](uint64 &done, uint64 &total) {
+			done = memoryReader->getBasesNumber();
+			total = memoryReader->getBasesNumberHint();
+		});
+	else
+		_progressReporter.setStep("1", "B", [fastReader](uint64 &done, uint64 &total) {
+			done = fastReader->getProgressBytes();
+			total = fastReader->getTotalBytes();
+		});
+
 	SequenceSplitter sequenceSplitter(superBundlesNumber,
-			fastParser.getSyncQueue(), _sequenceSplitterThreadsNumber, _k, _m,
+			readBundleQueue, _sequenceSplitterThreadsNumber, _k, _m,
 			_tempFilesNumber, _norm);
+
+	// keep bins in memory if the estimated size of all super-mers fits
+	// (single bins are moved to disk if the limit is exceeded anyway)
+	bool binsInMemory = false;
+	if (_inMemoryBins && !_singleStep) {
+		uint64 basesNumber = memoryReader ? _readSource->getBasesNumberHint() : fastReader->getApprBasesNumber();
+		// in-memory bins replace the buffer of the SuperWriter
+		uint64 usedMemory_B = _memoryUsage1 - superWriterBufferSize
+				* (SUPER_BUNDLE_DATA_SIZE_B + sizeof(SuperBundleStackItem));
+		uint64 binsMemory = MB_TO_B(_memSize) * IN_MEMORY_BINS_MAX_RATIO;
+		if (usedMemory_B + binsMemory > MB_TO_B(_memSize))
+			binsMemory = usedMemory_B < MB_TO_B(_memSize) ? MB_TO_B(_memSize) - usedMemory_B : 0;
+		// about 8 k-mers per super-mer: (k - 1 + 8) bases for 8 k-mers, 4 bases per byte
+		uint64 apprBinsSize = basesNumber * (_k + 7) / 32;
+		binsInMemory = apprBinsSize <= binsMemory;
+		if (binsInMemory) {
+			TempFile::setMemoryLimit(binsMemory);
+			_memoryUsage1 = usedMemory_B + binsMemory;
+		}
+	}
+	// step2 starts as soon as the SequenceSplitter is done
+	const bool overlapSteps = _overlapSteps && !_singleStep;
 	SuperWriter superWriter(_tempFolderName,
 			sequenceSplitter.getSuperBundleQueues(), _tempFilesNumber,
-			superWriterBufferSize);
+			superWriterBufferSize, binsInMemory, overlapSteps);
 
 	// start pipepline
-	fastReader.process();
-	fastParser.process();
+	if(memoryReader)
+		memoryReader->process();
+	else {
+		fastReader->process();
+		fastParser->process();
+	}
 	sequenceSplitter.process();
 	superWriter.process();
 
 	// join all
-	fastReader.join();
-	//fastParser.join();
-	//joins all the threads, retrive the value and then delete the threads
-	fastParser.joinWithoutDelete();
+	double estimatedErate;
+	if(memoryReader) {
+		memoryReader->join();
+		estimatedErate = memoryReader->getErate();
+	}
+	else {
+		fastReader->join();
+		//fastParser.join();
+		//joins all the threads, retrive the value and then delete the threads
+		fastParser->joinWithoutDelete();
+		estimatedErate = fastParser->getErate();
+		fastParser->deleteProcessThread();
+	}
 	if(_skipEstimate&&(_suggested_erate!=NULL)){
 		erate = _suggested_erate;
 	}else if(_skipEstimate) {
 		erate = 0.15;
 	}else{
-	erate = fastParser.getErate();
+	erate = estimatedErate;
 	}
-	fastParser.deleteProcessThread();
 	//calculates upperbound and lowerbound of the reliable kmers
 	_upperBound = computeUpper_inG(_cov, erate,_k,_minProbability);
 	_lowerBound = computeLower_inG(_cov, erate,_k,_minProbability);
 	//std::cout<<erate<<'\n';
 	sequenceSplitter.join();
-	superWriter.join();
 	//printf("errorRate :                     %f\n",erate);
 	std::cout << "Error rate estimate is " << erate << std::endl;
 	printf("kmerFrequencyLowerBound:        %d\n",_lowerBound);
 	printf("kmerFrequencyUpperBound:        %d\n",_upperBound);
-	// save bin statistic
 	_tempFiles = superWriter.getTempFiles();
+
+	TelemetryStage &stage = _telemetry.getStage("stage1");
+	if(memoryReader)
+		memoryReader->report(stage);
+	else {
+		fastReader->report(stage);
+		fastParser->report(stage);
+	}
+	sequenceSplitter.report(stage);
+	stage.add("memoryUsage", _memoryUsage1);
+	MemoryTracker::report(stage, _memoryUsage1);
+
+	if (overlapSteps) {
+		// the statistic of all bins is final, each bin is passed to step2 after its last SuperBundle is written
+		uint64 binSuperBundles, binSMers, binKMers;
+		for (uint_tfn tempFileId(0); tempFileId < _tempFilesNumber; ++tempFileId) {
+			sequenceSplitter.getBinStat(tempFileId, binSuperBundles, binSMers, binKMers);
+			_tempFiles[tempFileId].announce(binSuperBundles, binSMers, binKMers);
+		}
+
+		sw.stop();
+		_rtRun1 = sw.get_s();
+		stage.set("realtime_s", _rtRun1);
+		stage.set("bases_per_s", _rtRun1 ? stage.getCounter("splitter.bases") / _rtRun1 : 0);
+
+		// verbose output (without SuperWriter)
+		if (verbose) {
+			printf("================== STAGE 1 ==================\n");
+			if(memoryReader)
+				memoryReader->print();
+			else {
+				fastReader->print();
+				fastParser->print();
+			}
+			sequenceSplitter.print();
+			printf("memory usage           : %12lu MB\n", B_TO_MB(_memoryUsage1));
+			MemoryTracker::print(_memoryUsage1);
+			printf("---------------------------------------------\n");
+		}
+
+		_progressReporter.finishStep();
+		delete memoryReader;
+		delete fastParser;
+		delete fastReader;
+
+		// the SuperBundle queues are in use until the SuperWriter is done,
+		// in-memory bins may grow by the SuperBundles which are still queued
+		_memoryUsageOverlap = (uint64) superBundlesNumber * SUPER_BUNDLE_DATA_SIZE_B * (binsInMemory ? 2 : 1);
+		run2(&superWriter);
+		_memoryUsageOverlap = 0;
+		return;
+	}
+
+	superWriter.join();
+	superWriter.report(stage);
+	// save bin statistic
 	saveBinStat();
 
 	sw.stop();
 	_rtRun1 = sw.get_s();
+	stage.set("realtime_s", _rtRun1);
+	stage.set("bases_per_s", _rtRun1 ? stage.getCounter("splitter.bases") / _rtRun1 : 0);
 	//return error rate for bella
 
 	// verbose output
 	if (verbose) {
 		printf("================== STAGE 1 ==================\n");
-		fastReader.print();
-		fastParser.print();
+		if(memoryReader)
+			memoryReader->print();
+		else {
+			fastReader->print();
+			fastParser->print();
+		}
 		sequenceSplitter.print();
 		superWriter.print();
 		printf("memory usage           : %12lu MB\n", B_TO_MB(_memoryUsage1));
+		MemoryTracker::print(_memoryUsage1);
 		printf("---------------------------------------------\n");
 	}
+
+	_progressReporter.finishStep();
+	delete memoryReader;
+	delete fastParser;
+	delete fastReader;
 }
 
 void gerbil::Application::run2() {
+	run2(NULL);
+}
+
+void gerbil::Application::run2(SuperWriter* superWriter) {
 	// no buffer for output stream
 	setbuf(stdout, NULL);
 
 	// time
 	StopWatch sw(CLOCK_REALTIME);
 	sw.start();
+	MemoryTracker::resetPeaks();
+	NumaTopology::resetTransfers();
 
 	// calculate statistic for tempFiles
 	TempFileStatistic tempFileStatistic(_tempFiles, _tempFilesNumber);
@@ -305,10 +472,10 @@ void gerbil::Application::run2() {
 	uint8_t hasherThreadsCPU = std::max(0,_hasherThreadsNumber-hasherThreadsGPU);
 
 	// calculate memory
-	uint32 superBundlesNumber, kmcBundlesNumber, kMerBundlesNumber;
+	uint32 superBundlesNumber, kmcBundlesNumber, kMerBundlesNumber, prefilterBundlesNumber;
 	uint64 maxKmcHashtableSize;
 	distributeMemory2(&tempFileStatistic, superBundlesNumber, kmcBundlesNumber,
-			maxKmcHashtableSize, kMerBundlesNumber);
+			maxKmcHashtableSize, kMerBundlesNumber, prefilterBundlesNumber);
 
 	// init distributor
 	KmerDistributer distributor(hasherThreadsCPU, hasherThreadsGPU, _tempFilesNumber);
@@ -319,8 +486,18 @@ void gerbil::Application::run2() {
 			_superSplitterThreadsNumber, hasherThreadsCPU, hasherThreadsGPU,
 			_tempFiles, _tempFilesNumber, _thresholdMin, _norm, _tempFolderName,
 			maxKmcHashtableSize, kMerBundlesNumber,
-			superReader.getTempFilesOrder(), &distributor);
-	KmcWriter kmcWriter(_upperBound,_lowerBound,_kmcFileName, kmerHasher.getKmcSyncSwapQueue(), _k, _outputFormat);
+			superReader.getTempFilesOrder(), &distributor, _quotientKeys, _counterSize_B, _prefilter,
+			prefilterBundlesNumber);
+	KmcWriter kmcWriter(_upperBound,_lowerBound,_kmcFileName, kmerHasher.getKmcSyncSwapQueue(), _k, _outputFormat,
+			_kmcConsumer);
+
+	// progress: k-mers of all bins which are completely split (weighted by runs)
+	_progressReporter.setStep("2", "k-mers", [this, &kmerHasher](uint64 &done, uint64 &total) {
+		done = kmerHasher.getSplitKMersNumber();
+		total = 0;
+		for (uint_tfn tempFileId(0); tempFileId < _tempFilesNumber; ++tempFileId)
+			total += _tempFiles[tempFileId].getKMersNumber();
+	});
 
 	// start pipeline
 	superReader.process();
@@ -329,7 +506,12 @@ void gerbil::Application::run2() {
 
 	// join all
 	superReader.join();
+	if (superWriter) {
+		superWriter->join();
+		superWriter->report(_telemetry.getStage("stage1"));
+	}
 	kmerHasher.join();
+	_progressReporter.finishStep();
 	//kmcWriter.join();
 
 	//join, retrive the value and then delete the process
@@ -341,6 +523,17 @@ void gerbil::Application::run2() {
 	sw.stop();
 	_rtRun2 = sw.get_s();
 
+	TelemetryStage &stage = _telemetry.getStage("stage2");
+	superReader.report(stage);
+	kmerHasher.report(stage);
+	kmcWriter.report(stage);
+	stage.add("memoryUsage", _memoryUsage2);
+	MemoryTracker::report(stage, _memoryUsage2);
+	NumaTopology::report(stage);
+	HugePages::report(stage);
+	stage.set("realtime_s", _rtRun2);
+	stage.set("kMers_per_s", _rtRun2 ? stage.getCounter("hasher.kMers") / _rtRun2 : 0);
+
 	// save bin statistic
 	saveBinStat();
 
@@ -349,10 +542,18 @@ void gerbil::Application::run2() {
 		
 	// verbose output
 	if (verbose) {
+		if (superWriter) {
+			printf("================ SUPERWRITER ================\n");
+			superWriter->print();
+			printf("---------------------------------------------\n");
+		}
 		printf("================== STAGE 2 ==================\n");
 		kmerHasher.print();
 		kmcWriter.print();
+		NumaTopology::print();
+		HugePages::print();
 		printf("memory usage    : %12lu MB\n", B_TO_MB(_memoryUsage2));
+		MemoryTracker::print(_memoryUsage2);
 		printf("---------------------------------------------\n");
 		printSummary();
 	}
@@ -399,9 +600,22 @@ void gerbil::Application::distributeMemory1(uint32 &fastBundlesNumber,
 	}
 
 	// compute memory for buffers
+	uint64 maxFastBundleBuffer_B = MAX_FASTBUNDLEBUFFER_SIZE_B;
+	uint64 maxReadBundleBuffer_B = MAX_READBUNDLEBUFFER_SIZE_B;
+	double buffersRatio = 0.5;	// assure 50% memory for SuperWriterBuffer
+	const bool tuned = _autoTune && _autoTuner.isCalibrated();
+	if (tuned) {
+		// buffer the calibrated throughput of the consumers (parsers, splitters),
+		// the SuperWriter gets all the rest
+		maxFastBundleBuffer_B = std::min(maxFastBundleBuffer_B,
+				_autoTuner.getQueueSize_B(_autoTuner.getParseBytesRate() * _readerParserThreadsNumber));
+		maxReadBundleBuffer_B = std::min(maxReadBundleBuffer_B,
+				_autoTuner.getQueueSize_B(_autoTuner.getScanRate() * _sequenceSplitterThreadsNumber));
+		buffersRatio = 1.0;
+	}
 
 	// memory for FastBundles
-	uint64 optFastBundlesNumber = MAX_FASTBUNDLEBUFFER_SIZE_B
+	uint64 optFastBundlesNumber = maxFastBundleBuffer_B
 			/ FAST_BUNDLE_DATA_SIZE_B;
 	uint64 memOptFastBundles = 0;
 	if (optFastBundlesNumber > fastBundlesNumber) {
@@ -411,7 +625,7 @@ void gerbil::Application::distributeMemory1(uint32 &fastBundlesNumber,
 		optFastBundlesNumber = 0;
 
 	// memory for ReadBundles
-	uint64 optReadBundlesNumber = MAX_READBUNDLEBUFFER_SIZE_B
+	uint64 optReadBundlesNumber = maxReadBundleBuffer_B
 			/ READ_BUNDLE_SIZE_B;
 	uint64 memOptReadBundles = 0;
 	if (optReadBundlesNumber > readBundlesNumber) {
@@ -430,7 +644,7 @@ void gerbil::Application::distributeMemory1(uint32 &fastBundlesNumber,
 	} else
 		optSuperBundlesNumber = 0;
 
-	uint64 availableMemory_B = (MB_TO_B(_memSize) - _memoryUsage1) * 0.5; // assure 50% memory for SuperWriterBuffer
+	uint64 availableMemory_B = (MB_TO_B(_memSize) - _memoryUsage1) * buffersRatio;
 
 	// assure memory
 	uint64 sumOptMem = memOptFastBundles + memOptReadBundles
@@ -462,17 +676,39 @@ void gerbil::Application::distributeMemory1(uint32 &fastBundlesNumber,
 
 	_memoryUsage1 += superWriterBufferSize
 			* (SUPER_BUNDLE_DATA_SIZE_B + sizeof(SuperBundleStackItem));
+
+	if (tuned) {
+		_autoTuner.decide("fastBundles", fastBundlesNumber, "parse rate");
+		_autoTuner.decide("readBundles", readBundlesNumber, "scan rate of all splitters");
+		_autoTuner.decide("superWriterBuffer", superWriterBufferSize, "rest of memory");
+	}
 }
 
 void gerbil::Application::distributeMemory2(
 		TempFileStatistic* tempFileStatistic, uint32 &superBundlesNumber,
 		uint32 &kmcBundlesNumber, uint64 &maxKmcHashtableSize,
-		uint32 &kMerBundlesNumber) {
-	uint64 bytesPerHashEntry = getKMerByteNumbers(_k) + sizeof(uint_cv);
+		uint32 &kMerBundlesNumber, uint32 &prefilterBundlesNumber) {
+	// the bloom filter of the prefilter has BLOOM_FILTER_BITS per hash table entry
+	const bool prefilter = _prefilter && _thresholdMin > 1 && !HYBRID_COUNTER;
+	const uint32 valueSize_B = _counterSize_B + (prefilter ? BLOOM_FILTER_BITS / 8 : 0);
+	uint64 bytesPerHashEntry = getKMerStoredByteNumbers(_k) + valueSize_B;
+
+	// quotient keys shrink with the tables (per cpu hasher), first sized for the minimal tables
+	const bool quotientKeys = _quotientKeys && KMER_PACKED;
+	const uint32 cpuHashers = std::max(1, _hasherThreadsNumber - std::min(_numGPUs, _hasherThreadsNumber));
+	if (quotientKeys)
+		bytesPerHashEntry = getKMerQuotientByteNumbers(_k, MIN_KMCHASHTABLE_SIZE_B / bytesPerHashEntry / cpuHashers)
+				+ valueSize_B;
 
 	// some space for general consumption
 	uint64 base_memory_B = RUN2_MEMORY_GENERAL_B;
 
+	// bins which are still in memory
+	base_memory_B += TempFile::getMemoryUsage();
+
+	// step1 is still running
+	base_memory_B += _memoryUsageOverlap;
+
 	// const memory consumption
 	base_memory_B += _numGPUs * GPU_COPY_BUFFER_SIZE;
 
@@ -483,6 +719,10 @@ void gerbil::Application::distributeMemory2(
 			* (1 + FAILUREBUFFER_KMER_BUNDLES_NUMBER_PER_THREAD)
 			* KMER_BUNDLE_DATA_SIZE_B;
 	base_memory_B += (_hasherThreadsNumber + _numGPUs) * KMC_BUNDLE_DATA_SIZE_B;
+	base_memory_B += _hasherThreadsNumber * FAILURETABLE_MIN_SIZE * (getKMerStoredByteNumbers(_k) + sizeof(uint_cv));
+	prefilterBundlesNumber = PREFILTER_KMER_BUNDLES_NUMBER_PER_THREAD;
+	if (prefilter)
+		base_memory_B += _hasherThreadsNumber * PREFILTER_KMER_BUNDLES_NUMBER_PER_THREAD * KMER_BUNDLE_DATA_SIZE_B;
 
 	_memoryUsage2 = base_memory_B;
 	uint64 availableMemory_B = MB_TO_B(_memSize) - _memoryUsage2;
@@ -502,23 +742,8 @@ void gerbil::Application::distributeMemory2(
 	availableMemory_B = MB_TO_B(_memSize) - _memoryUsage2;
 	//printf("%u\t\t%u\t\t%u\t\t%lu\n", superBundlesNumber, kMerBundlesNumber, kmcBundlesNumber, maxKmcHashtableSize);
 
-	// compute memory for hashtable
-	uint64 maxUKMersNumber = std::min(tempFileStatistic->getMaxKMersNumber(),
-			tempFileStatistic->getAvg2SdKMersNumber());
-	if (maxUKMersNumber > maxKmcHashtableSize) {
-		maxUKMersNumber -= maxKmcHashtableSize; // already assured
-		uint64 extraSize;
-		if (maxUKMersNumber
-				* bytesPerHashEntry<= availableMemory_B * MEM_KEY_HT)
-			extraSize = maxUKMersNumber;
-		else
-			extraSize = availableMemory_B * MEM_KEY_HT / bytesPerHashEntry;
-		maxKmcHashtableSize += extraSize;
-		_memoryUsage2 += extraSize * bytesPerHashEntry;
-		availableMemory_B = MB_TO_B(_memSize) - _memoryUsage2;
-	}
-
 	// compute memory for buffers
+	const bool tuned = _autoTune && _autoTuner.isCalibrated();
 	uint64 optSuperBundlesNumber =
 			tempFileStatistic->getAvg2SdSize() / SUPER_BUNDLE_DATA_SIZE_B;
 	uint64 memOptSuperBundles = 0;
@@ -529,7 +754,13 @@ void gerbil::Application::distributeMemory2(
 		optSuperBundlesNumber = 0;
 
 	uint64 optKMerBundlesNumber = tempFileStatistic->getAvg2SdKMersNumber()
-			* getKMerByteNumbers(_k) / KMER_BUNDLE_DATA_SIZE_B;
+			* getKMerStoredByteNumbers(_k) / KMER_BUNDLE_DATA_SIZE_B;
+	if (tuned) {
+		// buffer the calibrated throughput of the hashers instead of a whole bin
+		const uint32 cpuHashers = std::max(1, _hasherThreadsNumber - _numGPUs);
+		optKMerBundlesNumber = std::min(optKMerBundlesNumber, _autoTuner.getQueueSize_B(
+				_autoTuner.getHashRate() * cpuHashers * getKMerStoredByteNumbers(_k)) / KMER_BUNDLE_DATA_SIZE_B);
+	}
 	//printf("optkmer: %lu\n", optKMerBundlesNumber * KMER_BUNDLE_DATA_SIZE_B);
 	uint64 memOptKMerBundles = 0;
 	if (optKMerBundlesNumber > kMerBundlesNumber) {
@@ -549,6 +780,48 @@ void gerbil::Application::distributeMemory2(
 	} else
 		optKmcBundlesNumber = 0;
 
+	// compute memory for hashtable
+	// (tuned: the buffers are bounded by the calibrated throughput, the hash table gets all the rest)
+	const uint64 optBuffersMemory_B = memOptSuperBundles + memOptKMerBundles + memOptKmcBundles;
+	uint64 hashtableMemory_B = availableMemory_B * MEM_KEY_HT;
+	if (tuned)
+		hashtableMemory_B = availableMemory_B > optBuffersMemory_B ? availableMemory_B - optBuffersMemory_B : 0;
+	uint64 maxUKMersNumber = std::min(tempFileStatistic->getMaxKMersNumber(),
+			tempFileStatistic->getAvg2SdKMersNumber());
+
+	// prefilter: the tables hold only the k-mers seen twice, the first occurrences (candidates, with their hashes)
+	// are buffered instead, the memory of the tables is shared in proportion of the entry sizes
+	if (prefilter) {
+		const uint64 candidateSize_B = getKMerStoredByteNumbers(_k) + sizeof(uint64);
+		const uint64 candidatesMemory_B = std::min(maxUKMersNumber * candidateSize_B,
+				hashtableMemory_B / (candidateSize_B + bytesPerHashEntry) * candidateSize_B);
+		const uint32 extraBundlesNumber = candidatesMemory_B / cpuHashers / KMER_BUNDLE_DATA_SIZE_B;
+		prefilterBundlesNumber += extraBundlesNumber;
+		base_memory_B += (uint64) cpuHashers * extraBundlesNumber * KMER_BUNDLE_DATA_SIZE_B;
+		_memoryUsage2 += (uint64) cpuHashers * extraBundlesNumber * KMER_BUNDLE_DATA_SIZE_B;
+		hashtableMemory_B -= (uint64) cpuHashers * extraBundlesNumber * KMER_BUNDLE_DATA_SIZE_B;
+		availableMemory_B = MB_TO_B(_memSize) - _memoryUsage2;
+	}
+	if (maxUKMersNumber > maxKmcHashtableSize) {
+		maxUKMersNumber -= maxKmcHashtableSize; // already assured
+		uint64 extraSize;
+		if (maxUKMersNumber
+				* bytesPerHashEntry<= hashtableMemory_B)
+			extraSize = maxUKMersNumber;
+		else
+			extraSize = hashtableMemory_B / bytesPerHashEntry;
+		maxKmcHashtableSize += extraSize;
+		_memoryUsage2 += extraSize * bytesPerHashEntry;
+		availableMemory_B = MB_TO_B(_memSize) - _memoryUsage2;
+	}
+
+	// the keys of the final tables are shorter, the same memory holds more entries
+	if (quotientKeys) {
+		const uint64 hashtableSize_B = maxKmcHashtableSize * bytesPerHashEntry;
+		bytesPerHashEntry = getKMerQuotientByteNumbers(_k, maxKmcHashtableSize / cpuHashers) + valueSize_B;
+		maxKmcHashtableSize = hashtableSize_B / bytesPerHashEntry;
+	}
+
 	// assure memory
 	uint64 sumOptMem = memOptSuperBundles + memOptKMerBundles
 			+ memOptKmcBundles;
@@ -574,6 +847,12 @@ void gerbil::Application::distributeMemory2(
 	_memoryUsage2 += kmcBundlesNumber * KMC_BUNDLE_DATA_SIZE_B;
 	_memoryUsage2 += maxKmcHashtableSize * bytesPerHashEntry;
 	availableMemory_B = MB_TO_B(_memSize) - _memoryUsage2;
+	if (tuned) {
+		_autoTuner.decide("kMerBundles", kMerBundlesNumber, "hash rate of all hashers");
+		_autoTuner.decide("hashtableEntries", maxKmcHashtableSize, "rest of memory");
+		if (prefilter)
+			_autoTuner.decide("prefilterBundles", prefilterBundlesNumber, "first occurrences of the largest bin");
+	}
 	//printf("%u\t\t%u\t\t%u\t\t%lu\n", superBundlesNumber, kMerBundlesNumber, kmcBundlesNumber, maxKmcHashtableSize);
 	/*printf("%lu MB\t\t%lu MB\t\t%lu MB\t\t%lu MB\n",
 	 B_TO_MB(superBundlesNumber * SUPER_BUNDLE_DATA_SIZE_B),
@@ -635,6 +914,11 @@ void gerbil::Application::checkSystem() {
 void gerbil::Application::autocompleteParams() {
 #define SET_DEFAULT(x, d) if(!x) x = d
 
+	// thread numbers which are not set by the user (auto tuner)
+	const bool autoSequenceSplitters = !_sequenceSplitterThreadsNumber;
+	const bool autoSuperSplitters = !_superSplitterThreadsNumber;
+	const bool autoHashers = !_hasherThreadsNumber;
+
 	// set to default values
 	SET_DEFAULT(_k, DEF_KMER_SIZE);
 	SET_DEFAULT(_threadsNumber,
@@ -693,6 +977,16 @@ void gerbil::Application::autocompleteParams() {
 			_m = MIN_MINIMIZER_SIZE;
 
 	}
+
+	// replace the default thread split by the calibrated one (invalid parameters are reported by checkParams)
+	if (_autoTune) {
+		if (_k >= MIN_KMER_SIZE && _k <= MAX_KMER_SIZE && _m <= _k && _m <= MAX_MINIMIZER_SIZE
+				&& _tempFilesNumber <= MAX_TEMPFILES_NUMBER && (((uint64) 4) << (2 * _m)) >= _tempFilesNumber)
+			_autoTuner.calibrate(_k, _m, _tempFilesNumber, _norm, _skipEstimate, _thresholdMin, _quotientKeys,
+					_counterSize_B, _prefilter, _tempFolderName);
+		_autoTuner.tuneThreads(_numGPUs, !_readSource, autoSequenceSplitters, autoSuperSplitters,
+				autoHashers, _sequenceSplitterThreadsNumber, _superSplitterThreadsNumber, _hasherThreadsNumber);
+	}
 }
 
 void gerbil::Application::checkParams() {
@@ -707,7 +1001,7 @@ void gerbil::Application::checkParams() {
 		}
 
 	// check file paths
-	if (_fastFileName.empty() && _singleStep != 2) {
+	if (_fastFileName.empty() && !_readSource && _singleStep != 2) {
 		printf("input file is unknown\n");
 		exit(1);
 	}
@@ -746,6 +1040,10 @@ void gerbil::Application::checkParams() {
 				<< "number n of temp files is too large, size of minimizers m is too small (should be: n <= 4^m)\n";
 		exit(1);
 	}
+	if (_counterSize_B != 1 && _counterSize_B != 2 && _counterSize_B != sizeof(uint_cv)) {
+		std::cerr << "size of counters (" << _counterSize_B << ") is invalid (should be: 1, 2 or " << sizeof(uint_cv) << ")\n";
+		exit(1);
+	}
 }
 
 void gerbil::Application::printParamsInfo() {
@@ -761,7 +1059,7 @@ void gerbil::Application::printParamsInfo() {
 	printf("total number of threads : %5u\n", _threadsNumber);
 	printf("number of splitters     : %5u\n", _sequenceSplitterThreadsNumber);
 	printf("number of hashers       : %5u\n", _hasherThreadsNumber);
-	printf("input                   :       %s\n", _fastFileName.c_str());
+	printf("input                   :       %s\n", _readSource ? "<memory>" : _fastFileName.c_str());
 	printf("temp                    :       %s\n", _tempFolderName.c_str());
 	printf("output                  :       %s\n", _kmcFileName.c_str());
 	printf("size of memory          : %5lu MB\n", _memSize);
@@ -779,6 +1077,23 @@ void gerbil::Application::printSummary() {
 	printf("---------------------------------------------------\n");
 }
 
+void gerbil::Application::initTelemetry() {
+	_telemetry.clear();
+	_telemetry.setParam("version", std::to_string(VERSION_MAJOR) + "." + std::to_string(VERSION_MINOR));
+	_telemetry.setParam("k", _k);
+	_telemetry.setParam("m", _m);
+	_telemetry.setParam("thresholdMin", _thresholdMin);
+	_telemetry.setParam("tempFiles", _tempFilesNumber);
+	_telemetry.setParam("threads", _threadsNumber);
+	_telemetry.setParam("splitters", _sequenceSplitterThreadsNumber);
+	_telemetry.setParam("hashers", _hasherThreadsNumber);
+	_telemetry.setParam("memory_MB", _memSize);
+	_telemetry.setParam("gpus", _numGPUs);
+	_telemetry.setParam("input", _readSource ? "<memory>" : _fastFileName);
+	_telemetry.setParam("singleStep", _singleStep);
+	_telemetry.setParam("overlapSteps", (uint64) (_overlapSteps && !_singleStep));
+}
+
 void gerbil::Application::saveBinStat() {
 	std::string binStatFileName(_tempFolderName);
 	binStatFileName += "binStatFile.txt";
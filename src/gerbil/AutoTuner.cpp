@@ -0,0 +1,301 @@
+/*
+ * AutoTuner.cpp
+ */
+
+#include "../../include/gerbil/AutoTuner.h"
+#include "../../include/gerbil/FastParser.h"
+#include "../../include/gerbil/SequenceSplitter.h"
+#include "../../include/gerbil/global.h"
+#include "../../include/gerbil/KMerHash.h"
+#include "../../include/gerbil/KMerExtractor.h"
+#include "../../include/gerbil/KmerDistributer.h"
+#include "../../include/gerbil/CpuHasher.h"
+#include "../../include/gerbil/TempFile.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+
+gerbil::AutoTuner::AutoTuner() :
+		_parseRate(0), _parseBytesRate(0), _scanRate(0), _splitRate(0), _hashRate(0), _calibration_s(0) {
+}
+
+template<uint32_t K, bool NORM>
+void gerbil::AutoTuner::calibrateHasher(std::vector<SuperBundle*> &superBundles, const uint_cv &thresholdMin,
+		const bool &quotientKeys, const uint32 &counterSize_B, const bool &prefilter, const std::string &tempPath) {
+	// a hash table of AUTOTUNE_HASHTABLE_SIZE_B (as the table of a bin of a large input, not one of the sample size)
+	// and the k-mers of such a bin (the extract of the table is shared by as many k-mers as in a run)
+	const uint64 tableSize = AUTOTUNE_HASHTABLE_SIZE_B / (cpu::KMerBundle<K>::kMerSize_B() + sizeof(uint_cv));
+	const uint64 binKMersNumber = tableSize * FILL / START_RATIO;
+
+	// one bin of two runs: the first run (the sample) touches the hash table, the second one (the sample
+	// repeated up to binKMersNumber) is measured
+	const uint32 runsNumber = 2;
+	TempFile tempFile(0);
+	tempFile.announce(0, 0, runsNumber * binKMersNumber);
+	tempFile.initNumberOfRuns(runsNumber);
+	KmerDistributer distributor(1, 0, 1);
+	distributor.updateFileInformation(0, 0, runsNumber, tempFile.getKMersNumber());
+	const uint32 k = KMer<K>::getK();
+
+	// split (as KmerHasher::processThreadSplit)
+	constexpr bool rolling = KMER_HASH_POLICY::isRolling<K>();
+	KMerExtractor<K> extractor;
+	std::vector<cpu::KMerBundle<K>*> kMerBundles;
+	cpu::KMerBundle<K>* kmb = new cpu::KMerBundle<K>();
+	StopWatch sw(CLOCK_REALTIME);
+	uint64 kMersNumber = 0;
+	sw.start();
+	for(SuperBundle* sb : superBundles) {
+		byte* b;
+		uint16 l;
+		while(sb->next(b, l)) {
+			splitSuperMer<K, NORM>(b, l, extractor, [&](const KMer<K> &kMer, const uint64 &fwd, const uint64 &rev) {
+				const uint32_t h = rolling
+						? distributor.distributeHash(KMER_HASH_POLICY::partHashOf(fwd, rev), 0)
+						: distributor.distributeKMer<K>(kMer, 0);
+				if(h == NULL_BUCKET_VALUE)
+					return;
+				const uint64 kMerHash = rolling ? KMER_HASH_POLICY::hashOf(fwd, rev) : 0;
+				if(!kmb->add(kMer, kMerHash)) {
+					sw.hold();
+					kmb->setTempFileId(0);
+					kMerBundles.push_back(kmb);
+					kmb = new cpu::KMerBundle<K>();
+					sw.proceed();
+					kmb->add(kMer, kMerHash);
+				}
+			});
+			kMersNumber += l - k + 1;
+		}
+	}
+	sw.stop();
+	if(!kmb->isEmpty()) {
+		kmb->setTempFileId(0);
+		kMerBundles.push_back(kmb);
+	}
+	else
+		delete kmb;
+	_splitRate = sw.get_s() > 0 ? kMersNumber / sw.get_s() : 0;
+
+	// hash (HasherTask with one thread and the options of the run, the k-mer counts are dropped)
+	if(kMersNumber) {
+		SyncSwapQueueMPSC<cpu::KMerBundle<K>> *kMerQueue = new SyncSwapQueueMPSC<cpu::KMerBundle<K>>(16);
+		SyncSwapQueueMPSC<KmcBundle> kmcQueue(4);
+		std::thread sink([&kmcQueue] {
+			KmcBundle* kmcBundle = new KmcBundle();
+			while(kmcQueue.swapPop(kmcBundle))
+				kmcBundle->clear();
+			delete kmcBundle;
+		});
+		cpu::HasherTask<K> hasher(1, &distributor, &kmcQueue, &tempFile, thresholdMin, tableSize, tempPath,
+				quotientKeys, counterSize_B, prefilter);
+		hasher.hash(&kMerQueue);
+		kmb = new cpu::KMerBundle<K>();
+		for(uint32 run = 0; run < runsNumber; ++run)
+			for(uint64 runKMersNumber = 0; runKMersNumber < (run ? binKMersNumber : 1); runKMersNumber += kMersNumber)
+				for(cpu::KMerBundle<K>* bundle : kMerBundles) {
+					kmb->copy(*bundle);
+					kmb->setTempFileRun(run);
+					kMerQueue->swapPush(kmb);
+				}
+		delete kmb;
+		kMerQueue->finalize();
+		hasher.join();
+		kmcQueue.finalize();
+		sink.join();
+		delete kMerQueue;
+
+		// throughput of the last run (fill, extract and failures as reported to the distributor, k-mers / us)
+		_hashRate = 1e6 * distributor.getThroughput(false, 0);
+	}
+
+	for(cpu::KMerBundle<K>* bundle : kMerBundles)
+		delete bundle;
+}
+
+void gerbil::AutoTuner::calibrate(const uint32 &k, const uint8 &m, const uint_tfn &tempFilesNumber,
+		const bool &norm, const bool &skipEstimate, const uint_cv &thresholdMin, const bool &quotientKeys,
+		const uint32 &counterSize_B, const bool &prefilter, const std::string &tempPath) {
+	StopWatch swTotal(CLOCK_REALTIME);
+	swTotal.start();
+	ReadBundle::setK(k);
+
+	// sample: reads of both strands of a random genome, with qualities (fastq)
+	std::mt19937_64 rng(1);
+	std::string genome(AUTOTUNE_SAMPLE_BASES / AUTOTUNE_COVERAGE, 'A');
+	for(char &base : genome)
+		base = "ACGT"[rng() >> 62];
+	std::string fastq;
+	fastq.reserve(2 * AUTOTUNE_SAMPLE_BASES + AUTOTUNE_SAMPLE_BASES / AUTOTUNE_READ_LENGTH * 32);
+	const std::string qualities(AUTOTUNE_READ_LENGTH, 'I');
+	uint64 basesNumber = 0;
+	for(uint64 readId = 0; basesNumber < AUTOTUNE_SAMPLE_BASES; ++readId) {
+		const uint64 pos = rng() % (genome.size() - AUTOTUNE_READ_LENGTH);
+		fastq += "@read" + std::to_string(readId) + "\n";
+		if(rng() & 1)
+			fastq.append(genome, pos, AUTOTUNE_READ_LENGTH);
+		else
+			for(uint64 i = pos + AUTOTUNE_READ_LENGTH; i-- > pos;)
+				fastq += "TGCA"[(genome[i] >> 1) & 0x3];	// complement of A (0x41), C (0x43), G (0x47), T (0x54)
+		fastq += "\n+\n" + qualities + "\n";
+		basesNumber += AUTOTUNE_READ_LENGTH;
+	}
+
+	// parse (one FastParser thread, all FastBundles and ReadBundles are buffered)
+	const uint64 fastBundleSize = FAST_BUNDLE_DATA_SIZE_B - FAST_BLOCK_SIZE_B;
+	SyncSwapQueueSPSC<FastBundle>* fastQueue =
+			new SyncSwapQueueSPSC<FastBundle>(fastq.size() / fastBundleSize + 2);
+	FastBundle* fastBundle = new FastBundle();
+	for(uint64 pos = 0; pos < fastq.size(); pos += fastBundleSize) {
+		fastBundle->size = std::min(fastBundleSize, fastq.size() - pos);
+		memcpy(fastBundle->data, fastq.data() + pos, fastBundle->size);
+		fastBundle->finalize(fc_none);
+		fastQueue->swapPush(fastBundle);
+	}
+	delete fastBundle;
+	fastQueue->finalize();
+	const uint64 fastqBytes = fastq.size();
+	fastq.clear();
+	fastq.shrink_to_fit();
+
+	uint32 readBundlesNumber = 4 * AUTOTUNE_SAMPLE_BASES / READ_BUNDLE_SIZE_B + 16;
+	FastParser fastParser(readBundlesNumber, ft_fastq, st_reads, &fastQueue, 1, skipEstimate);
+	StopWatch sw(CLOCK_REALTIME);
+	sw.start();
+	fastParser.process();
+	fastParser.join();
+	sw.stop();
+	_parseRate = sw.get_s() > 0 ? basesNumber / sw.get_s() : 0;
+	_parseBytesRate = sw.get_s() > 0 ? fastqBytes / sw.get_s() : 0;
+	delete fastQueue;
+
+	// scan (one SequenceSplitter thread), the first SuperBundles are kept for phase two
+	SequenceSplitter sequenceSplitter(MIN_SUPERBUNDLEBUFFER_SIZE_B / SUPER_BUNDLE_DATA_SIZE_B,
+			fastParser.getSyncQueue(), 1, k, m, tempFilesNumber, norm);
+	std::vector<SuperBundle*> superBundles;
+	std::thread sink([&sequenceSplitter, &superBundles] {
+		SyncSwapQueueMPSC<SuperBundle>* superBundleQueue = sequenceSplitter.getSuperBundleQueues()[0];
+		SuperBundle* superBundle = new SuperBundle();
+		uint64 kMersNumber = 0;
+		while(superBundleQueue->swapPop(superBundle)) {
+			if(kMersNumber < AUTOTUNE_SAMPLE_KMERS) {
+				SuperBundle* copy = new SuperBundle();
+				memcpy(copy->data, superBundle->data, SUPER_BUNDLE_DATA_SIZE_B);
+				kMersNumber += superBundle->kMerNumber;
+				superBundles.push_back(copy);
+			}
+			superBundle->clear();
+		}
+		delete superBundle;
+	});
+	sw.start();
+	sequenceSplitter.process();
+	sequenceSplitter.join();
+	sw.stop();
+	sink.join();
+	_scanRate = sw.get_s() > 0 ? basesNumber / sw.get_s() : 0;
+
+	// split and hash
+#define C_CALIBRATE(x) if(norm) \
+		calibrateHasher<x, true>(superBundles, thresholdMin, quotientKeys, counterSize_B, prefilter, tempPath); \
+	else \
+		calibrateHasher<x, false>(superBundles, thresholdMin, quotientKeys, counterSize_B, prefilter, tempPath)
+#define C_PROC(x) case x: C_CALIBRATE(x); break
+#define C_PROC_DYN(c) case c: KMer<KMER_DYN(c)>::setK(k); C_CALIBRATE(KMER_DYN(c)); break
+#if MAX_STATIC_KMER_SIZE
+	if(k <= MAX_STATIC_KMER_SIZE) {
+		switch(k) {
+			LOOP128(MAX_STATIC_KMER_SIZE, C_PROC);
+			default:
+				break;
+		}
+	}
+	else
+#endif
+	switch(GET_KMER_DYN_C(k)) {
+		LOOP_KMER_DYN(C_PROC_DYN);
+		default:
+			break;
+	}
+#undef C_PROC_DYN
+#undef C_PROC
+#undef C_CALIBRATE
+	for(SuperBundle* superBundle : superBundles)
+		delete superBundle;
+
+	swTotal.stop();
+	_calibration_s = swTotal.get_s();
+}
+
+void gerbil::AutoTuner::tuneThreads(const uint8 &gpusNumber, const bool &fileInput,
+		const bool &autoSequenceSplitters, const bool &autoSuperSplitters, const bool &autoHashers,
+		uint8 &sequenceSplitters, uint8 &superSplitters, uint8 &hashers) {
+	if(!isCalibrated())
+		return;
+
+	// phase one: the parser limits the throughput of the splitters (file input)
+	if(autoSequenceSplitters && fileInput && _parseRate > 0) {
+		uint64 n = std::ceil(AUTOTUNE_HEADROOM * _parseRate / _scanRate);
+		if(n < sequenceSplitters) {
+			sequenceSplitters = n ? n : 1;
+			decide("sequenceSplitters", sequenceSplitters, "parse rate / scan rate");
+		}
+	}
+
+	// phase two: threads in proportion of the costs per k-mer
+	if(_splitRate <= 0)
+		return;
+	const uint32 cpuHashers = hashers > gpusNumber ? hashers - gpusNumber : 1;
+	if(autoSuperSplitters && autoHashers) {
+		const uint32 total = superSplitters + cpuHashers;
+		int64 s = std::lround(total * _hashRate / (_splitRate + _hashRate));
+		s = std::max<int64>(1, std::min<int64>(s, total - 1));
+		superSplitters = s;
+		hashers = gpusNumber + total - s;
+		decide("superSplitters", superSplitters, "cost of split / cost of split and hash");
+		decide("hashers", hashers, "cost of hash / cost of split and hash");
+	}
+	else if(autoSuperSplitters) {
+		const int64 s = std::lround(AUTOTUNE_HEADROOM * cpuHashers * _hashRate / _splitRate);
+		superSplitters = std::max<int64>(1, std::min<int64>(s, MAX_THREADS_NUMBER));
+		decide("superSplitters", superSplitters, "hashers * cost of split / cost of hash");
+	}
+	else if(autoHashers) {
+		const int64 h = std::lround(AUTOTUNE_HEADROOM * superSplitters * _splitRate / _hashRate);
+		hashers = gpusNumber + std::max<int64>(1, std::min<int64>(h, MAX_THREADS_NUMBER - gpusNumber));
+		decide("hashers", hashers, "splitters * cost of hash / cost of split");
+	}
+}
+
+gerbil::uint64 gerbil::AutoTuner::getQueueSize_B(const double &rate) const {
+	return AUTOTUNE_HEADROOM * rate * AUTOTUNE_QUEUE_BUFFER_MS / 1000;
+}
+
+void gerbil::AutoTuner::decide(const std::string &name, const uint64 &value, const char* reason) {
+	_decisions.push_back(std::make_pair(name, value));
+	if(verbose)
+		printf("auto tuner: %-20s: %12lu  (%s)\n", name.c_str(), value, reason);
+}
+
+void gerbil::AutoTuner::print() {
+	printf("================= AUTO TUNER =================\n");
+	printf("calibration time        : %8.3f s\n", _calibration_s);
+	printf("parse      (per thread) : %8.1f M bases/s\n", _parseRate / 1e6);
+	printf("scan       (per thread) : %8.1f M bases/s\n", _scanRate / 1e6);
+	printf("split      (per thread) : %8.1f M k-mers/s\n", _splitRate / 1e6);
+	printf("hash       (per thread) : %8.1f M k-mers/s\n", _hashRate / 1e6);
+	printf("---------------------------------------------\n");
+}
+
+void gerbil::AutoTuner::report(TelemetryStage &stage) {
+	stage.set("calibration_s", _calibration_s);
+	stage.set("parse_bases_per_s", _parseRate);
+	stage.set("parse_B_per_s", _parseBytesRate);
+	stage.set("scan_bases_per_s", _scanRate);
+	stage.set("split_kMers_per_s", _splitRate);
+	stage.set("hash_kMers_per_s", _hashRate);
+	for(const auto &decision : _decisions)
+		stage.add(decision.first, decision.second);
+}
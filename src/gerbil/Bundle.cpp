@@ -15,10 +15,12 @@ gerbil::ReadBundle::ReadBundle(){
 	readOffsets = (uint32*)(data + READ_BUNDLE_SIZE_B - 8);
 	*readsCount = 0;
 	readOffsets[0] = 0;
+	MemoryTracker::acquire(mc_readBundles, READ_BUNDLE_SIZE_B);
 }
 
 gerbil::ReadBundle::~ReadBundle(){
 	delete[] data;
+	MemoryTracker::release(mc_readBundles, READ_BUNDLE_SIZE_B);
 }
 
 bool gerbil::ReadBundle::isEmpty() const{
@@ -102,9 +104,11 @@ bool gerbil::ReadBundle::transferKm1(ReadBundle *readbundle) {
 
 gerbil::SuperBundle::SuperBundle() {
 	clear();
+	MemoryTracker::acquire(mc_superBundles, sizeof(SuperBundle));
 }
 
 gerbil::SuperBundle::~SuperBundle() {
+	MemoryTracker::release(mc_superBundles, sizeof(SuperBundle));
 }
 
 void gerbil::SuperBundle::finalize() {
@@ -185,10 +189,12 @@ bool gerbil::SuperBundle::isEmpty() const{
 gerbil::KmcBundle::KmcBundle() {
 	_data = new byte[KMC_BUNDLE_DATA_SIZE_B];
 	clear();
+	MemoryTracker::acquire(mc_kmcBundles, KMC_BUNDLE_DATA_SIZE_B);
 }
 
 gerbil::KmcBundle::~KmcBundle() {
 	delete[] _data;
+	MemoryTracker::release(mc_kmcBundles, KMC_BUNDLE_DATA_SIZE_B);
 }
 
 void gerbil::KmcBundle::clear() {
@@ -265,6 +265,7 @@ gerbil::FastParser::FastParser(
 	_fileType = fileType;
 	_seqType = seqType;
 	_fastSyncSwapQueues = fastSyncSwapQueues;
+	_syncQueue.monitor("readBundleQueue");
 	///////
 	_skipEstimate = skipEstimate;
 	//////
@@ -450,6 +451,11 @@ void gerbil::FastParser::print() {
 	printf("number of reads        : %12lu\n", _readsNumber);
 }
 
+void gerbil::FastParser::report(TelemetryStage &stage) {
+	stage.add("fastParser.reads", _readsNumber);
+	stage.addQueue("readBundleQueue", _syncQueue.getStat());
+}
+
 gerbil::FastParser::~FastParser() {
 	delete[] _curFastBundles;
 	delete[] _decompressors;
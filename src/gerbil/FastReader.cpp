@@ -13,7 +13,7 @@
 gerbil::FastReader::FastReader(const uint32_t &frBlocksNumber,
 		std::string pPath, uint8 &_readerParserThreadsNumber) :
 		_path(pPath), _processThreads(NULL), _fileType(ft_unknown), _totalBlocksRead(
-				0), _totalReadBytes(0), _fastFilesNumber(0), _threadsNumber(
+				0), _progressBytes(0), _totalReadBytes(0), _fastFilesNumber(0), _threadsNumber(
 				_readerParserThreadsNumber), _fastFileNr(0) {
 
 	// check if path exists
@@ -133,9 +133,11 @@ gerbil::FastReader::FastReader(const uint32_t &frBlocksNumber,
 	_processThreads = new std::thread*[_threadsNumber];
 
 	_syncSwapQueues = new SyncSwapQueueSPSC<FastBundle>*[_threadsNumber];
-	for (uint i(0); i < _threadsNumber; ++i)
+	for (uint i(0); i < _threadsNumber; ++i) {
 		_syncSwapQueues[i] = new SyncSwapQueueSPSC<FastBundle>(
 				frBlocksNumber / _threadsNumber);
+		_syncSwapQueues[i]->monitor("fastBundleQueue", i);
+	}
 
 	std::vector<std::pair<uint64_t, uint64_t>> fastFileOrder;
 
@@ -264,6 +266,7 @@ void gerbil::FastReader::readFile(
 
 			curData += readSize;
 			filePos += readSize;
+			_progressBytes += readSize;
 			++_totalBlocksRead;
 			//if(_totalBlocksRead % (1024 * 1024 * 256/ FAST_BLOCK_SIZE_B) == 0)
 			//	printf("\r%4.3f GB", (double)_totalBlocksRead / 1024 * FAST_BLOCK_SIZE_B / 1024 / 1024);
@@ -287,10 +290,16 @@ void gerbil::FastReader::readFile(
 		fclose(file);
 	} else if (fastFile.getCompr() == fc_bz2) {
 		uint64 fileSize(0);
+		long filePos(0);
 		int bzError = BZ_OK;
 		while (bzError != BZ_STREAM_END) {
 			curFastBundle->size = BZ2_bzRead(&bzError, bzip2File,
 					curFastBundle->data, FAST_BUNDLE_DATA_SIZE_B);
+			const long pos(ftell(file));
+			if (pos > filePos) {
+				_progressBytes += pos - filePos;
+				filePos = pos;
+			}
 			curFastBundle->finalize(fc_none);
 			fileSize += curFastBundle->size;
 			IF_MESS_FASTREADER(sw->hold());
@@ -376,6 +385,15 @@ printf("total blocks read      : %12lu\n",
 		_totalBlocksRead.load(std::memory_order_relaxed));
 }
 
+void gerbil::FastReader::report(TelemetryStage &stage) {
+	stage.add("fastReader.bytes", _totalReadBytes);
+	stage.add("fastReader.blocks", _totalBlocksRead.load(std::memory_order_relaxed));
+	SyncQueueStat queueStat;
+	for (uint_fast32_t i(0); i < _threadsNumber; ++i)
+		queueStat += _syncSwapQueues[i]->getStat();
+	stage.addQueue("fastBundleQueue", queueStat);
+}
+
 gerbil::SyncSwapQueueSPSC<gerbil::FastBundle>** gerbil::FastReader::getSyncSwapQueues() {
 return _syncSwapQueues;
 }
@@ -383,6 +401,28 @@ return _syncSwapQueues;
 gerbil::TFileType gerbil::FastReader::getFileType() const {
 return _fileType;
 }
+
+gerbil::uint64 gerbil::FastReader::getApprBasesNumber() const {
+	uint64 basesNumber = 0;
+	for (uint_fast32_t i(0); i < _fastFilesNumber; ++i) {
+		// compressed files: ~ 1/3 of the original size
+		uint64 size = _fastFiles[i]->getSize() * (_fastFiles[i]->getCompr() == fc_none ? 1 : 3);
+		// fastq: bases and qualities
+		basesNumber += _fileType == ft_fastq ? size / 2 : size;
+	}
+	return basesNumber;
+}
+gerbil::uint64 gerbil::FastReader::getProgressBytes() const {
+	return _progressBytes.load(std::memory_order_relaxed);
+}
+
+gerbil::uint64 gerbil::FastReader::getTotalBytes() const {
+	uint64 totalBytes = 0;
+	for (uint_fast32_t i(0); i < _fastFilesNumber; ++i)
+		totalBytes += _fastFiles[i]->getSize();
+	return totalBytes;
+}
+
 gerbil::FastReader::~FastReader() {
 delete[] _processThreads;
 delete[] _fastFiles;
@@ -0,0 +1,234 @@
+/*
+ * HugePages.cpp
+ */
+
+#include "../../include/gerbil/HugePages.h"
+#include "../../include/gerbil/Telemetry.h"
+#include "../../include/gerbil/config.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <vector>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#define MAP_HUGE_2M_FLAG (21 << MAP_HUGE_SHIFT)
+#define MAP_HUGE_1G_FLAG (30 << MAP_HUGE_SHIFT)
+
+namespace {
+
+// slab of equal blocks of a bundle pool
+struct Slab {
+	gerbil::byte* base;
+	gerbil::uint64 blockSize_B;
+	std::vector<gerbil::byte*> free;
+	gerbil::uint32 live;
+};
+
+gerbil::THugePages __mode = gerbil::hp_none;
+std::mutex __slabsMtx;
+std::vector<Slab> __slabs;
+
+// page size of each mapping (needed to unmap it)
+std::mutex __mapsMtx;
+std::vector<std::pair<void*, gerbil::THugePages>> __maps;
+
+// bytes mapped so far by page size
+std::atomic<gerbil::uint64> __hugetlb1G_B(0);
+std::atomic<gerbil::uint64> __hugetlb2M_B(0);
+std::atomic<gerbil::uint64> __transparent_B(0);
+std::atomic<gerbil::uint64> __fallbacks(0);
+
+const char* __modeNames[] = {"none", "transparent", "2M", "1G"};
+
+inline gerbil::uint64 roundUp(const gerbil::uint64 &size, const gerbil::uint64 &align) {
+	return (size + align - 1) / align * align;
+}
+
+void* mapHugetlb(const gerbil::uint64 &size_B, const int &flag) {
+	void* p = mmap(NULL, size_B, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | flag, -1, 0);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+// 2 MB aligned anonymous mapping (whole huge pages for THP)
+void* mapTransparent(const gerbil::uint64 &size_B) {
+	const gerbil::uint64 mapSize_B = size_B + HUGE_PAGE_SIZE_B;
+	void* m = mmap(NULL, mapSize_B, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(m == MAP_FAILED)
+		return NULL;
+	gerbil::byte* p = (gerbil::byte*) roundUp((gerbil::uint64) m, HUGE_PAGE_SIZE_B);
+	if(p > (gerbil::byte*) m)
+		munmap(m, p - (gerbil::byte*) m);
+	if((gerbil::byte*) m + mapSize_B > p + size_B)
+		munmap(p + size_B, (gerbil::byte*) m + mapSize_B - (p + size_B));
+	madvise(p, size_B, MADV_HUGEPAGE);
+	return p;
+}
+
+// size of a mapping of the mode (multiple of its page size)
+gerbil::uint64 getMapSize(const gerbil::uint64 &size_B, const gerbil::THugePages &mode) {
+	return roundUp(size_B, mode == gerbil::hp_1g ? HUGE_PAGE_1G_SIZE_B : HUGE_PAGE_SIZE_B);
+}
+
+// maps with the largest possible page size, returns the mode which was used
+void* map(const gerbil::uint64 &size_B, gerbil::THugePages mode, gerbil::THugePages &usedMode) {
+	void* p = NULL;
+	if(mode == gerbil::hp_1g) {
+		if(size_B >= HUGE_PAGE_1G_SIZE_B && (p = mapHugetlb(getMapSize(size_B, gerbil::hp_1g), MAP_HUGE_1G_FLAG))) {
+			__hugetlb1G_B += getMapSize(size_B, gerbil::hp_1g);
+			usedMode = gerbil::hp_1g;
+			return p;
+		}
+		if(size_B >= HUGE_PAGE_1G_SIZE_B)
+			++__fallbacks;
+		mode = gerbil::hp_2m;
+	}
+	if(mode == gerbil::hp_2m) {
+		if((p = mapHugetlb(getMapSize(size_B, gerbil::hp_2m), MAP_HUGE_2M_FLAG))) {
+			__hugetlb2M_B += getMapSize(size_B, gerbil::hp_2m);
+			usedMode = gerbil::hp_2m;
+			return p;
+		}
+		++__fallbacks;
+	}
+	if((p = mapTransparent(getMapSize(size_B, gerbil::hp_transparent)))) {
+		__transparent_B += getMapSize(size_B, gerbil::hp_transparent);
+		usedMode = gerbil::hp_transparent;
+		return p;
+	}
+	std::cerr << "unable to map " << size_B << " bytes" << std::endl;
+	exit(1);
+}
+
+void unmap(void* p, const gerbil::uint64 &size_B, const gerbil::THugePages &usedMode) {
+	munmap(p, getMapSize(size_B, usedMode));
+}
+
+}
+
+void gerbil::HugePages::setMode(const THugePages &mode) {
+	__mode = mode;
+}
+
+gerbil::THugePages gerbil::HugePages::getMode() {
+	return __mode;
+}
+
+void* gerbil::HugePages::allocate(const uint64 &size_B) {
+	if(__mode == hp_none)
+		return new byte[size_B];
+	THugePages usedMode;
+	void* p = map(size_B ? size_B : 1, __mode, usedMode);
+	std::unique_lock<std::mutex> lock(__mapsMtx);
+	__maps.push_back(std::make_pair(p, usedMode));
+	return p;
+}
+
+void gerbil::HugePages::release(void* p, const uint64 &size_B) {
+	if(!p)
+		return;
+	THugePages usedMode = hp_none;
+	{
+		std::unique_lock<std::mutex> lock(__mapsMtx);
+		for(auto it = __maps.begin(); it != __maps.end(); ++it)
+			if(it->first == p) {
+				usedMode = it->second;
+				__maps.erase(it);
+				break;
+			}
+	}
+	if(usedMode == hp_none)
+		delete[] (byte*) p;
+	else
+		unmap(p, size_B ? size_B : 1, usedMode);
+}
+
+void* gerbil::HugePages::allocateBlock(const uint64 &size_B) {
+	if(__mode == hp_none || size_B > HUGE_PAGE_SIZE_B / 2)
+		return allocate(size_B);
+	std::unique_lock<std::mutex> lock(__slabsMtx);
+	for(Slab &slab : __slabs)
+		if(slab.blockSize_B == size_B && !slab.free.empty()) {
+			byte* p = slab.free.back();
+			slab.free.pop_back();
+			++slab.live;
+			return p;
+		}
+	// new slab, pools never use 1 GB pages
+	THugePages usedMode;
+	Slab slab;
+	slab.base = (byte*) map(HUGE_PAGE_SIZE_B, __mode == hp_1g ? hp_2m : __mode, usedMode);
+	slab.blockSize_B = size_B;
+	for(uint64 i = HUGE_PAGE_SIZE_B / size_B; i-- > 1;)
+		slab.free.push_back(slab.base + i * size_B);
+	slab.live = 1;
+	__slabs.push_back(slab);
+	{
+		std::unique_lock<std::mutex> mapsLock(__mapsMtx);
+		__maps.push_back(std::make_pair((void*) slab.base, usedMode));
+	}
+	return slab.base;
+}
+
+void gerbil::HugePages::releaseBlock(void* p, const uint64 &size_B) {
+	if(!p)
+		return;
+	if(__mode == hp_none || size_B > HUGE_PAGE_SIZE_B / 2) {
+		release(p, size_B);
+		return;
+	}
+	byte* base = NULL;
+	{
+		std::unique_lock<std::mutex> lock(__slabsMtx);
+		for(auto it = __slabs.begin(); it != __slabs.end(); ++it)
+			if((byte*) p >= it->base && (byte*) p < it->base + HUGE_PAGE_SIZE_B) {
+				it->free.push_back((byte*) p);
+				if(!--it->live) {
+					base = it->base;
+					__slabs.erase(it);
+				}
+				break;
+			}
+	}
+	// whole slab is free
+	if(base)
+		release(base, HUGE_PAGE_SIZE_B);
+}
+
+gerbil::uint64 gerbil::HugePages::getMapped_B(const THugePages &mode) {
+	switch(mode) {
+		case hp_1g: return __hugetlb1G_B.load();
+		case hp_2m: return __hugetlb2M_B.load();
+		case hp_transparent: return __transparent_B.load();
+		default: return 0;
+	}
+}
+
+gerbil::uint64 gerbil::HugePages::getFallbacksNumber() {
+	return __fallbacks.load();
+}
+
+const char* gerbil::HugePages::getName(const THugePages &mode) {
+	return __modeNames[mode];
+}
+
+void gerbil::HugePages::print() {
+	if(__mode == hp_none)
+		return;
+	printf("huge pages             : %12s\n", getName(__mode));
+	printf("  1G/2M/THP mapped     : %lu / %lu / %lu MB (fallbacks: %lu)\n", B_TO_MB(__hugetlb1G_B.load()),
+			B_TO_MB(__hugetlb2M_B.load()), B_TO_MB(__transparent_B.load()), __fallbacks.load());
+}
+
+void gerbil::HugePages::report(TelemetryStage &stage) {
+	stage.add("hugepages.mode", __mode);
+	stage.add("hugepages.hugetlb_1g_B", __hugetlb1G_B.load());
+	stage.add("hugepages.hugetlb_2m_B", __hugetlb2M_B.load());
+	stage.add("hugepages.transparent_B", __transparent_B.load());
+	stage.add("hugepages.fallbacks", __fallbacks.load());
+}
@@ -9,7 +9,8 @@
 #include<tuple>
 #include<vector>
 
-gerbil::KmcWriter::KmcWriter(int upperBound, int lowerBound,std::string fileName, SyncSwapQueueMPSC<KmcBundle>* kmcSyncSwapQueue, const uint32_t &k, const TOutputFormat pOutputFormat) {
+gerbil::KmcWriter::KmcWriter(int upperBound, int lowerBound,std::string fileName, SyncSwapQueueMPSC<KmcBundle>* kmcSyncSwapQueue, const uint32_t &k, const TOutputFormat pOutputFormat,
+		KmcConsumer* consumer) {
 	_upperBound = upperBound;
 	_lowerBound = lowerBound;
 	_processThread = NULL;
@@ -17,9 +18,12 @@ gerbil::KmcWriter::KmcWriter(int upperBound, int lowerBound,std::string fileName
 	_k = k;
 	_outputFormat = pOutputFormat;
 	_kmcSyncSwapQueue = kmcSyncSwapQueue;
+	_consumer = consumer;
+	_file = NULL;
 	listKmer = new std::vector<std::pair<std::string,uint32> >();
 	if(_outputFormat != of_none) {
 		std::remove(_fileName.c_str());
+		std::remove((_fileName + ".idx").c_str());
 		_file = fopen(_fileName.c_str(), "wb");
 		if (!_file) {
 			std::cerr << "unable to create output-file" << std::endl;
@@ -29,6 +33,8 @@ gerbil::KmcWriter::KmcWriter(int upperBound, int lowerBound,std::string fileName
 	if(_outputFormat == of_gerbil)
 		setbuf(_file, NULL);
 	_fileSize = 0;
+	_kmcBundlesNumber = 0;
+	_kmcBundlesSize = 0;
 }
 
 gerbil::KmcWriter::~KmcWriter() {
@@ -51,58 +57,64 @@ void gerbil::KmcWriter::process() {
 		KmcBundle* kb = new KmcBundle;
 		std::string kmer;
 		std::pair<std::string,uint32> pair_to_insert;
-		if(_outputFormat == of_fasta) {
-			uint32 counter;
-			char kmerSeq[_k + 1]; kmerSeq[_k] = '\0';
-			const size_t kMerSize_B = (_k + 3) / 4;
-			const char c[4] = {'A', 'C', 'G', 'T'};
 
-			IF_MESS_KMCWRITER(sw.hold();)
-			while(_kmcSyncSwapQueue->swapPop(kb)) {
-				IF_MESS_KMCWRITER(sw.proceed();)
-				if(!kb->isEmpty()) {
+		// the list is only filled if no consumer streams the k-mers
+		const bool fillList = _outputFormat == of_fasta && !_consumer;
+		uint32 counter;
+		const byte* kMerBytes;
+		char kmerSeq[_k + 1]; kmerSeq[_k] = '\0';
+
+		// each bundle starts at a record boundary
+		std::vector<uint64_t> chunkIndex;
+
+		// memory of the list (entries and sequences which exceed the small string buffer of 15 chars)
+		const uint64 sequenceSize = _k > 15 ? _k + 1 : 0;
+		uint64 listSize = 0;
+
+		IF_MESS_KMCWRITER(sw.hold();)
+		while(_kmcSyncSwapQueue->swapPop(kb)) {
+			IF_MESS_KMCWRITER(sw.proceed();)
+			if(!kb->isEmpty()) {
+				++_kmcBundlesNumber;
+				_kmcBundlesSize += kb->getSize();
+				if(_consumer)
+					_consumer->consume(*kb);
+				if(fillList) {
 					const byte* p = kb->getData();
 					const byte* end = p + kb->getSize();
 					while(p < end) {
-						counter = (uint32)*(p++);
-						if(counter >= 255) {
-							// large value
-							counter = *((uint32*)p);
-							p += 4;
+						p = KmcBundle::nextRecord(p, _k, counter, kMerBytes);
+						if(counter>=_lowerBound && counter<=_upperBound) {
+							// k-mer: convert bytes to string
+							KmcBundle::toSequence(kMerBytes, _k, kmerSeq);
+							kmer = kmerSeq;
+							pair_to_insert = std::make_pair(kmer,counter);
+							listKmer->push_back(pair_to_insert);
 						}
-						// k-mer: convert bytes to string
-						for(uint i = 0; i < _k; ++i)
-							kmerSeq[i] = c[(p[i >> 2] >> (2 * (3 - (i & 0x3)))) & 0x3];
-
-						// increase pointer
-						p += kMerSize_B;
-						kmer = kmerSeq;
-						pair_to_insert = std::make_pair(kmer,counter);
-						if(counter>=_lowerBound && counter<=_upperBound)
-							listKmer->push_back(pair_to_insert);		
-		// print fasta (console/file)
-					//	fprintf(_file, ">%u\n%s\n", counter, kmerSeq);
 					}
+					const uint64 newListSize = listKmer->capacity() * sizeof(pair_to_insert)
+							+ listKmer->size() * sequenceSize;
+					MemoryTracker::acquire(mc_output, newListSize - listSize);
+					listSize = newListSize;
 				}
-				kb->clear();
-				IF_MESS_KMCWRITER(sw.hold();)
-			}
-			_fileSize = ftell(_file);
-		}
-		else if(_outputFormat == of_gerbil) {
-			IF_MESS_KMCWRITER(sw.hold();)
-			while(_kmcSyncSwapQueue->swapPop(kb)) {
-				_fileSize += kb->getSize();
-				IF_MESS_KMCWRITER(sw.proceed();)
-				if(!kb->isEmpty()) {
+				else if(_outputFormat == of_gerbil) {
+					chunkIndex.push_back(_fileSize);
 					fwrite ((char*) kb->getData() , 1 , kb->getSize() , _file );
+					_fileSize += kb->getSize();
 				}
-				kb->clear();
-				IF_MESS_KMCWRITER(sw.hold();)
 			}
+			kb->clear();
+			IF_MESS_KMCWRITER(sw.hold();)
 		}
 		IF_MESS_KMCWRITER(sw.proceed();)
 
+		if(_consumer)
+			_consumer->finish();
+		if(_outputFormat == of_gerbil)
+			writeChunkIndex(chunkIndex);
+		else if(_file)
+			_fileSize = ftell(_file);
+
 		delete kb;
 		if(_file)
 			fclose(_file);
@@ -113,6 +125,16 @@ void gerbil::KmcWriter::process() {
 	});
 }
 
+void gerbil::KmcWriter::writeChunkIndex(const std::vector<uint64_t> &chunkIndex) {
+	FILE* indexFile = fopen((_fileName + ".idx").c_str(), "wb");
+	if(!indexFile) {
+		std::cerr << "unable to create index of output-file" << std::endl;
+		return;
+	}
+	fwrite((char*) chunkIndex.data(), sizeof(uint64_t), chunkIndex.size(), indexFile);
+	fclose(indexFile);
+}
+
 void gerbil::KmcWriter::join() {
 	_processThread->join();
 	delete _processThread;
@@ -130,3 +152,9 @@ void gerbil::KmcWriter::deleteProcessThread(){
 void gerbil::KmcWriter::print() {
 	printf("size of output  : %12.3f MB\n", (double)_fileSize / 1024 / 1024);
 }
+
+void gerbil::KmcWriter::report(TelemetryStage &stage) {
+	stage.add("kmcWriter.kmcBundles", _kmcBundlesNumber);
+	stage.add("kmcWriter.bundleBytes", _kmcBundlesSize);
+	stage.add("kmcWriter.outputBytes", _fileSize);
+}
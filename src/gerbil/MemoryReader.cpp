@@ -0,0 +1,92 @@
+/*
+ * MemoryReader.cpp
+ */
+
+#include <cmath>
+
+#include "../../include/gerbil/MemoryReader.h"
+
+#define ACSCIIBASE 33
+
+// maximal length of a single piece of a read in a ReadBundle
+#define MEMORY_READER_MAX_PIECE_SIZE_B (READ_BUNDLE_SIZE_B / 2)
+
+gerbil::MemoryReader::MemoryReader(const uint32 &readBundlesNumber, ReadSource* readSource, bool skipEstimate) :
+		_readSource(readSource), _skipEstimate(skipEstimate), _erate(0.0), _readsNumber(0), _basesNumber(0),
+		_syncQueue(readBundlesNumber), _processThread(NULL) {
+	_syncQueue.monitor("readBundleQueue");
+}
+
+void gerbil::MemoryReader::storeRead(const char *read, uint32 length, ReadBundle *&readBundle) {
+	const uint32 k = ReadBundle::getK();
+	while(true) {
+		const uint32 l = length < MEMORY_READER_MAX_PIECE_SIZE_B ? length : MEMORY_READER_MAX_PIECE_SIZE_B;
+		if (!readBundle->add(l, (char*) read)) {
+			_syncQueue.swapPush(readBundle);
+			readBundle->add(l, (char*) read);
+		}
+		if(l == length || l < k)
+			break;
+		// next piece overlaps by k-1 bases
+		read += l - (k - 1);
+		length -= l - (k - 1);
+	}
+}
+
+void gerbil::MemoryReader::process() {
+	if(_processThread)
+		return;
+	_processThread = new std::thread([this] {
+		ReadBundle *readBundle = new ReadBundle();
+		const char* read;
+		const char* qualities;
+		uint32 length;
+		double erate = 0.0;
+		uint64 qualifiedReadsNumber = 0;
+		while(_readSource->next(read, length, qualities)) {
+			if(length)
+				storeRead(read, length, readBundle);
+			// error rate
+			if(qualities && length && !_skipEstimate) {
+				double rerror = 0.0;
+				for(uint32 i = 0; i < length; ++i)
+					rerror += pow(10, -(double)((int) qualities[i] - ACSCIIBASE) / 10);
+				erate += rerror / length;
+				++qualifiedReadsNumber;
+			}
+			_basesNumber += length;
+			++_readsNumber;
+		}
+		if(qualifiedReadsNumber)
+			_erate = erate / qualifiedReadsNumber;
+		if (!readBundle->isEmpty())
+			_syncQueue.swapPush(readBundle);
+		delete readBundle;
+	});
+}
+
+void gerbil::MemoryReader::join() {
+	_processThread->join();
+	delete _processThread;
+	_processThread = NULL;
+	_syncQueue.finalize();
+}
+
+gerbil::SyncSwapQueueMPMC<gerbil::ReadBundle> *gerbil::MemoryReader::getSyncQueue() {
+	return &_syncQueue;
+}
+
+void gerbil::MemoryReader::print() {
+	printf("number of reads        : %12lu\n", _readsNumber.load());
+	printf("number of bases        : %12lu\n", _basesNumber.load());
+}
+
+void gerbil::MemoryReader::report(TelemetryStage &stage) {
+	stage.add("memoryReader.reads", _readsNumber);
+	stage.add("memoryReader.bases", _basesNumber);
+	stage.addQueue("readBundleQueue", _syncQueue.getStat());
+}
+
+gerbil::MemoryReader::~MemoryReader() {
+
+}
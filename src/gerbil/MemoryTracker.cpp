@@ -0,0 +1,152 @@
+/*
+ * MemoryTracker.cpp
+ */
+
+#include "../../include/gerbil/MemoryTracker.h"
+#include "../../include/gerbil/Telemetry.h"
+
+#include <atomic>
+
+namespace {
+
+std::atomic<gerbil::uint64> __live[gerbil::mc_number];
+std::atomic<gerbil::uint64> __peak[gerbil::mc_number];
+std::atomic<gerbil::uint64> __totalLive(0);
+std::atomic<gerbil::uint64> __totalPeak(0);
+std::atomic<gerbil::uint64> __exceeded(0);
+std::atomic<gerbil::uint64> __refused(0);
+std::atomic<gerbil::uint64> __downsized(0);
+gerbil::uint64 __budget = 0;
+
+const char* __names[gerbil::mc_number] = {
+		"fastBundles", "readBundles", "superBundles", "bins", "kMerBundles", "hashTables", "kmcBundles", "output"
+};
+
+inline void updatePeak(std::atomic<gerbil::uint64> &peak, const gerbil::uint64 &value) {
+	gerbil::uint64 cur = peak.load(std::memory_order_relaxed);
+	while(value > cur && !peak.compare_exchange_weak(cur, value, std::memory_order_relaxed));
+}
+
+// adds size_B to the live values (total already added)
+inline void record(const gerbil::TMemoryComponent &component, const gerbil::uint64 &size_B,
+		const gerbil::uint64 &total) {
+	updatePeak(__totalPeak, total);
+	updatePeak(__peak[component], __live[component].fetch_add(size_B, std::memory_order_relaxed) + size_B);
+}
+
+}
+
+void gerbil::MemoryTracker::reset(const uint64 &budget_B) {
+	__budget = budget_B;
+	for(uint i = 0; i < mc_number; ++i)
+		__live[i] = __peak[i] = 0;
+	__totalLive = __totalPeak = 0;
+	__exceeded = __refused = __downsized = 0;
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getBudget() {
+	return __budget;
+}
+
+bool gerbil::MemoryTracker::acquire(const TMemoryComponent &component, const uint64 &size_B) {
+	const uint64 total = __totalLive.fetch_add(size_B, std::memory_order_relaxed) + size_B;
+	record(component, size_B, total);
+	if(__budget && total > __budget) {
+		++__exceeded;
+		return false;
+	}
+	return true;
+}
+
+bool gerbil::MemoryTracker::tryAcquire(const TMemoryComponent &component, const uint64 &size_B) {
+	uint64 total = __totalLive.load(std::memory_order_relaxed);
+	do {
+		if(__budget && total + size_B > __budget) {
+			++__refused;
+			return false;
+		}
+	} while(!__totalLive.compare_exchange_weak(total, total + size_B, std::memory_order_relaxed));
+	record(component, size_B, total + size_B);
+	return true;
+}
+
+gerbil::uint64 gerbil::MemoryTracker::acquireUpTo(const TMemoryComponent &component, const uint64 &size_B,
+		const uint64 &minSize_B) {
+	uint64 total = __totalLive.load(std::memory_order_relaxed);
+	uint64 granted;
+	do {
+		granted = size_B;
+		if(__budget && total + granted > __budget)
+			granted = total + minSize_B < __budget ? __budget - total : minSize_B;
+	} while(!__totalLive.compare_exchange_weak(total, total + granted, std::memory_order_relaxed));
+	record(component, granted, total + granted);
+	if(granted < size_B)
+		++__downsized;
+	if(__budget && total + granted > __budget)
+		++__exceeded;
+	return granted;
+}
+
+void gerbil::MemoryTracker::release(const TMemoryComponent &component, const uint64 &size_B) {
+	__live[component].fetch_sub(size_B, std::memory_order_relaxed);
+	__totalLive.fetch_sub(size_B, std::memory_order_relaxed);
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getLive() {
+	return __totalLive.load();
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getPeak() {
+	return __totalPeak.load();
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getLive(const TMemoryComponent &component) {
+	return __live[component].load();
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getPeak(const TMemoryComponent &component) {
+	return __peak[component].load();
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getExceededNumber() {
+	return __exceeded.load();
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getRefusedNumber() {
+	return __refused.load();
+}
+
+gerbil::uint64 gerbil::MemoryTracker::getDownsizedNumber() {
+	return __downsized.load();
+}
+
+void gerbil::MemoryTracker::resetPeaks() {
+	for(uint i = 0; i < mc_number; ++i)
+		__peak[i] = __live[i].load();
+	__totalPeak = __totalLive.load();
+	__exceeded = __refused = __downsized = 0;
+}
+
+const char* gerbil::MemoryTracker::getName(const TMemoryComponent &component) {
+	return __names[component];
+}
+
+void gerbil::MemoryTracker::print(const uint64 &estimated_B) {
+	printf("memory peak (actual)   : %12lu MB (estimated: %lu MB)\n", B_TO_MB(getPeak()), B_TO_MB(estimated_B));
+	for(uint i = 0; i < mc_number; ++i)
+		if(__peak[i])
+			printf("  %-20s : %12lu MB\n", __names[i], B_TO_MB(__peak[i].load()));
+	if(__exceeded || __refused || __downsized)
+		printf("  budget exceeded/refused/downsized: %lu / %lu / %lu\n",
+				__exceeded.load(), __refused.load(), __downsized.load());
+}
+
+void gerbil::MemoryTracker::report(TelemetryStage &stage, const uint64 &estimated_B) {
+	stage.add("memory.estimated_B", estimated_B);
+	stage.add("memory.peak_B", getPeak());
+	for(uint i = 0; i < mc_number; ++i)
+		stage.add(std::string("memory.") + __names[i] + "_peak_B", __peak[i].load());
+	stage.add("memory.exceeded", __exceeded.load());
+	stage.add("memory.refused", __refused.load());
+	stage.add("memory.downsized", __downsized.load());
+}
@@ -0,0 +1,153 @@
+/*
+ * NumaTopology.cpp
+ */
+
+#include "../../include/gerbil/NumaTopology.h"
+#include "../../include/gerbil/Telemetry.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+std::vector<std::vector<gerbil::uint32>> __nodeCpus;     // cpus of each node (within __affinity)
+cpu_set_t __affinity;                                     // affinity of the process at detect (e.g. taskset)
+bool __enabled = true;
+std::atomic<gerbil::uint64> __localTransfers(0);
+std::atomic<gerbil::uint64> __remoteTransfers(0);
+
+// parses a sysfs cpu list, e.g. "0-3,8-11"
+bool parseCpuList(const std::string &list, std::vector<gerbil::uint32> &cpus) {
+	size_t pos = 0;
+	while(pos < list.size()) {
+		size_t end = list.find(',', pos);
+		if(end == std::string::npos)
+			end = list.size();
+		const std::string range = list.substr(pos, end - pos);
+		pos = end + 1;
+		if(range.empty())
+			continue;
+		unsigned first, last;
+		const int n = sscanf(range.c_str(), "%u-%u", &first, &last);
+		if(n < 1)
+			return false;
+		if(n == 1)
+			last = first;
+		for(unsigned cpu = first; cpu <= last; ++cpu)
+			cpus.push_back(cpu);
+	}
+	return true;
+}
+
+bool setAffinity(const std::vector<gerbil::uint32> &cpus) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for(const gerbil::uint32 &cpu : cpus)
+		if(cpu < CPU_SETSIZE)
+			CPU_SET(cpu, &set);
+	return !pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+// cpus which the process may use
+bool isAllowed(const gerbil::uint32 &cpu) {
+	return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &__affinity);
+}
+
+}
+
+void gerbil::NumaTopology::detect(const std::string &sysPath) {
+	__nodeCpus.clear();
+	if(sched_getaffinity(0, sizeof(__affinity), &__affinity)) {
+		CPU_ZERO(&__affinity);
+		for(uint32 cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			CPU_SET(cpu, &__affinity);
+	}
+	for(uint32 node = 0; ; ++node) {
+		std::ifstream file(sysPath + "/node" + std::to_string(node) + "/cpulist");
+		if(!file)
+			break;
+		std::string list;
+		std::getline(file, list);
+		std::vector<uint32> nodeCpus, cpus;
+		if(!parseCpuList(list, nodeCpus))
+			break;
+		for(const uint32 &cpu : nodeCpus)
+			if(isAllowed(cpu))
+				cpus.push_back(cpu);
+		if(!cpus.empty())                       // memory only nodes and nodes outside the affinity get no threads
+			__nodeCpus.push_back(cpus);
+	}
+	if(__nodeCpus.empty()) {
+		std::vector<uint32> cpus;
+		for(uint32 cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			if(isAllowed(cpu))
+				cpus.push_back(cpu);
+		__nodeCpus.push_back(cpus);
+	}
+	resetTransfers();
+}
+
+void gerbil::NumaTopology::setEnabled(const bool &enabled) {
+	__enabled = enabled;
+}
+
+bool gerbil::NumaTopology::isEnabled() {
+	return __enabled && __nodeCpus.size() > 1;
+}
+
+gerbil::uint32 gerbil::NumaTopology::getNodesNumber() {
+	return __nodeCpus.empty() ? 1 : __nodeCpus.size();
+}
+
+gerbil::uint32 gerbil::NumaTopology::getNode(const uint32 &tId, const uint32 &threadsNumber) {
+	return threadsNumber ? (uint64) tId * getNodesNumber() / threadsNumber : 0;
+}
+
+bool gerbil::NumaTopology::pin(const uint32 &node) {
+	if(!isEnabled() || node >= __nodeCpus.size())
+		return false;
+	return setAffinity(__nodeCpus[node]);
+}
+
+void gerbil::NumaTopology::unpin() {
+	if(!isEnabled())
+		return;
+	pthread_setaffinity_np(pthread_self(), sizeof(__affinity), &__affinity);
+}
+
+void gerbil::NumaTopology::addTransfers(const uint64 &local, const uint64 &remote) {
+	__localTransfers += local;
+	__remoteTransfers += remote;
+}
+
+void gerbil::NumaTopology::resetTransfers() {
+	__localTransfers = 0;
+	__remoteTransfers = 0;
+}
+
+gerbil::uint64 gerbil::NumaTopology::getRemoteTransfersNumber() {
+	return __remoteTransfers.load();
+}
+
+double gerbil::NumaTopology::getRemoteRatio() {
+	const uint64 all = __localTransfers.load() + __remoteTransfers.load();
+	return all ? (double) __remoteTransfers.load() / all : 0;
+}
+
+void gerbil::NumaTopology::print() {
+	printf("numa nodes             : %12u (%s)\n", getNodesNumber(), isEnabled() ? "pinned" : "not pinned");
+	for(uint32 node = 0; node < __nodeCpus.size(); ++node)
+		printf("  node %-15u : %12lu cpus\n", node, __nodeCpus[node].size());
+	if(isEnabled())
+		printf("remote kMerBundles     : %12lu (%.1f %%)\n", getRemoteTransfersNumber(), 100.0 * getRemoteRatio());
+}
+
+void gerbil::NumaTopology::report(TelemetryStage &stage) {
+	stage.add("numa.nodes", getNodesNumber());
+	stage.add("numa.pinned", isEnabled() ? 1 : 0);
+	stage.add("numa.remote_kmer_bundles", getRemoteTransfersNumber());
+	stage.set("numa.remote_ratio", getRemoteRatio());
+}
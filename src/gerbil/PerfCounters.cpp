@@ -0,0 +1,161 @@
+/*
+ * PerfCounters.cpp
+ */
+
+#include "../../include/gerbil/PerfCounters.h"
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+namespace {
+
+const gerbil::uint64 __perfEventConfigs[PERF_EVENTS_NUMBER] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+};
+
+const char* __perfEventNames[PERF_EVENTS_NUMBER] = {
+		"cycles",
+		"instructions",
+		"LLC misses",
+		"branch misses"
+};
+
+// opens a counter of the calling thread (user space only)
+int openPerfEvent(const gerbil::uint64 &config, const int &groupFd) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+}
+
+bool gerbil::PerfCounters::__enabled = false;
+
+gerbil::PerfCounters::PerfCounters() : _slotsNumber(0), _startEnabled(0), _startRunning(0) {
+	for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i) {
+		_fds[i] = -1;
+		_slots[i] = PERF_EVENTS_NUMBER;
+		_start[i] = 0;
+	}
+	if(!__enabled)
+		return;
+	for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i) {
+		_fds[i] = openPerfEvent(__perfEventConfigs[i], i ? _fds[0] : -1);
+		if(_fds[i] >= 0)
+			_slots[i] = _slotsNumber++;
+		else if(!i)
+			return;             // no group leader
+	}
+}
+
+gerbil::PerfCounters::~PerfCounters() {
+	for(uint i = PERF_EVENTS_NUMBER; i--;)
+		if(_fds[i] >= 0)
+			close(_fds[i]);
+}
+
+bool gerbil::PerfCounters::read(uint64* values, uint64 &enabled, uint64 &running) {
+	// nr, time enabled, time running, values
+	uint64 buffer[3 + PERF_EVENTS_NUMBER];
+	const ssize_t size = (3 + _slotsNumber) * sizeof(uint64);
+	if(::read(_fds[0], buffer, size) != size)
+		return false;
+	enabled = buffer[1];
+	running = buffer[2];
+	for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i)
+		values[i] = _slots[i] < PERF_EVENTS_NUMBER ? buffer[3 + _slots[i]] : 0;
+	return true;
+}
+
+void gerbil::PerfCounters::start() {
+	if(isOpen() && !read(_start, _startEnabled, _startRunning)) {
+		close(_fds[0]);
+		_fds[0] = -1;
+	}
+}
+
+void gerbil::PerfCounters::stop(PerfStat &stat) {
+	uint64 values[PERF_EVENTS_NUMBER];
+	uint64 enabled, running;
+	if(!isOpen() || !read(values, enabled, running))
+		return;
+	// the group shared the pmu with other events (multiplexing) --> scale
+	const uint64 dEnabled = enabled - _startEnabled;
+	const uint64 dRunning = running - _startRunning;
+	const double scale = dRunning && dRunning < dEnabled ? (double) dEnabled / dRunning : 1.0;
+	for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i)
+		stat.values[i] += (uint64) ((values[i] - _start[i]) * scale);
+	++stat.sections;
+}
+
+void gerbil::PerfCounters::setEnabled(const bool &enabled) {
+	__enabled = enabled;
+}
+
+bool gerbil::PerfCounters::isEnabled() {
+	return __enabled;
+}
+
+bool gerbil::PerfCounters::isSupported() {
+	const int fd = openPerfEvent(__perfEventConfigs[0], -1);
+	if(fd < 0)
+		return false;
+	close(fd);
+	return true;
+}
+
+const char* gerbil::PerfCounters::getEventName(const uint &event) {
+	return __perfEventNames[event];
+}
+
+void gerbil::PerfRegion::add(const uint32 &threadId, const PerfStat &stat) {
+	std::unique_lock<std::mutex> lock(_mtx);
+	if(_threads.size() <= threadId)
+		_threads.resize(threadId + 1);
+	_threads[threadId] += stat;
+}
+
+void gerbil::PerfRegion::add(PerfRegion &region) {
+	std::unique_lock<std::mutex> lock(region._mtx);
+	for(uint32 threadId = 0; threadId < region._threads.size(); ++threadId)
+		add(threadId, region._threads[threadId]);
+}
+
+bool gerbil::PerfRegion::isEmpty() {
+	std::unique_lock<std::mutex> lock(_mtx);
+	for(const PerfStat &stat : _threads)
+		if(stat.sections)
+			return false;
+	return true;
+}
+
+void gerbil::PerfRegion::print(const char* name, const char* elementName, const uint64 &elementsNumber) {
+	std::unique_lock<std::mutex> lock(_mtx);
+	PerfStat total;
+	for(const PerfStat &stat : _threads)
+		total += stat;
+	printf("perf %-18s: %12lu sections\n", name, total.sections);
+	for(uint i = 0; i < PERF_EVENTS_NUMBER; ++i)
+		printf("  %-21s: %15lu   %10.3f / %s\n", PerfCounters::getEventName(i), total.values[i],
+		       elementsNumber ? (double) total.values[i] / elementsNumber : 0.0, elementName);
+	printf("  %-21s: %15.3f\n", "IPC", total.values[0] ? (double) total.values[1] / total.values[0] : 0.0);
+	for(uint32 threadId = 0; threadId < _threads.size(); ++threadId) {
+		const PerfStat &stat = _threads[threadId];
+		printf("  thread %2u            : %15lu cycles   IPC %6.3f   %12lu LLC misses   %12lu branch misses\n",
+		       threadId, stat.values[0], stat.values[0] ? (double) stat.values[1] / stat.values[0] : 0.0,
+		       stat.values[2], stat.values[3]);
+	}
+}
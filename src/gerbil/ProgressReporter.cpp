@@ -0,0 +1,129 @@
+/*
+ * ProgressReporter.cpp
+ */
+
+#include "../../include/gerbil/ProgressReporter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+double now_s() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+gerbil::ProgressReporter::ProgressReporter() :
+		_interval_ms(PROGRESS_INTERVAL_MS), _thread(NULL), _stop(false), _start_s(0), _stepStart_s(0),
+		_lastReport_s(0), _lastChange_s(0), _lastDone(0), _rate(0) {
+}
+
+gerbil::ProgressReporter::~ProgressReporter() {
+	stop();
+}
+
+void gerbil::ProgressReporter::report(const bool &final) {
+	if(_step.empty())
+		return;
+	uint64 done = 0, total = 0;
+	_progress(done, total);
+	const double time_s = now_s();
+
+	// smoothed rate, the first report of a step uses the average
+	if(_lastReport_s <= _stepStart_s)
+		_rate = time_s > _stepStart_s ? done / (time_s - _stepStart_s) : 0;
+	else if(time_s > _lastReport_s)
+		_rate = 0.7 * _rate + 0.3 * (done - _lastDone) / (time_s - _lastReport_s);
+	if(done != _lastDone || _lastChange_s < _stepStart_s)
+		_lastChange_s = time_s;
+	_lastDone = done;
+	_lastReport_s = time_s;
+
+	const double percent = total ? 100.0 * done / total : 0;
+	const double eta_s = total && done >= total ? 0 : (total && _rate > 0 ? (total - done) / _rate : -1);
+
+	if(_fileName == "-") {
+		fprintf(stderr, "progress step %s: %12lu / %12lu %s (%5.1f %%)  %12.0f %s/s  ETA %s",
+				_step.c_str(), done, total, _unit.c_str(), percent, _rate, _unit.c_str(),
+				eta_s < 0 ? "?" : "");
+		if(eta_s >= 0)
+			fprintf(stderr, "%.0f s", eta_s);
+		fprintf(stderr, "%s\n", final ? "  (done)" : "");
+		return;
+	}
+
+	// replace the status file atomically
+	const std::string tmpFileName = _fileName + ".tmp";
+	FILE* file = fopen(tmpFileName.c_str(), "w");
+	if(!file)
+		return;
+	fprintf(file, "{\"state\": \"%s\", \"step\": \"%s\", \"unit\": \"%s\", \"done\": %lu, \"total\": %lu, "
+			"\"percent\": %.2f, \"rate_per_s\": %.1f, \"eta_s\": %.1f, \"elapsed_s\": %.3f, "
+			"\"step_elapsed_s\": %.3f, \"stalled_s\": %.3f, \"time\": %lu}\n",
+			final ? "done" : "running", _step.c_str(), _unit.c_str(), done, total,
+			percent, _rate, eta_s, time_s - _start_s,
+			time_s - _stepStart_s, time_s - _lastChange_s, (uint64) time(NULL));
+	if(!fclose(file))
+		rename(tmpFileName.c_str(), _fileName.c_str());
+}
+
+bool gerbil::ProgressReporter::start(const std::string &fileName, const uint32 &interval_ms) {
+	stop();
+	if(fileName != "-") {
+		FILE* file = fopen(fileName.c_str(), "w");
+		if(!file)
+			return false;
+		fclose(file);
+	}
+	std::unique_lock<std::mutex> lock(_mtx);
+	_fileName = fileName;
+	_interval_ms = interval_ms ? interval_ms : PROGRESS_INTERVAL_MS;
+	_start_s = now_s();
+	_step.clear();
+	_stop = false;
+	_thread = new std::thread([this] {
+		std::unique_lock<std::mutex> lock(_mtx);
+		while(!_stop) {
+			_cv.wait_for(lock, std::chrono::milliseconds(_interval_ms));
+			if(!_stop)
+				report(false);
+		}
+	});
+	return true;
+}
+
+void gerbil::ProgressReporter::stop() {
+	if(!_thread)
+		return;
+	{
+		std::unique_lock<std::mutex> lock(_mtx);
+		_stop = true;
+	}
+	_cv.notify_all();
+	_thread->join();
+	delete _thread;
+	_thread = NULL;
+	finishStep();
+}
+
+void gerbil::ProgressReporter::setStep(const std::string &step, const std::string &unit, TProgress progress) {
+	if(!_thread)
+		return;
+	std::unique_lock<std::mutex> lock(_mtx);
+	_step = step;
+	_unit = unit;
+	_progress = progress;
+	_stepStart_s = _lastReport_s = _lastChange_s = now_s();
+	_lastDone = 0;
+	_rate = 0;
+}
+
+void gerbil::ProgressReporter::finishStep() {
+	std::unique_lock<std::mutex> lock(_mtx);
+	report(true);
+	_step.clear();
+	_progress = TProgress();
+}
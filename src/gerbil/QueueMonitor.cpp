@@ -0,0 +1,112 @@
+/*
+ * QueueMonitor.cpp
+ */
+
+#include "../../include/gerbil/QueueMonitor.h"
+#include "../../include/gerbil/SyncQueue.h"
+
+#include <list>
+
+namespace {
+
+struct MonitorEntry {
+	gerbil::MonitoredQueue *queue;
+	std::string name;
+	gerbil::uint32 id;
+	gerbil::uint64 pushWait_ns;     // values of the previous sample
+	gerbil::uint64 popWait_ns;
+};
+
+std::mutex __mtx;
+std::condition_variable __cv;
+std::list<MonitorEntry> __entries;
+std::thread *__sampler = NULL;
+FILE *__file = NULL;
+bool __enabled = false;
+bool __stop = false;
+gerbil::uint64 __start_ns = 0;
+
+// requires lock
+void sampleEntry(MonitorEntry &entry, const gerbil::uint64 &time_ns) {
+	gerbil::QueueSample sample;
+	entry.queue->sample(sample);
+	fprintf(__file, "%.3f,%s,%u,%lu,%lu,%u,%u,%lu,%lu\n", (double) (time_ns - __start_ns) / 1e6,
+	        entry.name.c_str(), entry.id, sample.fill, sample.capacity,
+	        sample.pushWaiting, sample.popWaiting,
+	        sample.stat.pushWait_ns - entry.pushWait_ns, sample.stat.popWait_ns - entry.popWait_ns);
+	entry.pushWait_ns = sample.stat.pushWait_ns;
+	entry.popWait_ns = sample.stat.popWait_ns;
+}
+
+// requires lock
+void sampleAll() {
+	const gerbil::uint64 time_ns = gerbil::SyncQueueStat::now_ns();
+	for (MonitorEntry &entry : __entries)
+		sampleEntry(entry, time_ns);
+}
+
+}
+
+bool gerbil::QueueMonitor::start(const std::string &fileName, const uint32 &interval_ms) {
+	stop();
+	std::unique_lock<std::mutex> lock(__mtx);
+	__file = fopen(fileName.c_str(), "w");
+	if (!__file)
+		return false;
+	fprintf(__file, "time_ms,queue,id,fill,capacity,waitingProducers,waitingConsumers,pushWait_ns,popWait_ns\n");
+	__start_ns = SyncQueueStat::now_ns();
+	__stop = false;
+	__enabled = true;
+	__sampler = new std::thread([interval_ms] {
+		std::unique_lock<std::mutex> lock(__mtx);
+		while (!__stop) {
+			__cv.wait_for(lock, std::chrono::milliseconds(interval_ms));
+			if (!__stop)
+				sampleAll();
+		}
+	});
+	return true;
+}
+
+void gerbil::QueueMonitor::stop() {
+	{
+		std::unique_lock<std::mutex> lock(__mtx);
+		if (!__enabled)
+			return;
+		__stop = true;
+	}
+	__cv.notify_all();
+	__sampler->join();
+	delete __sampler;
+	__sampler = NULL;
+
+	std::unique_lock<std::mutex> lock(__mtx);
+	sampleAll();
+	__entries.clear();
+	fclose(__file);
+	__file = NULL;
+	__enabled = false;
+}
+
+bool gerbil::QueueMonitor::isEnabled() {
+	std::unique_lock<std::mutex> lock(__mtx);
+	return __enabled;
+}
+
+void gerbil::QueueMonitor::add(MonitoredQueue *queue, const std::string &name, const uint32 &id) {
+	std::unique_lock<std::mutex> lock(__mtx);
+	if (!__enabled)
+		return;
+	MonitorEntry entry = {queue, name, id, 0, 0};
+	__entries.push_back(entry);
+}
+
+void gerbil::QueueMonitor::remove(MonitoredQueue *queue) {
+	std::unique_lock<std::mutex> lock(__mtx);
+	for (std::list<MonitorEntry>::iterator it = __entries.begin(); it != __entries.end(); ++it)
+		if (it->queue == queue) {
+			sampleEntry(*it, SyncQueueStat::now_ns());
+			__entries.erase(it);
+			return;
+		}
+}
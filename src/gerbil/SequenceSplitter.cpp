@@ -25,8 +25,10 @@ gerbil::SequenceSplitter::SequenceSplitter(
 	_readBundleSyncQueue(readBundleSyncQueue), _leftSuperBundles(NULL), _baseNumbers(0)
 {
 	_superBundleQueues = new SyncSwapQueueMPSC<SuperBundle>*[SB_WRITER_THREADS_NUMBER];
-		for(uint i = 0; i < SB_WRITER_THREADS_NUMBER; ++i)
+		for(uint i = 0; i < SB_WRITER_THREADS_NUMBER; ++i) {
 			_superBundleQueues[i] = new SyncSwapQueueMPSC<SuperBundle>(superBundlesNumber / SB_WRITER_THREADS_NUMBER);
+			_superBundleQueues[i]->monitor("superBundleQueue", i);
+		}
 
 	_splitterThreads = new std::thread*[_splitterThreadCount];
 
@@ -34,6 +36,10 @@ gerbil::SequenceSplitter::SequenceSplitter(
 
 	_mVal = new uint32[mMerNumber];
 	_mToBin = new uint_tfn[mMerNumber];
+
+	_binSuperBundles = new uint64[_tempFilesNumber]();
+	_binSMers = new uint64[_tempFilesNumber]();
+	_binKMers = new uint64[_tempFilesNumber]();
 }
 
 gerbil::SequenceSplitter::~SequenceSplitter() {
@@ -43,6 +49,9 @@ gerbil::SequenceSplitter::~SequenceSplitter() {
 	delete[] _splitterThreads;
 	delete[] _mVal;
 	delete[] _mToBin;
+	delete[] _binSuperBundles;
+	delete[] _binSMers;
+	delete[] _binKMers;
 }
 
 
@@ -132,6 +141,16 @@ void gerbil::SequenceSplitter::process() {
 		}, i);
 }
 
+/*
+ * stores a merged SuperBundle in the queue
+ */
+#define SS_PUSH_LEFT_SUPERBUNDLE {																			\
+	++_binSuperBundles[tempFileId];																				\
+	_binSMers[tempFileId] += lastSuperBundle->sMerNumber;														\
+	_binKMers[tempFileId] += lastSuperBundle->kMerNumber;														\
+	_superBundleQueues[tempFileId % SB_WRITER_THREADS_NUMBER]->swapPush(lastSuperBundle);						\
+}
+
 void gerbil::SequenceSplitter::join() {
 	for(uint i = 0; i < _splitterThreadCount; ++i) {
 		_splitterThreads[i]->join();
@@ -153,14 +172,14 @@ void gerbil::SequenceSplitter::join() {
 				// store at fail
 				lastSuperBundle->finalize();
 				if(!lastSuperBundle->isEmpty())
-					_superBundleQueues[tempFileId % SB_WRITER_THREADS_NUMBER]->swapPush(lastSuperBundle);
+					SS_PUSH_LEFT_SUPERBUNDLE;
 				std::swap(lastSuperBundle, _leftSuperBundles[tempFileId][tId]);
 			}
 		}
 		// store last superbundle
 		lastSuperBundle->finalize();
 		if(!lastSuperBundle->isEmpty())
-			_superBundleQueues[tempFileId % SB_WRITER_THREADS_NUMBER]->swapPush(lastSuperBundle);
+			SS_PUSH_LEFT_SUPERBUNDLE;
 	}
 
 	// finalize all queues
@@ -176,8 +195,33 @@ void gerbil::SequenceSplitter::join() {
 	delete[] _leftSuperBundles;
 }
 
+void gerbil::SequenceSplitter::getBinStat(const uint_tfn &tempFileId, uint64 &superBundles, uint64 &sMers, uint64 &kMers) const {
+	superBundles = _binSuperBundles[tempFileId];
+	sMers = _binSMers[tempFileId];
+	kMers = _binKMers[tempFileId];
+}
+
 void gerbil::SequenceSplitter::print() {
 	printf("number of bases        : %12lu\n", _baseNumbers.load());
+	if(!_perfScan.isEmpty()) {
+		uint64 kMersNumber = 0;
+		for(uint_tfn tempFileId(0); tempFileId < _tempFilesNumber; ++tempFileId)
+			kMersNumber += _binKMers[tempFileId];
+		_perfScan.print("splitter", "k-mer", kMersNumber);
+	}
+}
+
+void gerbil::SequenceSplitter::report(TelemetryStage &stage) {
+	stage.add("splitter.bases", _baseNumbers.load());
+	for(uint_tfn tempFileId(0); tempFileId < _tempFilesNumber; ++tempFileId) {
+		stage.add("splitter.superBundles", _binSuperBundles[tempFileId]);
+		stage.add("splitter.sMers", _binSMers[tempFileId]);
+		stage.add("splitter.kMers", _binKMers[tempFileId]);
+	}
+	SyncQueueStat queueStat;
+	for(uint i = 0; i < SB_WRITER_THREADS_NUMBER; ++i)
+		queueStat += _superBundleQueues[i]->getStat();
+	stage.addQueue("superBundleQueue", queueStat);
 }
 
 //private
@@ -190,6 +234,9 @@ void gerbil::SequenceSplitter::print() {
 	curTempFileId = bins[min_val_pos];																				\
 	if(!curSuperBundles[curTempFileId]->add(rb->data + i - smer_c - _k + 1, smer_c + _k - 1, _k)) {					\
 		curSuperBundles[curTempFileId]->finalize();																	\
+		++binSuperBundles[curTempFileId];																			\
+		binSMers[curTempFileId] += curSuperBundles[curTempFileId]->sMerNumber;										\
+		binKMers[curTempFileId] += curSuperBundles[curTempFileId]->kMerNumber;										\
 		IF_MESS_SEQUENCESPLITTER(sw.hold();)																		\
 		_superBundleQueues[curTempFileId % SB_WRITER_THREADS_NUMBER]->swapPush(curSuperBundles[curTempFileId]);		\
 		IF_MESS_SEQUENCESPLITTER(sw.proceed();)																		\
@@ -262,8 +309,15 @@ void gerbil::SequenceSplitter::processThread(const uint &id) {
 		curSuperBundles[i] = new SuperBundle();
 		curSuperBundles[i]->tempFileId = i;
 	}
+	uint64* binSuperBundles = new uint64[_tempFilesNumber]();
+	uint64* binSMers = new uint64[_tempFilesNumber]();
+	uint64* binKMers = new uint64[_tempFilesNumber]();
+
+	PerfCounters perfCounters;
+	PerfStat perfStat;
 
 	while(_readBundleSyncQueue->swapPop(rb)) {
+		perfCounters.start();
 #ifdef DEB_SS_LOG_RB
 		rb->print();
 #endif
@@ -373,19 +427,29 @@ void gerbil::SequenceSplitter::processThread(const uint &id) {
 				++smer_c;
 			}
 		}
+		perfCounters.stop(perfStat);
 		rb->clear();
 	}
 
 	_baseNumbers += baseNumbers;
+	if(perfCounters.isOpen())
+		_perfScan.add(id, perfStat);
 
-	for(uint_tfn i = 0; i < _tempFilesNumber; ++i)
+	for(uint_tfn i = 0; i < _tempFilesNumber; ++i) {
 		_leftSuperBundles[i][id] = curSuperBundles[i];
+		__sync_add_and_fetch(_binSuperBundles + i, binSuperBundles[i]);
+		__sync_add_and_fetch(_binSMers + i, binSMers[i]);
+		__sync_add_and_fetch(_binKMers + i, binKMers[i]);
+	}
 
 	// free memory
 	delete rb;
 	delete[] bins;
 	delete[] mmerval;
 	delete[] curSuperBundles;
+	delete[] binSuperBundles;
+	delete[] binSMers;
+	delete[] binKMers;
 
 
 	IF_MESS_SEQUENCESPLITTER(
@@ -12,11 +12,12 @@ gerbil::SuperReader::SuperReader(
 		TempFile *tempFiles,
 		const uint_tfn &tempFilesNumber,
 		KmerDistributer *distributor
-) : _syncSwapQueue(superBundlesNumber), _distributor(distributor) {
+) : _syncSwapQueue(superBundlesNumber), _distributor(distributor), _superBundlesNumber(0), _multiRunBinsNumber(0) {
 	_tempFiles = tempFiles;
 	_tempFilesNumber = tempFilesNumber;
 	_processThread = NULL;
 	_tempFilesOrder = new uint_tfn[_tempFilesNumber];
+	_syncSwapQueue.monitor("superReaderQueue");
 }
 
 gerbil::SuperReader::~SuperReader() {
@@ -64,12 +65,17 @@ void gerbil::SuperReader::processThread() {
 			else
 				_tempFiles[tempFileId].calcNumberOfRuns(ukmerRatio, (uint64_t) (_distributor->getTotalCapacity() * FILL_MAX));
 			//std::printf("runs[%3u]: %6u\n", tempFileId, _tempFiles[tempFileId].getNumberOfRuns());
+			if(_tempFiles[tempFileId].getNumberOfRuns() > 1)
+				++_multiRunBinsNumber;
+			// the bin may still be written by step1
+			_tempFiles[tempFileId].waitUntilComplete();
 			for(uint tempRun = 0; tempRun < _tempFiles[tempFileId].getNumberOfRuns(); ++tempRun) {
 				_tempFiles[tempFileId].openR();
 				//std::cout << "fid: " << tempFileId << "  runId: " << tempRun << std::endl;
 				while (_tempFiles[tempFileId].read(sb)) {
 					sb->tempFileId = tempFileId;
 					sb->tempFileRun = tempRun;
+					++_superBundlesNumber;
 					IF_MESS_SUPERREADER(sw.hold();)
 					_syncSwapQueue.swapPush(sb);
 					IF_MESS_SUPERREADER(sw.proceed();)
@@ -111,3 +117,10 @@ void gerbil::SuperReader::join() {
 gerbil::SyncSwapQueueSPMC<gerbil::SuperBundle> *gerbil::SuperReader::getSuperBundleQueue() {
 	return &_syncSwapQueue;
 }
+
+void gerbil::SuperReader::report(TelemetryStage &stage) {
+	stage.add("superReader.superBundles", _superBundlesNumber);
+	stage.add("superReader.bytes", _superBundlesNumber * SUPER_BUNDLE_DATA_SIZE_B);
+	stage.add("superReader.multiRunBins", _multiRunBinsNumber);
+	stage.addQueue("superBundleQueue", _syncSwapQueue.getStat());
+}
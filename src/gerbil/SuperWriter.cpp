@@ -9,7 +9,8 @@
 
 gerbil::SuperWriter::SuperWriter(std::string pTempFolder,
 		SyncSwapQueueMPSC<SuperBundle>** superBundleQueues,
-		const uint_tfn &tempFilesNumber, const uint64 &maxBufferSize) :
+		const uint_tfn &tempFilesNumber, const uint64 &maxBufferSize,
+		const bool inMemory, const bool pipelined) :
 		_superBundleQueues(superBundleQueues), _tempFilesNumber(
 				tempFilesNumber), _maxBufferSize(maxBufferSize), _processThreads(
 		NULL), _superBundlesNumber(0), _tempFilesFilledSize(0), _sMersNumber(0), _kMersNumber(
@@ -20,11 +21,13 @@ gerbil::SuperWriter::SuperWriter(std::string pTempFolder,
 	for (uint_tfn tempFileId = 0; tempFileId < _tempFilesNumber; ++tempFileId) {
 		tempPathName = pTempFolder + "temp" + std::to_string(tempFileId)
 				+ ".bin";
-		if (!_tempFiles[tempFileId].openW(tempPathName)) {
+		if (!(inMemory ? _tempFiles[tempFileId].openM(tempPathName) : _tempFiles[tempFileId].openW(tempPathName))) {
 			std::cerr << "unable to create temp File '" << tempPathName << "'"
 					<< std::endl;
 			exit(1);
 		}
+		if (pipelined)
+			_tempFiles[tempFileId].setPipelined();
 	}
 
 	_processThreads = new std::thread*[SB_WRITER_THREADS_NUMBER];
@@ -331,9 +334,9 @@ void gerbil::SuperWriter::process() {
 						//printf(">>>>>%5.2f\n", (double)s / n);
 
 						IF_DEB(printf("close files\n"));
-						// close all temp files
+						// close all temp files (pipelined bins are closed as soon as they are complete)
 						for(uint_tfn tempFileId(0); tempFileId < _tempFilesNumber; ++tempFileId)
-						if(tempFileId % SB_WRITER_THREADS_NUMBER == tId)
+						if(tempFileId % SB_WRITER_THREADS_NUMBER == tId && !_tempFiles[tempFileId].isPipelined())
 						_tempFiles[tempFileId].close();
 						IF_MESS_SUPERWRITER(
 								sw.stop();
@@ -363,5 +366,24 @@ void gerbil::SuperWriter::print() {
 					* 100);
 	printf("number of s-mers       : %12lu\n", _sMersNumber);
 	printf("number of k-mers       : %12lu\n", _kMersNumber);
+	uint_tfn inMemoryNumber = 0;
+	for (uint_tfn tempFileId = 0; tempFileId < _tempFilesNumber; ++tempFileId)
+		if (_tempFiles[tempFileId].isInMemory())
+			++inMemoryNumber;
+	printf("bins in memory         : %12lu (% 12.3f MB)\n", inMemoryNumber, (double) TempFile::getMemoryUsage() / 1024 / 1024);
+}
+
+void gerbil::SuperWriter::report(TelemetryStage &stage) {
+	stage.add("superWriter.superBundles", _superBundlesNumber);
+	stage.add("superWriter.bytes", _superBundlesNumber * SUPER_BUNDLE_DATA_SIZE_B);
+	stage.add("superWriter.filledBytes", _tempFilesFilledSize);
+	stage.add("superWriter.sMers", _sMersNumber);
+	stage.add("superWriter.kMers", _kMersNumber);
+	uint64 inMemoryNumber = 0;
+	for (uint_tfn tempFileId = 0; tempFileId < _tempFilesNumber; ++tempFileId)
+		if (_tempFiles[tempFileId].isInMemory())
+			++inMemoryNumber;
+	stage.add("superWriter.binsInMemory", inMemoryNumber);
+	stage.add("superWriter.memoryPeakBytes", TempFile::getMemoryPeak());
 }
 
@@ -0,0 +1,122 @@
+/*
+ * Telemetry.cpp
+ */
+
+#include "../../include/gerbil/Telemetry.h"
+
+// writes a string as JSON string (names are plain identifiers, paths may contain special chars)
+static void fprintJsonString(FILE *file, const std::string &s) {
+	fputc('"', file);
+	for (const char c : s) {
+		if (c == '"' || c == '\\')
+			fprintf(file, "\\%c", c);
+		else if ((unsigned char) c < 0x20)
+			fprintf(file, "\\u%04x", c);
+		else
+			fputc(c, file);
+	}
+	fputc('"', file);
+}
+
+void gerbil::TelemetryStage::add(const std::string &name, const uint64 &value) {
+	for (auto &counter : _counters)
+		if (counter.first == name) {
+			counter.second += value;
+			return;
+		}
+	_counters.push_back(std::make_pair(name, value));
+}
+
+void gerbil::TelemetryStage::set(const std::string &name, const double &value) {
+	for (auto &v : _values)
+		if (v.first == name) {
+			v.second = value;
+			return;
+		}
+	_values.push_back(std::make_pair(name, value));
+}
+
+void gerbil::TelemetryStage::addQueue(const std::string &name, const SyncQueueStat &stat) {
+	add(name + ".pushWaits", stat.pushWaits);
+	add(name + ".pushWait_ns", stat.pushWait_ns);
+	add(name + ".popWaits", stat.popWaits);
+	add(name + ".popWait_ns", stat.popWait_ns);
+}
+
+gerbil::uint64 gerbil::TelemetryStage::getCounter(const std::string &name) const {
+	for (const auto &counter : _counters)
+		if (counter.first == name)
+			return counter.second;
+	return 0;
+}
+
+double gerbil::TelemetryStage::getValue(const std::string &name) const {
+	for (const auto &value : _values)
+		if (value.first == name)
+			return value.second;
+	return 0;
+}
+
+void gerbil::TelemetryStage::fprintJson(FILE *file) const {
+	fprintf(file, "    {\n      \"name\": ");
+	fprintJsonString(file, _name);
+	fprintf(file, ",\n      \"counters\": {");
+	for (size_t i = 0; i < _counters.size(); ++i) {
+		fprintf(file, "%s\n        ", i ? "," : "");
+		fprintJsonString(file, _counters[i].first);
+		fprintf(file, ": %lu", _counters[i].second);
+	}
+	fprintf(file, "\n      },\n      \"values\": {");
+	for (size_t i = 0; i < _values.size(); ++i) {
+		fprintf(file, "%s\n        ", i ? "," : "");
+		fprintJsonString(file, _values[i].first);
+		fprintf(file, ": %.6f", _values[i].second);
+	}
+	fprintf(file, "\n      }\n    }");
+}
+
+void gerbil::Telemetry::setParam(const std::string &name, const std::string &value) {
+	for (auto &param : _params)
+		if (param.first == name) {
+			param.second = value;
+			return;
+		}
+	_params.push_back(std::make_pair(name, value));
+}
+
+void gerbil::Telemetry::setParam(const std::string &name, const uint64 &value) {
+	setParam(name, std::to_string(value));
+}
+
+gerbil::TelemetryStage &gerbil::Telemetry::getStage(const std::string &name) {
+	for (auto &stage : _stages)
+		if (stage.getName() == name)
+			return stage;
+	_stages.push_back(TelemetryStage(name));
+	return _stages.back();
+}
+
+void gerbil::Telemetry::clear() {
+	_params.clear();
+	_stages.clear();
+}
+
+bool gerbil::Telemetry::saveJson(const std::string &fileName) const {
+	FILE *file = fopen(fileName.c_str(), "w");
+	if (!file)
+		return false;
+	fprintf(file, "{\n  \"params\": {");
+	for (size_t i = 0; i < _params.size(); ++i) {
+		fprintf(file, "%s\n    ", i ? "," : "");
+		fprintJsonString(file, _params[i].first);
+		fprintf(file, ": ");
+		fprintJsonString(file, _params[i].second);
+	}
+	fprintf(file, "\n  },\n  \"stages\": [");
+	for (size_t i = 0; i < _stages.size(); ++i) {
+		fprintf(file, "%s\n", i ? "," : "");
+		_stages[i].fprintJson(file);
+	}
+	fprintf(file, "\n  ]\n}\n");
+	return fclose(file) == 0;
+}
@@ -7,25 +7,110 @@
 
 #include "../../include/gerbil/TempFile.h"
 #include <errno.h>
+#include <cstring>
 
 using namespace std;
 
 gerbil::uint_tfn gerbil::TempFile::__nextId = 0;
+std::atomic<gerbil::uint64> gerbil::TempFile::__memoryUsage(0);
+gerbil::uint64 gerbil::TempFile::__memoryLimit = 0;
+std::atomic<gerbil::uint64> gerbil::TempFile::__memoryPeak(0);
 
-gerbil::TempFile::TempFile()
-		: _size(0),
+gerbil::TempFile::TempFile() : TempFile(__nextId++) {
+}
+
+gerbil::TempFile::TempFile(const uint_tfn &id)
+		: _id(id),
+		  _size(0),
 		  _file(NULL),
 		  _filled(0),
 		  _kmers(0),
 		  _smers(0),
 		  _ukmers(0),
 		  _filename(""),
-		  _numberOfRuns(0) {
-	_id = __nextId++;
+		  _numberOfRuns(0),
+		  _inMemory(false),
+		  _blockSize(0),
+		  _blockFilled(0),
+		  _memorySize(0),
+		  _readBlock(0),
+		  _readOffset(0),
+		  _pipelined(false),
+		  _announced(false),
+		  _complete(false),
+		  _writtenNumber(0),
+		  _expectedNumber(0) {
 }
 
 gerbil::TempFile::~TempFile() {
+	freeMemory();
+}
 
+// keep in memory (write mode)
+bool gerbil::TempFile::openM(const std::string filename) {
+	_filename = filename;
+	// remove old Files
+	std::remove(_filename.c_str());
+	_inMemory = true;
+	return true;
+}
+
+bool gerbil::TempFile::writeM(const byte *data, const uint32 &size) {
+	// each entry is followed by a terminating size of 0
+	const uint64 entrySize = sizeof(uint32) + size;
+	if (_blocks.empty() || _blockFilled + entrySize + sizeof(uint32) > _blockSize) {
+		// blocks grow with the bin
+		uint64 blockSize = std::max(_blockSize * 2, (uint64) TEMPFILE_MEMORY_BLOCK_MIN_SIZE_B);
+		if (blockSize > TEMPFILE_MEMORY_BLOCK_MAX_SIZE_B)
+			blockSize = TEMPFILE_MEMORY_BLOCK_MAX_SIZE_B;
+		const uint64 memoryUsage = __memoryUsage += blockSize;
+		if (memoryUsage > __memoryLimit || !MemoryTracker::tryAcquire(mc_bins, blockSize)) {
+			__memoryUsage -= blockSize;
+			return false;
+		}
+		uint64 memoryPeak = __memoryPeak.load(std::memory_order_relaxed);
+		while (memoryUsage > memoryPeak && !__memoryPeak.compare_exchange_weak(memoryPeak, memoryUsage,
+				std::memory_order_relaxed));
+		_blocks.push_back(new byte[blockSize]);
+		_blockSize = blockSize;
+		_blockFilled = 0;
+		_memorySize += blockSize;
+	}
+	byte *p = _blocks.back() + _blockFilled;
+	*((uint32 *) p) = size;
+	memcpy(p + sizeof(uint32), data, size);
+	_blockFilled += entrySize;
+	*((uint32 *) (p + entrySize)) = 0;
+	return true;
+}
+
+bool gerbil::TempFile::spill() {
+	_file = fopen(_filename.c_str(), "wb");
+	if (!_file) {
+		perror(_filename.c_str());
+		return false;
+	}
+	setbuf(_file, NULL);
+	SuperBundle *sb = new SuperBundle;
+	bool success = true;
+	openR();
+	while (success && read(sb))
+		success = fwrite((char *) sb->data, 1, SUPER_BUNDLE_DATA_SIZE_B, _file) == SUPER_BUNDLE_DATA_SIZE_B;
+	delete sb;
+	freeMemory();
+	_inMemory = false;
+	return success;
+}
+
+void gerbil::TempFile::freeMemory() {
+	for (byte *block : _blocks)
+		delete[] block;
+	_blocks.clear();
+	__memoryUsage -= _memorySize;
+	MemoryTracker::release(mc_bins, _memorySize);
+	_memorySize = 0;
+	_blockSize = 0;
+	_blockFilled = 0;
 }
 
 // open file (write mode)
@@ -45,6 +130,11 @@ bool gerbil::TempFile::openW(const std::string filename) {
 
 // open file (read mode)
 bool gerbil::TempFile::openR() {
+	if (_inMemory) {
+		_readBlock = 0;
+		_readOffset = 0;
+		return true;
+	}
 	_file = fopen(_filename.c_str(), "rb");
 	if (!_file)
 		return false;
@@ -54,19 +144,62 @@ bool gerbil::TempFile::openR() {
 
 // remove old file
 bool gerbil::TempFile::remove() {
+	freeMemory();
 	return std::remove(_filename.c_str()) != 0;
 }
 
 void gerbil::TempFile::reset() {
-	rewind(_file);
+	if (_inMemory)
+		openR();
+	else
+		rewind(_file);
 }
 
 bool gerbil::TempFile::write(SuperBundle *superBundle) {
-	_size += SUPER_BUNDLE_DATA_SIZE_B;
-	_smers += superBundle->sMerNumber;
-	_kmers += superBundle->kMerNumber;
+	if (!_pipelined) {
+		_size += SUPER_BUNDLE_DATA_SIZE_B;
+		_smers += superBundle->sMerNumber;
+		_kmers += superBundle->kMerNumber;
+	}
 	_filled += superBundle->getSize();
-	return fwrite((char *) superBundle->data, 1, SUPER_BUNDLE_DATA_SIZE_B, _file) == SUPER_BUNDLE_DATA_SIZE_B;
+	bool success;
+	if (_inMemory && writeM(superBundle->data, superBundle->getSize()))
+		success = true;
+	else if (_inMemory && !spill())
+		success = false;
+	else
+		success = fwrite((char *) superBundle->data, 1, SUPER_BUNDLE_DATA_SIZE_B, _file) == SUPER_BUNDLE_DATA_SIZE_B;
+	if (success && _pipelined) {
+		std::lock_guard<std::mutex> lock(_completeMutex);
+		++_writtenNumber;
+		checkComplete();
+	}
+	return success;
+}
+
+void gerbil::TempFile::announce(const uint64 &superBundles, const uint64 &smers, const uint64 &kmers) {
+	std::lock_guard<std::mutex> lock(_completeMutex);
+	_size = superBundles * SUPER_BUNDLE_DATA_SIZE_B;
+	_smers = smers;
+	_kmers = kmers;
+	_expectedNumber = superBundles;
+	_announced = true;
+	checkComplete();
+}
+
+void gerbil::TempFile::checkComplete() {
+	if (!_announced || _complete || _writtenNumber < _expectedNumber)
+		return;
+	close();
+	_complete = true;
+	_completeCV.notify_all();
+}
+
+void gerbil::TempFile::waitUntilComplete() {
+	if (!_pipelined)
+		return;
+	std::unique_lock<std::mutex> lock(_completeMutex);
+	_completeCV.wait(lock, [this] { return _complete; });
 }
 
 bool gerbil::TempFile::write(char *data, const uint64 &size, const uint64 &smers, const uint64 &kmers,
@@ -75,10 +208,34 @@ bool gerbil::TempFile::write(char *data, const uint64 &size, const uint64 &smers
 	_smers += smers;
 	_kmers += kmers;
 	_filled += filled;
+	if (_inMemory) {
+		uint64 i = 0;
+		for (; i < size && writeM((byte *) data + i, SUPER_BUNDLE_DATA_SIZE_B); i += SUPER_BUNDLE_DATA_SIZE_B);
+		if (i >= size)
+			return true;
+		if (!spill())
+			return false;
+		data += i;
+		return fwrite((char *) data, 1, size - i, _file) == size - i;
+	}
 	return fwrite((char *) data, 1, size, _file) == size;
 }
 
 bool gerbil::TempFile::read(SuperBundle *superBundle) {
+	if (_inMemory) {
+		while (_readBlock < _blocks.size()) {
+			const byte *p = _blocks[_readBlock] + _readOffset;
+			const uint32 size = *((uint32 *) p);
+			if (size) {
+				memcpy(superBundle->data, p + sizeof(uint32), size);
+				_readOffset += sizeof(uint32) + size;
+				return true;
+			}
+			++_readBlock;
+			_readOffset = 0;
+		}
+		return false;
+	}
 	return fread(superBundle->data, 1, SUPER_BUNDLE_DATA_SIZE_B, _file) == SUPER_BUNDLE_DATA_SIZE_B;
 }
 
@@ -89,6 +246,7 @@ bool gerbil::TempFile::isEmpty() {
 void gerbil::TempFile::close() {
 	if (_file)
 		fclose(_file);
+	_file = NULL;
 }
 
 void gerbil::TempFile::fprintStat(FILE *file) const {
@@ -6,21 +6,128 @@
 #include <fstream>
 #include <string>
 #include <cstring>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
 // type definitions
 typedef unsigned char byte;
 typedef unsigned int uint32;
+typedef unsigned long uint64;
+
+// minimal size of a chunk which is converted by a single thread
+#define CHUNK_SIZE_B (4 * 1024 * 1024)
+
+// number of chunks per thread which may be converted ahead of the writer
+#define CHUNKS_PER_THREAD 2
 
 // prints some info
 void printHelp() {
-	cout << "\ttoFasta <input> <k> [<output>]" << endl;
+	cout << "\ttoFasta <input> <k> [<output>] [<threads>]" << endl;
+}
+
+// loads the chunk index written by gerbil next to its output (<input>.idx)
+// each entry is the offset of a record boundary; returns false if the index is missing or inconsistent
+bool loadChunkIndex(const string &indexPath, const size_t fileSize, vector<size_t> &bounds) {
+	FILE* indexFile = fopen(indexPath.c_str(), "rb");
+	if(!indexFile)
+		return false;
+	vector<uint64> offsets;
+	uint64 offset;
+	while(fread(&offset, sizeof(uint64), 1, indexFile) == 1)
+		offsets.push_back(offset);
+	fclose(indexFile);
+	if(offsets.empty() || offsets[0] != 0)
+		return false;
+
+	// merge small bundles to chunks
+	bounds.clear();
+	bounds.push_back(0);
+	for(size_t i = 1; i < offsets.size(); ++i) {
+		if(offsets[i] <= offsets[i - 1] || offsets[i] > fileSize)
+			return false;
+		if(offsets[i] - bounds.back() >= CHUNK_SIZE_B)
+			bounds.push_back(offsets[i]);
+	}
+	if(bounds.back() != fileSize)
+		bounds.push_back(fileSize);
+	return true;
+}
+
+// determines record boundaries by skipping over the records (touches one byte per record only)
+void scanChunkBounds(const byte* data, const size_t fileSize, const size_t kMerSize_B, vector<size_t> &bounds) {
+	bounds.clear();
+	bounds.push_back(0);
+	const byte* p = data;
+	const byte* end = data + fileSize;
+	const byte* nextBound = data + CHUNK_SIZE_B;
+	while(p < end) {
+		if(p >= nextBound) {
+			bounds.push_back(p - data);
+			nextBound = p + CHUNK_SIZE_B;
+		}
+		p += (*p >= 255 ? 5 : 1) + kMerSize_B;
+	}
+	bounds.push_back(fileSize);
+}
+
+// converts all records in [p, end) to fasta
+// returns false if the last record exceeds the chunk
+bool convertChunk(const byte* p, const byte* end, const uint32 k, const size_t kMerSize_B,
+		const char (*bases)[4], string &out) {
+	out.clear();
+	// header (at most 12 chars) + k-mer (padded to bytes) + line breaks
+	out.reserve((end - p) / (1 + kMerSize_B) * (kMerSize_B * 4 + 14) + 64);
+
+	vector<char> kmerSeq(kMerSize_B * 4 + 1);
+	char num[16];
+	uint32 counter;
+	while(p < end) {
+		// get counter value (small)
+		counter = (uint32)*(p++);
+		if(counter >= 255) {
+			// large value
+			if(p + 4 > end)
+				return false;
+			memcpy(&counter, p, 4);
+			p += 4;
+		}
+		if(p + kMerSize_B > end)
+			return false;
+
+		// k-mer: convert bytes to string (four bases per byte)
+		for(size_t i = 0; i < kMerSize_B; ++i)
+			memcpy(kmerSeq.data() + 4 * i, bases[p[i]], 4);
+
+		// increase pointer
+		p += kMerSize_B;
+
+		// header
+		char* n = num + sizeof(num);
+		do {
+			*--n = '0' + counter % 10;
+			counter /= 10;
+		} while(counter);
+		out.push_back('>');
+		out.append(n, num + sizeof(num) - n);
+		out.push_back('\n');
+		out.append(kmerSeq.data(), k);
+		out.push_back('\n');
+	}
+	return p == end;
 }
 
 int main(int argc, char** argv) {
 	// check the number or parameters
-	if(argc < 3 || argc > 4) {
+	if(argc < 3 || argc > 5) {
 		printHelp();
 		return 1;
 	}
@@ -28,39 +135,50 @@ int main(int argc, char** argv) {
 	// get the parameters
 	const string inFilePath(argv[1]);
 	const uint32 k = stoi(argv[2]);
-	const string outFilePath(argc == 4 ? argv[3] : "");
+	const string outFilePath(argc >= 4 ? argv[3] : "");
+	uint32 threadsNumber = argc == 5 ? stoi(argv[4]) : thread::hardware_concurrency();
+	if(!threadsNumber)
+		threadsNumber = 1;
 
 	// number of bytes per kmer
 	const size_t kMerSize_B = (k + 3) / 4;
 
-	// convert two bits to a single base
+	// convert a single byte to four bases
 	const char c[4] = {'A', 'C', 'G', 'T'};
-
-	// the k-mer string
-	char kmerSeq[k + 1]; kmerSeq[k] = '\0';
+	char bases[256][4];
+	for(uint32 b = 0; b < 256; ++b)
+		for(uint32 i = 0; i < 4; ++i)
+			bases[b][i] = c[(b >> (2 * (3 - i))) & 0x3];
 
 	// files
-	FILE* inFile  = NULL;
 	FILE* outFile = NULL;
 
 	// open input file
-	inFile = fopen ( inFilePath.c_str(), "rb" );
+	const int inFd = open(inFilePath.c_str(), O_RDONLY);
 
 	// check the successful opening of the file
-	if(!inFile){
+	struct stat inStat;
+	if(inFd < 0 || fstat(inFd, &inStat)){
 		cerr << "ERROR: Opening the input file '" << inFilePath << "' failed" << endl;
 		return 2;
 	}
 
 	// get size of input file
-	fseek(inFile, 0, SEEK_END);
-	const size_t fileSize = ftell(inFile);
-	fseek(inFile, 0, SEEK_SET);
+	const size_t fileSize = inStat.st_size;
 
-	// remaining bytes, which have not been read
-	size_t remainingBytes = fileSize;
+	// map input file
+	const byte* data = NULL;
+	if(fileSize) {
+		void* map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, inFd, 0);
+		if(map == MAP_FAILED) {
+			cerr << "ERROR: An error has occurred while mapping the input file!" << endl;
+			return 3;
+		}
+		madvise(map, fileSize, MADV_SEQUENTIAL);
+		data = (const byte*) map;
+	}
 
-	if(argc == 4) {
+	if(argc >= 4) {
 		// open output file
 		outFile = fopen ( outFilePath.c_str(), "w+" );
 
@@ -70,95 +188,98 @@ int main(int argc, char** argv) {
 			return 23;
 		}
 	}
+	FILE* out = outFile ? outFile : stdout;
+
+	// determine record boundaries
+	vector<size_t> bounds;
+	const bool indexed = loadChunkIndex(inFilePath + ".idx", fileSize, bounds);
+	if(!indexed)
+		scanChunkBounds(data, fileSize, kMerSize_B, bounds);
+	const size_t chunksNumber = bounds.size() - 1;
 
 	// print a summary
-	printf("input file  : '%s' (%lu B)\n", inFilePath.c_str(), fileSize);
-	if(outFile)
+	if(outFile) {
+		printf("input file  : '%s' (%lu B)\n", inFilePath.c_str(), fileSize);
 		printf("output file : '%s'\n", outFilePath.c_str());
-	printf("k           : %u\n", k);
-	printf("start converting to FASTA...\n");
-
-	// minimum number of remaining bytes of the buffer (additionally for overlaps)
-	size_t minRemBufferBytes = kMerSize_B + 4;
-
-	const size_t bufferSize = 32 * 1024;          // size of the buffer
-	size_t bufferOffset     = 0;                  // buffer offset (remaining unused bytes from last turn)
-	byte buffer[bufferSize + minRemBufferBytes];  // buffer
-	size_t curSize;                               // number of currently read bytes
-	size_t i                = 0;                  // progress purpose
+		printf("k           : %u\n", k);
+		printf("threads     : %u\n", threadsNumber);
+		printf("chunks      : %lu (%s)\n", chunksNumber, indexed ? "index" : "scan");
+		printf("start converting to FASTA...\n");
+	}
 
 	// disable console buffering
 	setbuf(stdout, NULL);
 
-	// main loop
-	while(remainingBytes) {
-		// progress
-		if(outFile && !(i++ % 1024))
-			printf("\r%lu B left", remainingBytes);
-
-		// determine number of readable bytes
-		if(remainingBytes > bufferSize) {
-			curSize = bufferSize;
-			remainingBytes -= bufferSize;
-		}
-		else {
-			curSize = remainingBytes;
-			remainingBytes = 0;
-		}
-		// read bytes from file into the buffer
-		if(fread(buffer + bufferOffset, 1, curSize, inFile) != curSize) {
-			cerr << "ERROR: An error has occurred while reading bytes from the input file!" << endl;
-			return 3;
-		}
+	// converted chunks: chunk i is stored in slot i % slotsNumber
+	const size_t slotsNumber = threadsNumber * CHUNKS_PER_THREAD;
+	vector<string> slots(slotsNumber);
+	vector<size_t> slotChunk(slotsNumber, (size_t) -1);    // chunk which is ready in the slot
+	size_t written = 0;                                    // number of written chunks
+	atomic<size_t> nextChunk(0);
+	atomic<bool> failed(false);
+	mutex m;
+	condition_variable cvReady, cvFree;
 
-		// initialize iterator and final pointer
-		const byte* p   = buffer;
-		const byte* end = buffer + curSize + bufferOffset;
-
-		// k-mer counter
-		uint32 counter;
-
-		// loop over buffer
-		while(remainingBytes ? p + minRemBufferBytes <= end : p < end) {
-			// get counter value (small)
-			counter = (uint32)*(p++);
-			if(counter >= 255) {
-				// large value
-				counter = *((uint32*)p);
-				p += 4;
+	// converter threads
+	vector<thread> threads;
+	for(uint32 tId = 0; tId < threadsNumber; ++tId)
+		threads.push_back(thread([&] {
+			string buffer;
+			size_t chunk;
+			while((chunk = nextChunk++) < chunksNumber) {
+				if(!convertChunk(data + bounds[chunk], data + bounds[chunk + 1], k, kMerSize_B, bases, buffer))
+					failed = true;
+				unique_lock<mutex> lock(m);
+				// wait until the writer has released the slot
+				cvFree.wait(lock, [&] { return written + slotsNumber > chunk; });
+				slots[chunk % slotsNumber].swap(buffer);
+				slotChunk[chunk % slotsNumber] = chunk;
+				cvReady.notify_all();
 			}
-			// k-mer: convert bytes to string
-			for(uint i = 0; i < k; ++i)
-				kmerSeq[i] = c[(p[i >> 2] >> (2 * (3 - (i & 0x3)))) & 0x3];
-
-			// increase pointer
-			p += kMerSize_B;
-
-			// print fasta (console/file)
-			if(outFile)
-				fprintf(outFile, ">%u\n%s\n", counter, kmerSeq);
-			else
-				printf(">%u\n%s\n", counter, kmerSeq);
-		}
+		}));
 
-		// carryover (remaining bytes: possibly incomplete k-mers with their counters)
-		if(p < end) {
-			bufferOffset = end - p;
-			// copy bytes to the beginning
-			std::memcpy(buffer, p, bufferOffset);
+	// write chunks in order
+	string buffer;
+	bool writeError = false;
+	for(size_t chunk = 0; chunk < chunksNumber; ++chunk) {
+		{
+			unique_lock<mutex> lock(m);
+			cvReady.wait(lock, [&] { return slotChunk[chunk % slotsNumber] == chunk; });
+			buffer.swap(slots[chunk % slotsNumber]);
+			++written;
+			cvFree.notify_all();
 		}
-		else
-			bufferOffset = 0;
+		if(fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size())
+			writeError = true;
+
+		// progress
+		if(outFile && !(chunk % 16))
+			printf("\r%lu B left", fileSize - bounds[chunk + 1]);
+	}
+	for(auto &t : threads)
+		t.join();
+
+	if(failed) {
+		cerr << "ERROR: The input file is corrupt or does not match k=" << k << "!" << endl;
+		return 3;
+	}
+	if(writeError) {
+		cerr << "ERROR: An error has occurred while writing the output file!" << endl;
+		return 23;
 	}
 
 	// print read/written bytes
-	printf("\rbytes read    : %lu B          \n", fileSize);
-	printf("\rbytes written : %lu B          \n", ftell(outFile));
+	if(outFile) {
+		printf("\rbytes read    : %lu B          \n", fileSize);
+		printf("\rbytes written : %lu B          \n", ftell(outFile));
+	}
 
 	// close files
-	fclose(inFile);
+	if(data)
+		munmap((void*) data, fileSize);
+	close(inFd);
 	if(outFile) fclose(outFile);
 
 	// exit without errors
 	return 0;
-}
\ No newline at end of file
+}
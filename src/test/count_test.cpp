@@ -0,0 +1,103 @@
+/*
+ * count_test.cpp
+ *
+ * counts a fixture of reads with k-mers which occur more than 255 and more than 65535 times
+ * (reads from memory, k-mers passed to a KmcCallbackConsumer) and compares the counts with the
+ * canonical k-mers counted by a std::map; the options of the hash tables are set by arguments:
+ *
+ * count_test <k> <counter-bytes> <quotient-keys> <prefilter>
+ *
+ * exits with 1 if a k-mer is missing, surplus or counted differently
+ */
+
+#include "../../include/gerbil/Application.h"
+
+#include <map>
+#include <random>
+#include <sys/stat.h>
+
+using namespace gerbil;
+
+#define COUNT_TEST_THRESHOLD 2
+
+// random reads of a genome, a read repeated 300 times and long homopolymer reads (about 80000 k-mers each)
+std::vector<std::string> generateReads() {
+	std::mt19937_64 rng(1);
+	std::string genome(50000, 'A');
+	for(char &c : genome)
+		c = "ACGT"[rng() & 0x3];
+	std::vector<std::string> reads;
+	for(uint32 i = 0; i < 2000; ++i)
+		reads.push_back(genome.substr(rng() % (genome.size() - 150), 150));
+	for(uint32 i = 0; i < 300; ++i)
+		reads.push_back(genome.substr(1000, 150));
+	for(uint32 i = 0; i < 8; ++i)
+		reads.push_back(std::string(10000, i & 1 ? 'T' : 'A'));
+	return reads;
+}
+
+// counts of the canonical k-mers (at least COUNT_TEST_THRESHOLD)
+std::map<std::string, uint64> countReads(const std::vector<std::string> &reads, const uint32 &k) {
+	std::map<std::string, uint64> counts;
+	for(const std::string &read : reads)
+		for(uint64 i = 0; i + k <= read.size(); ++i) {
+			const std::string kMer = read.substr(i, k);
+			std::string rc(kMer.rbegin(), kMer.rend());
+			for(char &c : rc)
+				c = c == 'A' ? 'T' : c == 'C' ? 'G' : c == 'G' ? 'C' : 'A';
+			++counts[std::min(kMer, rc)];
+		}
+	for(auto it = counts.begin(); it != counts.end();)
+		it = it->second < COUNT_TEST_THRESHOLD ? counts.erase(it) : ++it;
+	return counts;
+}
+
+int main(int argc, char** argv) {
+	if(argc != 5) {
+		printf("count_test <k> <counter-bytes> <quotient-keys> <prefilter>\n");
+		return 1;
+	}
+	const uint32 k = std::stoul(argv[1]);
+	const uint32 counterSize_B = std::stoul(argv[2]);
+	const bool quotientKeys = std::stoul(argv[3]);
+	const bool prefilter = std::stoul(argv[4]);
+
+	const std::vector<std::string> reads = generateReads();
+	const std::string tempFolder = "count_test_" + std::string(argv[1]) + "_" + argv[2] + argv[3] + argv[4] + "/";
+	mkdir(tempFolder.c_str(), 0755);
+
+	std::map<std::string, uint64> counted;
+	uint64 duplicates = 0;
+	KmcCallbackConsumer consumer(k, [&](const char* kMerSeq, const uint32 &counter) {
+		duplicates += !counted.insert(std::make_pair(std::string(kMerSeq), counter)).second;
+	});
+	MemoryReadSource readSource(reads);
+	Application application(0.002, 0.15, false, 30, k, "", tempFolder, COUNT_TEST_THRESHOLD,
+			tempFolder + "out", true);
+	application.setMemorySize(1024);
+	application.setKmcConsumer(&consumer);
+	application.setReadSource(&readSource);
+	application.setCounterSize(counterSize_B);
+	application.setQuotientKeys(quotientKeys);
+	application.setPrefilter(prefilter);
+	application.process();
+
+	const std::map<std::string, uint64> expected = countReads(reads, k);
+	uint64 missing = 0, surplus = 0, wrong = 0, maxCount = 0;
+	for(const auto &e : expected) {
+		maxCount = std::max(maxCount, e.second);
+		const auto it = counted.find(e.first);
+		if(it == counted.end())
+			++missing;
+		else if(it->second != e.second)
+			++wrong;
+	}
+	for(const auto &c : counted)
+		surplus += !expected.count(c.first);
+
+	const bool ok = !missing && !surplus && !wrong && !duplicates;
+	printf("%s k=%u counterBytes=%u quotientKeys=%u prefilter=%u kmers=%lu maxCount=%lu missing=%lu surplus=%lu "
+	       "wrong=%lu duplicates=%lu\n", ok ? "ok" : "FAIL", k, counterSize_B, quotientKeys, prefilter,
+	       expected.size(), maxCount, missing, surplus, wrong, duplicates);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*
+ * hash_test.cpp
+ *
+ * checks the default hash policy (KMER_HASH_POLICY) and KMerHashMix on random bases and on
+ * tandem repeats whose periods divide 64 (2 % substitutions), for short and long k:
+ * uniformity of the KmerDistributer buckets (chi-square per degree of freedom and the largest
+ * bucket per mean), no two canonical k-mers with the same full hash, and for rolling policies
+ * the rolled hashes against the hashes computed from scratch;
+ * exits with 1 if a check fails
+ */
+
+#include "../../include/gerbil/KMerHash.h"
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using namespace gerbil;
+
+// buckets of the KmerDistributer
+#define HASH_TEST_BUCKETS 512
+
+// bases per input
+#define HASH_TEST_BASES 300000
+
+// bounds of the bucket uniformity (expected: 1 +- 0.06 and about 1.2 for ~1000 k-mers per bucket)
+#define HASH_TEST_MAX_CHI2_PER_DF 1.5
+#define HASH_TEST_MAX_BUCKET_PER_MEAN 1.5
+
+// random bases or tandem repeats with periods 1, 2, 4, ..., 64 and 2 % substitutions
+std::vector<uint8_t> generateBases(const uint64 &n, const bool &periodic, std::mt19937_64 &rng) {
+	std::vector<uint8_t> bases;
+	bases.reserve(n);
+	while(bases.size() < n) {
+		if(!periodic) {
+			bases.push_back(rng() & 0x3);
+			continue;
+		}
+		uint8_t unit[64];
+		const uint32 period = 1 << (rng() % 7);
+		for(uint32 i = 0; i < period; ++i)
+			unit[i] = rng() & 0x3;
+		const uint32 length = 100 + rng() % 900;
+		for(uint32 i = 0; i < length && bases.size() < n; ++i)
+			bases.push_back(rng() % 50 ? unit[i % period] : rng() & 0x3);
+	}
+	return bases;
+}
+
+// bases, 4 per byte (as in the super-mers)
+std::vector<byte> packBases(const std::vector<uint8_t> &bases, const uint32 &padding_B) {
+	std::vector<byte> bytes(bases.size() / 4 + 1 + padding_B, 0);
+	for(uint64 i = 0; i < bases.size(); ++i)
+		bytes[i >> 2] |= bases[i] << (6 - ((i & 0x3) << 1));
+	return bytes;
+}
+
+// distinct canonical k-mers of all positions
+template<unsigned K>
+std::vector<KMer<K>> getKMers(const std::vector<uint8_t> &bases) {
+	const std::vector<byte> bytes = packBases(bases, sizeof(KMer<K>));
+	std::vector<KMer<K>> kMers;
+	KMer<K> kMer, iKMer;
+	KMer<K>::set(bytes.data(), kMer, iKMer);
+	kMers.push_back(kMer.getNormalized(iKMer));
+	for(uint64 i = K; i < bases.size(); ++i) {
+		kMer.next(bases[i]);
+		iKMer.nextInv(bases[i]);
+		kMers.push_back(kMer.getNormalized(iKMer));
+	}
+	std::sort(kMers.begin(), kMers.end());
+	kMers.erase(std::unique(kMers.begin(), kMers.end(),
+			[](const KMer<K> &a, const KMer<K> &b) { return a.isEqual(b); }), kMers.end());
+	return kMers;
+}
+
+template<unsigned K, typename H>
+bool testPolicy(const std::vector<uint8_t> &bases, const std::vector<KMer<K>> &kMers, const char* input) {
+	// uniformity of the buckets
+	std::vector<uint64> buckets(HASH_TEST_BUCKETS, 0);
+	for(const KMer<K> &kMer : kMers)
+		++buckets[H::partHash(kMer) % HASH_TEST_BUCKETS];
+	const double expected = (double) kMers.size() / HASH_TEST_BUCKETS;
+	double chi2 = 0;
+	uint64 maxBucket = 0;
+	for(const uint64 &b : buckets) {
+		chi2 += (b - expected) * (b - expected) / expected;
+		maxBucket = std::max(maxBucket, b);
+	}
+	const double chi2PerDf = chi2 / (HASH_TEST_BUCKETS - 1);
+	const double maxBucketPerMean = maxBucket / expected;
+
+	// collisions of the full hashes
+	std::unordered_set<uint64> hashes;
+	hashes.reserve(kMers.size());
+	for(const KMer<K> &kMer : kMers)
+		hashes.insert(H::hash(kMer));
+	const uint64 collisions = kMers.size() - hashes.size();
+
+	// rolled hashes (as the splitter) against the hashes from scratch
+	uint64 mismatches = 0;
+	if(H::template isRolling<K>()) {
+		const std::vector<byte> bytes = packBases(bases, sizeof(KMer<K>));
+		KMer<K> kMer, iKMer;
+		uint64 fwd, rev;
+		KMer<K>::set(bytes.data(), kMer, iKMer);
+		H::template init<K>(bytes.data(), fwd, rev);
+		mismatches += H::hash(kMer.getNormalized(iKMer)) != H::hashOf(fwd, rev);
+		for(uint64 i = K; i < bases.size(); ++i) {
+			kMer.next(bases[i]);
+			iKMer.nextInv(bases[i]);
+			H::template roll<K>(fwd, rev, bases[i - K], bases[i]);
+			const KMer<K> &nKMer = kMer.getNormalized(iKMer);
+			mismatches += H::hash(nKMer) != H::hashOf(fwd, rev) || H::partHash(nKMer) != H::partHashOf(fwd, rev);
+		}
+	}
+
+	const bool ok = chi2PerDf <= HASH_TEST_MAX_CHI2_PER_DF && maxBucketPerMean <= HASH_TEST_MAX_BUCKET_PER_MEAN
+			&& !collisions && !mismatches;
+	printf("%s k=%u input=%s policy=%s kmers=%lu chi2/df=%.3f max/mean=%.3f collisions=%lu mismatches=%lu\n",
+	       ok ? "ok  " : "FAIL", K, input, H::getName(), kMers.size(), chi2PerDf, maxBucketPerMean, collisions,
+	       mismatches);
+	return ok;
+}
+
+template<unsigned K>
+bool testK(const std::vector<uint8_t> &bases, const char* input) {
+	const std::vector<KMer<K>> kMers = getKMers<K>(bases);
+	bool ok = testPolicy<K, KMER_HASH_POLICY>(bases, kMers, input);
+	ok &= testPolicy<K, KMerHashMix>(bases, kMers, input);
+	return ok;
+}
+
+int main() {
+	std::mt19937_64 rng(1);
+	bool ok = true;
+	for(const bool periodic : {false, true}) {
+		const std::vector<uint8_t> bases = generateBases(HASH_TEST_BASES, periodic, rng);
+		const char* input = periodic ? "periodic" : "random";
+		ok &= testK<31>(bases, input);
+		ok &= testK<63>(bases, input);
+		ok &= testK<64>(bases, input);
+		ok &= testK<65>(bases, input);
+		ok &= testK<96>(bases, input);
+		ok &= testK<128>(bases, input);
+		ok &= testK<256>(bases, input);
+	}
+	return ok ? 0 : 1;
+}